@@ -0,0 +1,277 @@
+/*
+  ==============================================================================
+
+    This file contains the allocation tracker used by the benchmarks to check
+    that processBlock never allocates or takes a lock.
+
+  ==============================================================================
+*/
+
+#include "AllocationTracker.h"
+
+#if JUCE_LINUX
+ #include <cerrno>
+ #include <dlfcn.h>
+ #include <pthread.h>
+#endif
+
+namespace
+{
+    thread_local bool isInsideRealtimeSection = false;
+
+    std::atomic<juce::int64> numAllocations { 0 };
+    std::atomic<juce::int64> numLocks { 0 };
+
+    inline void noteAllocation() noexcept
+    {
+        if (isInsideRealtimeSection)
+            ++numAllocations;
+    }
+}
+
+AllocationTracker::RealtimeSection::RealtimeSection() noexcept    { isInsideRealtimeSection = true; }
+AllocationTracker::RealtimeSection::~RealtimeSection() noexcept   { isInsideRealtimeSection = false; }
+
+juce::int64 AllocationTracker::getNumAllocations() noexcept  { return numAllocations.load(); }
+juce::int64 AllocationTracker::getNumLocks() noexcept        { return numLocks.load(); }
+
+//==============================================================================
+#if JUCE_LINUX
+
+namespace
+{
+    inline void noteLock() noexcept
+    {
+        if (isInsideRealtimeSection)
+            ++numLocks;
+    }
+
+    // Finds the real pthread function behind one of ours. Looked up by hand
+    // and cached in an atomic rather than a function-local static, whose
+    // initialisation guard could end up back in here.
+    template <typename Function>
+    Function getRealFunction(std::atomic<Function>& realFunction, const char* name) noexcept
+    {
+        auto function = realFunction.load();
+
+        if (function == nullptr)
+        {
+            function = reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+            realFunction = function;
+        }
+
+        return function;
+    }
+}
+
+// glibc lets a program replace malloc by defining these itself. They forward
+// to glibc's own implementation, and operator new goes through malloc too,
+// or through aligned_alloc or posix_memalign for over-aligned types.
+extern "C"
+{
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void* __libc_memalign(size_t, size_t);
+    void* __libc_valloc(size_t);
+    void* __libc_pvalloc(size_t);
+    void __libc_free(void*);
+
+    void* malloc(size_t size)
+    {
+        noteAllocation();
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t numElements, size_t size)
+    {
+        noteAllocation();
+        return __libc_calloc(numElements, size);
+    }
+
+    void* realloc(void* pointer, size_t size)
+    {
+        noteAllocation();
+        return __libc_realloc(pointer, size);
+    }
+
+    void* memalign(size_t alignment, size_t size)
+    {
+        noteAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size)
+    {
+        noteAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** pointer, size_t alignment, size_t size)
+    {
+        noteAllocation();
+
+        // The alignment has to be a power of two multiple of sizeof (void*)
+        if (alignment == 0 || alignment % sizeof(void*) != 0 || ! juce::isPowerOfTwo(alignment / sizeof(void*)))
+            return EINVAL;
+
+        auto* memory = __libc_memalign(alignment, size);
+
+        if (memory == nullptr)
+            return ENOMEM;
+
+        *pointer = memory;
+        return 0;
+    }
+
+    void* valloc(size_t size)
+    {
+        noteAllocation();
+        return __libc_valloc(size);
+    }
+
+    void* pvalloc(size_t size)
+    {
+        noteAllocation();
+        return __libc_pvalloc(size);
+    }
+
+    void free(void* pointer)
+    {
+        __libc_free(pointer);
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex)
+    {
+        static std::atomic<int (*)(pthread_mutex_t*)> realFunction { nullptr };
+        noteLock();
+        return getRealFunction(realFunction, "pthread_mutex_lock")(mutex);
+    }
+
+    int pthread_mutex_trylock(pthread_mutex_t* mutex)
+    {
+        static std::atomic<int (*)(pthread_mutex_t*)> realFunction { nullptr };
+        noteLock();
+        return getRealFunction(realFunction, "pthread_mutex_trylock")(mutex);
+    }
+
+    int pthread_mutex_timedlock(pthread_mutex_t* mutex, const struct timespec* timeout)
+    {
+        static std::atomic<int (*)(pthread_mutex_t*, const struct timespec*)> realFunction { nullptr };
+        noteLock();
+        return getRealFunction(realFunction, "pthread_mutex_timedlock")(mutex, timeout);
+    }
+
+    int pthread_rwlock_rdlock(pthread_rwlock_t* lock)
+    {
+        static std::atomic<int (*)(pthread_rwlock_t*)> realFunction { nullptr };
+        noteLock();
+        return getRealFunction(realFunction, "pthread_rwlock_rdlock")(lock);
+    }
+
+    int pthread_rwlock_wrlock(pthread_rwlock_t* lock)
+    {
+        static std::atomic<int (*)(pthread_rwlock_t*)> realFunction { nullptr };
+        noteLock();
+        return getRealFunction(realFunction, "pthread_rwlock_wrlock")(lock);
+    }
+
+    int pthread_rwlock_tryrdlock(pthread_rwlock_t* lock)
+    {
+        static std::atomic<int (*)(pthread_rwlock_t*)> realFunction { nullptr };
+        noteLock();
+        return getRealFunction(realFunction, "pthread_rwlock_tryrdlock")(lock);
+    }
+
+    int pthread_rwlock_trywrlock(pthread_rwlock_t* lock)
+    {
+        static std::atomic<int (*)(pthread_rwlock_t*)> realFunction { nullptr };
+        noteLock();
+        return getRealFunction(realFunction, "pthread_rwlock_trywrlock")(lock);
+    }
+
+    int pthread_rwlock_timedrdlock(pthread_rwlock_t* lock, const struct timespec* timeout)
+    {
+        static std::atomic<int (*)(pthread_rwlock_t*, const struct timespec*)> realFunction { nullptr };
+        noteLock();
+        return getRealFunction(realFunction, "pthread_rwlock_timedrdlock")(lock, timeout);
+    }
+
+    int pthread_rwlock_timedwrlock(pthread_rwlock_t* lock, const struct timespec* timeout)
+    {
+        static std::atomic<int (*)(pthread_rwlock_t*, const struct timespec*)> realFunction { nullptr };
+        noteLock();
+        return getRealFunction(realFunction, "pthread_rwlock_timedwrlock")(lock, timeout);
+    }
+
+    // Signalling doesn't block, but it can still go into the kernel to wake
+    // a waiter, so it counts too
+    int pthread_cond_wait(pthread_cond_t* condition, pthread_mutex_t* mutex)
+    {
+        static std::atomic<int (*)(pthread_cond_t*, pthread_mutex_t*)> realFunction { nullptr };
+        noteLock();
+        return getRealFunction(realFunction, "pthread_cond_wait")(condition, mutex);
+    }
+
+    int pthread_cond_timedwait(pthread_cond_t* condition, pthread_mutex_t* mutex, const struct timespec* timeout)
+    {
+        static std::atomic<int (*)(pthread_cond_t*, pthread_mutex_t*, const struct timespec*)> realFunction { nullptr };
+        noteLock();
+        return getRealFunction(realFunction, "pthread_cond_timedwait")(condition, mutex, timeout);
+    }
+
+    int pthread_cond_signal(pthread_cond_t* condition)
+    {
+        static std::atomic<int (*)(pthread_cond_t*)> realFunction { nullptr };
+        noteLock();
+        return getRealFunction(realFunction, "pthread_cond_signal")(condition);
+    }
+
+    int pthread_cond_broadcast(pthread_cond_t* condition)
+    {
+        static std::atomic<int (*)(pthread_cond_t*)> realFunction { nullptr };
+        noteLock();
+        return getRealFunction(realFunction, "pthread_cond_broadcast")(condition);
+    }
+}
+
+bool AllocationTracker::canTrackLocks() noexcept  { return true; }
+
+#else
+
+void* operator new(std::size_t size)
+{
+    noteAllocation();
+
+    if (auto* pointer = std::malloc(size == 0 ? 1 : size))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    noteAllocation();
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void* pointer) noexcept                            { std::free(pointer); }
+void operator delete[](void* pointer) noexcept                          { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept               { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept             { std::free(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept     { std::free(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept   { std::free(pointer); }
+
+bool AllocationTracker::canTrackLocks() noexcept  { return false; }
+
+#endif
@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    This file contains the allocation tracker used by the benchmarks to check
+    that processBlock never allocates or takes a lock.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Counts heap allocations and mutex locks made on the current thread while
+    a RealtimeSection is alive.
+
+    On Linux these calls are intercepted:
+
+      - allocations: malloc, calloc, realloc, memalign, aligned_alloc,
+        posix_memalign, valloc and pvalloc. Every operator new goes through
+        one of these, including the aligned ones used for over-aligned
+        types such as SIMDRegister members, and so do juce::HeapBlock and
+        std::vector.
+      - locks: pthread_mutex_lock, pthread_mutex_trylock,
+        pthread_mutex_timedlock, every pthread_rwlock lock and try lock
+        call, and pthread_cond_wait, pthread_cond_timedwait,
+        pthread_cond_signal and pthread_cond_broadcast. That covers
+        juce::CriticalSection, juce::ReadWriteLock, juce::WaitableEvent,
+        std::mutex and std::condition_variable.
+
+    Anything that calls into the kernel directly, such as a raw futex or a
+    spin lock on an atomic, isn't seen. Elsewhere only the plain and
+    nothrow forms of operator new and operator new[] are intercepted, and
+    locks aren't counted.
+*/
+namespace AllocationTracker
+{
+    // While one of these exists, allocations and locks on this thread count
+    // as violations
+    struct RealtimeSection
+    {
+        RealtimeSection() noexcept;
+        ~RealtimeSection() noexcept;
+
+        JUCE_DECLARE_NON_COPYABLE (RealtimeSection)
+    };
+
+    juce::int64 getNumAllocations() noexcept;
+    juce::int64 getNumLocks() noexcept;
+
+    // True if locks can be tracked on this platform
+    bool canTrackLocks() noexcept;
+}
@@ -0,0 +1,277 @@
+/*
+  ==============================================================================
+
+    This file contains the batch renderer. It streams audio files through
+    SimpleEQAudioProcessor on a pool of worker threads.
+
+  ==============================================================================
+*/
+
+#include "BatchRenderer.h"
+#include "../../Source/PluginState.h"
+
+//==============================================================================
+// A render thread with its own processor. The processor is created and set
+// up on the thread that makes the worker, so the parameter state is loaded
+// on the message thread like it would be in a host.
+class BatchRenderer::Worker  : public juce::Thread
+{
+public:
+    Worker(BatchRenderer& r, const juce::Array<juce::File>& files, std::vector<RenderResult>& res,
+           std::atomic<int>& next, std::function<void(const RenderResult&)>& finished)
+        : juce::Thread("SimpleEQ Render Worker"),
+          renderer(r), inputs(files), results(res), nextInput(next), onFileFinished(finished)
+    {
+        settingsError = applySettings(processor, renderer.options);
+        processor.setFilterEngine(renderer.options.filterEngine);
+        processor.setParameterSmoothing(renderer.options.smoothingInterval > 0, renderer.options.smoothingInterval);
+        processor.setCoefficientCacheFillMode(renderer.options.precomputeCutCoefficients ? CoefficientCache::FillMode::precompute
+                                                                                         : CoefficientCache::FillMode::lazy);
+    }
+
+    ~Worker() override
+    {
+        stopThread(10000);
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            auto index = nextInput++;
+
+            if (index >= inputs.size())
+                break;
+
+            auto result = settingsError.isEmpty() ? renderer.renderFile(processor, inputs.getReference(index))
+                                                  : RenderResult { inputs.getReference(index), {}, settingsError };
+
+            results[(size_t) index] = result;
+
+            if (onFileFinished)
+                onFileFinished(result);
+        }
+    }
+
+    CoefficientCache::Statistics getCoefficientCacheStatistics() const  { return processor.getCoefficientCacheStatistics(); }
+
+private:
+    BatchRenderer& renderer;
+    const juce::Array<juce::File>& inputs;
+    std::vector<RenderResult>& results;
+    std::atomic<int>& nextInput;
+    std::function<void(const RenderResult&)>& onFileFinished;
+
+    SimpleEQAudioProcessor processor;
+    juce::String settingsError;
+};
+
+//==============================================================================
+BatchRenderer::BatchRenderer(const RenderOptions& o)
+    : options(o)
+{
+    formatManager.registerBasicFormats();
+}
+
+juce::String BatchRenderer::applySettings(SimpleEQAudioProcessor& processor, const RenderOptions& options)
+{
+    auto& ap_tree_state = processor.ap_tree_state;
+
+    // Start from the defaults, so applying the same options always ends up
+    // with the same settings whatever the processor had before
+    for (auto* parameter : processor.getParameters())
+        parameter->setValueNotifyingHost(parameter->getDefaultValue());
+
+    if (options.stateFile != juce::File())
+    {
+        // Either the plugin's binary state or the parameters as XML
+        juce::MemoryBlock stateData;
+        int program = 0;
+
+        if (! options.stateFile.loadFileAsData(stateData)
+             || ! PluginState::read(stateData.getData(), (int) stateData.getSize(), ap_tree_state, program))
+            return "Couldn't read a SimpleEQ state from " + options.stateFile.getFullPathName();
+    }
+
+    for (auto& parameterValue : options.parameterValues)
+    {
+        auto* parameter = ap_tree_state.getParameter(parameterValue.name.toString());
+
+        if (parameter == nullptr)
+            return "Unknown parameter " + parameterValue.name.toString();
+
+        parameter->setValueNotifyingHost(parameter->convertTo0to1((float) parameterValue.value));
+    }
+
+    return {};
+}
+
+std::vector<RenderResult> BatchRenderer::render(const juce::Array<juce::File>& inputs,
+                                                std::function<void(const RenderResult&)> onFileFinished)
+{
+    std::vector<RenderResult> results((size_t) inputs.size());
+    std::atomic<int> nextInput { 0 };
+
+    juce::OwnedArray<Worker> workers;
+    auto numWorkers = juce::jlimit(1, juce::jmax(1, inputs.size()), options.numThreads);
+
+    for (int i = 0; i < numWorkers; ++i)
+        workers.add(new Worker(*this, inputs, results, nextInput, onFileFinished));
+
+    for (auto* worker : workers)
+        worker->startThread();
+
+    for (auto* worker : workers)
+        worker->waitForThreadToExit(-1);
+
+    cacheStatistics = workers.getFirst()->getCoefficientCacheStatistics();
+
+    return results;
+}
+
+RenderResult BatchRenderer::renderFile(SimpleEQAudioProcessor& processor, const juce::File& input)
+{
+    RenderResult result;
+    result.input = input;
+    result.output = options.outputDirectory.getChildFile(input.getFileName());
+
+    if (result.output == input)
+    {
+        result.error = "Output would overwrite the input";
+        return result;
+    }
+
+    auto* format = formatManager.findFormatForFileExtension(input.getFileExtension());
+
+    if (format == nullptr)
+    {
+        result.error = "Unsupported file type";
+        return result;
+    }
+
+    // Memory-map the input if we can, otherwise read it through a stream a
+    // block at a time
+    std::unique_ptr<juce::AudioFormatReader> reader;
+
+    if (std::unique_ptr<juce::MemoryMappedAudioFormatReader> mappedReader { format->createMemoryMappedReader(input) })
+        if (mappedReader->mapEntireFile())
+            reader = std::move(mappedReader);
+
+    if (reader == nullptr)
+        if (auto stream = input.createInputStream())
+            reader.reset(format->createReaderFor(stream.release(), true));
+
+    if (reader == nullptr)
+    {
+        result.error = "Couldn't open the file";
+        return result;
+    }
+
+    auto numChannels = (int) reader->numChannels;
+    auto sampleRate = reader->sampleRate;
+
+    // Match the processor's layout to the file. There's nothing to feed the
+    // sidechain from, so it's off and the peak's dynamics hear the input.
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+    layout.inputBuses.add(juce::AudioChannelSet::disabled());
+    layout.outputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+
+    if (! processor.setBusesLayout(layout))
+    {
+        result.error = "Unsupported channel count " + juce::String(numChannels);
+        return result;
+    }
+
+    // Fit the bands to the reference for this file. The fit starts from the
+    // processor's settings, so put back the ones from the options first, or
+    // it would start from the last file's fit and the result would depend
+    // on which files this worker happened to get. There's no message loop
+    // here, so wait for the fit and apply it directly.
+    if (options.matchReference != juce::File())
+    {
+        auto settingsError = applySettings(processor, options);
+
+        if (settingsError.isNotEmpty())
+        {
+            result.error = settingsError;
+            return result;
+        }
+
+        auto& matchEq = processor.getMatchEq();
+
+        if (matchEq.start(options.matchReference, input))
+            matchEq.waitUntilFinished();
+
+        auto match = matchEq.getResult();
+
+        if (! match.wasSuccessful())
+        {
+            result.error = "Couldn't match: " + match.error;
+            return result;
+        }
+
+        matchEq.applyResult();
+    }
+
+    // Same format and bit depth as the input
+    result.output.deleteFile();
+    std::unique_ptr<juce::FileOutputStream> outputStream(result.output.createOutputStream());
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+
+    if (outputStream != nullptr)
+        writer.reset(format->createWriterFor(outputStream.get(), sampleRate, (unsigned int) numChannels,
+                                             (int) reader->bitsPerSample, reader->metadataValues, 0));
+
+    if (writer == nullptr)
+    {
+        result.error = "Couldn't create " + result.output.getFullPathName();
+        return result;
+    }
+
+    // The writer owns the stream now
+    outputStream.release();
+
+    auto blockSize = options.blockSize;
+    processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+    processor.prepareToPlay(sampleRate, blockSize);
+
+    juce::AudioBuffer<float> buffer(numChannels, blockSize);
+    juce::MidiBuffer midi;
+
+    // Run on past the end of the file by the latency, reading silence, and
+    // drop the same amount from the start of the output
+    auto latency = (juce::int64) processor.getLatencySamples();
+    auto numSamplesToProcess = reader->lengthInSamples + latency;
+    auto numSamplesToSkip = latency;
+
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    for (juce::int64 position = 0; position < numSamplesToProcess; position += blockSize)
+    {
+        auto numSamples = (int) juce::jmin((juce::int64) blockSize, numSamplesToProcess - position);
+
+        // Anything past the end of the file reads as silence
+        reader->read(&buffer, 0, numSamples, position, true, true);
+
+        // Hand the processor a buffer that's exactly as long as this block
+        juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), numChannels, numSamples);
+        processor.processBlock(block, midi);
+
+        auto numSkipped = (int) juce::jmin(numSamplesToSkip, (juce::int64) numSamples);
+        numSamplesToSkip -= numSkipped;
+
+        if (! writer->writeFromAudioSampleBuffer(block, numSkipped, numSamples - numSkipped))
+        {
+            result.error = "Couldn't write to " + result.output.getFullPathName();
+            break;
+        }
+    }
+
+    processor.releaseResources();
+
+    result.renderSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+    result.audioSeconds = (double) reader->lengthInSamples / sampleRate;
+
+    return result;
+}
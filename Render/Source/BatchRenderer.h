@@ -0,0 +1,101 @@
+/*
+  ==============================================================================
+
+    This file contains the batch renderer. It streams audio files through
+    SimpleEQAudioProcessor on a pool of worker threads.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+// Everything that controls a render
+struct RenderOptions
+{
+    // Where the processed files go. Each output keeps its input's file name.
+    juce::File outputDirectory;
+
+    // Optional parameter state saved from the plugin, in either the binary
+    // or the XML format. Applied before the individual parameter values below.
+    juce::File stateFile;
+
+    // Parameter values by ID, in the parameter's own units (Hz, dB, or the
+    // index for the choices). The processing options like oversampling are
+    // parameters too. Any latency they add is taken back out, so the output
+    // lines up with the input.
+    juce::NamedValueSet parameterValues;
+
+    int blockSize = 8192;
+    int numThreads = juce::SystemStats::getNumCpus();
+
+    SimpleEQAudioProcessor::FilterEngine filterEngine = SimpleEQAudioProcessor::FilterEngine::simd;
+
+    // How often the coefficients are redesigned while a parameter ramps, in
+    // samples (8 to 64), or 0 to leave smoothing off
+    int smoothingInterval = 32;
+
+    // Designs every cut filter for each rate up front rather than as the
+    // settings call for them
+    bool precomputeCutCoefficients = false;
+
+    // If set, the bands are fitted to this file's spectrum for each input
+    // before it's rendered, with the match EQ, in place of their settings
+    juce::File matchReference;
+};
+
+// What happened to one file
+struct RenderResult
+{
+    juce::File input, output;
+    juce::String error;
+
+    double audioSeconds = 0.0;
+    double renderSeconds = 0.0;
+
+    bool wasSuccessful() const noexcept  { return error.isEmpty(); }
+    double getRealTimeFactor() const noexcept { return renderSeconds > 0.0 ? audioSeconds / renderSeconds : 0.0; }
+};
+
+//==============================================================================
+/**
+    Renders a list of files through the same processor the plugin uses, so
+    the output matches what the plugin would produce with the same settings.
+
+    Each worker thread owns its own processor and takes the next file off a
+    shared counter until there are none left. Files are read in large blocks,
+    memory-mapped when the format supports it.
+*/
+class BatchRenderer
+{
+public:
+    explicit BatchRenderer(const RenderOptions& options);
+
+    // Renders every file and blocks until they're all done. The results are
+    // in the same order as the inputs. onFileFinished is called from the
+    // worker threads as each file completes.
+    std::vector<RenderResult> render(const juce::Array<juce::File>& inputs,
+                                     std::function<void(const RenderResult&)> onFileFinished = {});
+
+    // Puts every parameter back to its default, then applies the options'
+    // state file and parameter values to a processor. Returns an error
+    // message, or an empty string if it worked.
+    static juce::String applySettings(SimpleEQAudioProcessor& processor, const RenderOptions& options);
+
+    // The cut filter cache as the last render left it, taken before its
+    // workers let go of their tables
+    const CoefficientCache::Statistics& getCoefficientCacheStatistics() const noexcept  { return cacheStatistics; }
+
+private:
+    class Worker;
+
+    RenderResult renderFile(SimpleEQAudioProcessor& processor, const juce::File& input);
+
+    RenderOptions options;
+    juce::AudioFormatManager formatManager;
+    CoefficientCache::Statistics cacheStatistics;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BatchRenderer)
+};
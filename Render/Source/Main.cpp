@@ -0,0 +1,266 @@
+/*
+  ==============================================================================
+
+    This file contains the startup code for the SimpleEQ batch renderer, a
+    command line tool that runs audio files through the SimpleEQ processor.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "BatchRenderer.h"
+#include "ProcessBlockBenchmark.h"
+
+namespace
+{
+    const char* usage =
+        "Usage: SimpleEQRender --output=<dir> [options] <files or folders...>\n"
+        "\n"
+        "Runs WAV and AIFF files through the SimpleEQ processor.\n"
+        "\n"
+        "Options:\n"
+        "  --state=<file>            plugin state, binary or XML\n"
+        "  --low-cut-freq=<Hz>\n"
+        "  --low-cut-slope=<12|24|36|48>\n"
+        "  --peak-freq=<Hz>\n"
+        "  --peak-gain=<dB>\n"
+        "  --peak-q=<Q>\n"
+        "  --high-cut-freq=<Hz>\n"
+        "  --high-cut-slope=<12|24|36|48>\n"
+        "  --peak-dynamics=<0|1>     peak gain follows the level in the band\n"
+        "  --peak-threshold=<dB>\n"
+        "  --peak-ratio=<ratio>\n"
+        "  --peak-attack=<ms>\n"
+        "  --peak-release=<ms>\n"
+        "  --mid-side=<0|1>          filter mid and side, the bands above on mid\n"
+        "  --side-low-cut-freq=<Hz>\n"
+        "  --side-low-cut-slope=<12|24|36|48>\n"
+        "  --side-peak-freq=<Hz>\n"
+        "  --side-peak-gain=<dB>\n"
+        "  --side-peak-q=<Q>\n"
+        "  --side-high-cut-freq=<Hz>\n"
+        "  --side-high-cut-slope=<12|24|36|48>\n"
+        "  --block-size=<samples>    default 8192\n"
+        "  --threads=<count>         default is one per CPU\n"
+        "  --engine=<simd|mono|bands|cascade>\n"
+        "                            filter engine, default simd\n"
+        "  --topology=<tdf|svf>      direct form or state variable biquads\n"
+        "  --oversampling=<1|2|4>    default 1\n"
+        "  --linear-phase[=<size>]   linear phase FIR, default kernel 8192\n"
+        "  --precompute-cuts         design every cut filter up front\n"
+        "  --smoothing-interval=<samples>\n"
+        "                            8 to 64, or 0 for no smoothing, default 32\n"
+        "  --match=<file>            fit the bands to this reference for each\n"
+        "                            file, replacing the band settings\n"
+        "\n"
+        "Usage: SimpleEQRender --benchmark[=<results.json>] [options]\n"
+        "\n"
+        "Times processBlock across block sizes, sample rates and settings and\n"
+        "writes the results as JSON (to stdout if no file is given).\n"
+        "\n"
+        "Options:\n"
+        "  --seconds-per-case=<s>    audio timed per case, default 0.25\n"
+        "  --channels=<count>        default 2\n"
+        "  --precompute-cuts         design every cut filter up front\n"
+        "  --check-allocations       fail if processBlock allocates or locks\n";
+
+    // Command line option names for each parameter
+    const std::array<std::pair<const char*, const std::string*>, 20> parameterOptions {{
+        { "--low-cut-freq", &LOW_CUT_FREQ },
+        { "--low-cut-slope", &LOW_CUT_SLOPE },
+        { "--peak-freq", &PEAK_FREQ },
+        { "--peak-gain", &PEAK_GAIN },
+        { "--peak-q", &PEAK_Q },
+        { "--high-cut-freq", &HIGH_CUT_FREQ },
+        { "--high-cut-slope", &HIGH_CUT_SLOPE },
+        { "--peak-dynamics", &DYNAMIC_ON },
+        { "--peak-threshold", &DYNAMIC_THRESHOLD },
+        { "--peak-ratio", &DYNAMIC_RATIO },
+        { "--peak-attack", &DYNAMIC_ATTACK },
+        { "--peak-release", &DYNAMIC_RELEASE },
+        { "--mid-side", &MID_SIDE },
+        { "--side-low-cut-freq", &SIDE_LOW_CUT_FREQ },
+        { "--side-low-cut-slope", &SIDE_LOW_CUT_SLOPE },
+        { "--side-peak-freq", &SIDE_PEAK_FREQ },
+        { "--side-peak-gain", &SIDE_PEAK_GAIN },
+        { "--side-peak-q", &SIDE_PEAK_Q },
+        { "--side-high-cut-freq", &SIDE_HIGH_CUT_FREQ },
+        { "--side-high-cut-slope", &SIDE_HIGH_CUT_SLOPE }
+    }};
+
+    bool isSlopeOption(const juce::String& option)
+    {
+        return option.endsWith("-slope");
+    }
+
+    int runBenchmark(const juce::ArgumentList& args)
+    {
+        ProcessBlockBenchmark::Options options;
+
+        if (args.containsOption("--seconds-per-case"))
+            options.secondsPerCase = juce::jmax(0.001, args.getValueForOption("--seconds-per-case").getDoubleValue());
+
+        if (args.containsOption("--channels"))
+            options.numChannels = juce::jmax(1, args.getValueForOption("--channels").getIntValue());
+
+        options.precomputeCutCoefficients = args.containsOption("--precompute-cuts");
+
+        ProcessBlockBenchmark benchmark(options);
+        auto json = juce::JSON::toString(benchmark.run());
+
+        auto outputPath = args.getValueForOption("--benchmark");
+
+        if (outputPath.isEmpty())
+            std::cout << json << "\n";
+        else if (! args.getFileForOption("--benchmark").replaceWithText(json))
+            std::cerr << "Couldn't write " << outputPath << "\n";
+
+        if (args.containsOption("--check-allocations")
+             && (benchmark.getTotalAllocations() > 0 || benchmark.getTotalLocks() > 0))
+        {
+            std::cerr << "processBlock made " << benchmark.getTotalAllocations() << " allocations and "
+                      << benchmark.getTotalLocks() << " locks\n";
+            return 1;
+        }
+
+        return 0;
+    }
+
+    void addAudioFiles(const juce::File& fileOrFolder, juce::Array<juce::File>& files)
+    {
+        if (fileOrFolder.isDirectory())
+            files.addArray(fileOrFolder.findChildFiles(juce::File::findFiles, true, "*.wav;*.aif;*.aiff"));
+        else
+            files.add(fileOrFolder);
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    if (args.containsOption("--benchmark"))
+        return runBenchmark(args);
+
+    RenderOptions options;
+    juce::Array<juce::File> inputs;
+
+    if (args.containsOption("--output"))
+        options.outputDirectory = args.getFileForOption("--output");
+
+    if (args.containsOption("--state"))
+        options.stateFile = args.getFileForOption("--state");
+
+    if (args.containsOption("--block-size"))
+        options.blockSize = juce::jmax(1, args.getValueForOption("--block-size").getIntValue());
+
+    if (args.containsOption("--threads"))
+        options.numThreads = juce::jmax(1, args.getValueForOption("--threads").getIntValue());
+
+    if (args.getValueForOption("--engine") == "mono")
+        options.filterEngine = SimpleEQAudioProcessor::FilterEngine::monoChains;
+    else if (args.getValueForOption("--engine") == "bands")
+        options.filterEngine = SimpleEQAudioProcessor::FilterEngine::bandArray;
+    else if (args.getValueForOption("--engine") == "cascade")
+        options.filterEngine = SimpleEQAudioProcessor::FilterEngine::cascade;
+
+    if (args.containsOption("--topology"))
+        options.parameterValues.set(juce::Identifier(juce::String(FILTER_TOPOLOGY)),
+                                    args.getValueForOption("--topology") == "svf" ? 1.f : 0.f);
+
+    // The oversampling parameter's choices are off, 2x and 4x
+    if (args.containsOption("--oversampling"))
+    {
+        auto factor = args.getValueForOption("--oversampling").getIntValue();
+        options.parameterValues.set(juce::Identifier(juce::String(OVERSAMPLING)),
+                                    factor >= 4 ? 2.f : (factor >= 2 ? 1.f : 0.f));
+    }
+
+    if (args.containsOption("--linear-phase"))
+    {
+        auto kernelSize = args.getValueForOption("--linear-phase").getIntValue();
+
+        if (kernelSize <= 0)
+            kernelSize = LinearPhaseEngine::defaultKernelSize;
+
+        options.parameterValues.set(juce::Identifier(juce::String(LINEAR_PHASE)), 1.f);
+        options.parameterValues.set(juce::Identifier(juce::String(KERNEL_SIZE)),
+                                    (float) LinearPhaseEngine::getChoiceForKernelSize(kernelSize));
+    }
+
+    options.precomputeCutCoefficients = args.containsOption("--precompute-cuts");
+
+    if (args.containsOption("--smoothing-interval"))
+        options.smoothingInterval = juce::jmax(0, args.getValueForOption("--smoothing-interval").getIntValue());
+
+    if (args.containsOption("--match"))
+        options.matchReference = args.getFileForOption("--match");
+
+    for (auto& option : parameterOptions)
+    {
+        if (! args.containsOption(option.first))
+            continue;
+
+        auto value = args.getValueForOption(option.first).getFloatValue();
+
+        // Slopes are given in db/oct, but the parameter is the choice index
+        if (isSlopeOption(option.first))
+            value = (float) juce::jlimit(0, 3, juce::roundToInt(value / 12.f) - 1);
+
+        options.parameterValues.set(juce::Identifier(juce::String(*option.second)), value);
+    }
+
+    for (auto& argument : args.arguments)
+        if (! argument.isOption())
+            addAudioFiles(argument.resolveAsFile(), inputs);
+
+    if (options.outputDirectory == juce::File() || inputs.isEmpty())
+    {
+        std::cout << usage;
+        return 1;
+    }
+
+    if (! options.outputDirectory.createDirectory())
+    {
+        std::cerr << "Couldn't create " << options.outputDirectory.getFullPathName() << "\n";
+        return 1;
+    }
+
+    BatchRenderer renderer(options);
+    juce::CriticalSection outputLock;
+
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    auto results = renderer.render(inputs, [&outputLock](const RenderResult& result)
+    {
+        const juce::ScopedLock sl(outputLock);
+
+        if (result.wasSuccessful())
+            std::cout << result.input.getFileName() << ": " << juce::String(result.getRealTimeFactor(), 1) << "x real-time\n";
+        else
+            std::cerr << result.input.getFileName() << ": " << result.error << "\n";
+    });
+
+    auto wallSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+    double totalAudioSeconds = 0.0;
+    int numFailed = 0;
+
+    for (auto& result : results)
+    {
+        totalAudioSeconds += result.audioSeconds;
+
+        if (! result.wasSuccessful())
+            ++numFailed;
+    }
+
+    std::cout << "Rendered " << (int) results.size() - numFailed << " of " << (int) results.size() << " files, "
+              << juce::String(totalAudioSeconds, 1) << " s of audio in " << juce::String(wallSeconds, 2) << " s ("
+              << juce::String(wallSeconds > 0.0 ? totalAudioSeconds / wallSeconds : 0.0, 1) << "x real-time)\n"
+              << "Coefficient cache: " << renderer.getCoefficientCacheStatistics().toString() << "\n";
+
+    return numFailed == 0 ? 0 : 1;
+}
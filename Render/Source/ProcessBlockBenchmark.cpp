@@ -0,0 +1,680 @@
+/*
+  ==============================================================================
+
+    This file contains the processBlock benchmarks. They time the processor
+    headlessly across block sizes, sample rates and settings, and write the
+    results out as JSON so releases can be compared.
+
+  ==============================================================================
+*/
+
+#include "ProcessBlockBenchmark.h"
+#include "AllocationTracker.h"
+
+namespace
+{
+    const std::array<int, 9> blockSizes { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    const std::array<double, 4> sampleRates { 44100.0, 48000.0, 96000.0, 192000.0 };
+    const std::array<float, 2> peakGains { 0.f, 6.f };
+    const std::array<int, 3> responseCurvePoints { 256, 512, 2048 };
+    const std::array<int, 4> activeExtraBandCounts { 0, 5, 13, numExtraBands };
+
+    // Whether the peak is parked at its neutral setting in the elision
+    // cases. The cuts are never neutral, so they always run.
+    struct NeutralBands
+    {
+        const char* name;
+        bool peak;
+    };
+
+    const std::array<NeutralBands, 2> neutralBandSets {{
+        { "none",    false },
+        { "peak",    true }
+    }};
+
+    const char* getEngineName(SimpleEQAudioProcessor::FilterEngine engine)
+    {
+        switch (engine)
+        {
+            case SimpleEQAudioProcessor::FilterEngine::simd:        return "simd";
+            case SimpleEQAudioProcessor::FilterEngine::bandArray:   return "bandArray";
+            case SimpleEQAudioProcessor::FilterEngine::cascade:     return "cascade";
+            case SimpleEQAudioProcessor::FilterEngine::monoChains:  break;
+        }
+
+        return "mono";
+    }
+
+    const char* getTopologyName(FilterTopology topology)
+    {
+        return topology == FilterTopology::stateVariable ? "stateVariable" : "transposedDirectForm";
+    }
+
+    int getSlopeInDbPerOctave(Slope slope)
+    {
+        return (static_cast<int>(slope) + 1) * 12;
+    }
+}
+
+ProcessBlockBenchmark::ProcessBlockBenchmark(const Options& o)
+    : options(o)
+{
+}
+
+void ProcessBlockBenchmark::setParameter(SimpleEQAudioProcessor& processor, const std::string& parameterID, float value)
+{
+    if (auto* parameter = processor.ap_tree_state.getParameter(juce::String(parameterID)))
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+juce::var ProcessBlockBenchmark::run()
+{
+    juce::Array<juce::var> cases;
+
+    for (auto engine : { SimpleEQAudioProcessor::FilterEngine::monoChains,
+                         SimpleEQAudioProcessor::FilterEngine::simd,
+                         SimpleEQAudioProcessor::FilterEngine::bandArray,
+                         SimpleEQAudioProcessor::FilterEngine::cascade })
+        for (auto blockSize : blockSizes)
+            for (auto sampleRate : sampleRates)
+                for (int lowCutSlope = Slope_12; lowCutSlope <= Slope_48; ++lowCutSlope)
+                    for (int highCutSlope = Slope_12; highCutSlope <= Slope_48; ++highCutSlope)
+                        for (auto peakGain : peakGains)
+                            for (auto changeParameters : { false, true })
+                                cases.add(runCase({ engine, blockSize, sampleRate,
+                                                    static_cast<Slope>(lowCutSlope), static_cast<Slope>(highCutSlope),
+                                                    peakGain, changeParameters }));
+
+    auto* results = new juce::DynamicObject();
+    results->setProperty("plugin", JucePlugin_Name);
+    results->setProperty("numChannels", options.numChannels);
+    results->setProperty("totalAllocations", totalAllocations);
+    results->setProperty("totalLocks", totalLocks);
+    results->setProperty("locksTracked", AllocationTracker::canTrackLocks());
+    results->setProperty("cases", cases);
+    results->setProperty("elision", runElisionCases());
+    results->setProperty("silence", runSilenceCases());
+    results->setProperty("presets", runPresetCases());
+    results->setProperty("state", runStateCases());
+    results->setProperty("responseCurve", runResponseCurveCases());
+    results->setProperty("bands", runBandCases());
+    results->setProperty("precision", runPrecisionCases());
+    results->setProperty("oversampling", runOversamplingCases());
+    results->setProperty("smoothing", runSmoothingCases());
+    results->setProperty("linearPhase", runLinearPhaseCases());
+    results->setProperty("midSide", runMidSideCases());
+    results->setProperty("cascade", runCascadeCases());
+    results->setProperty("dynamicPeak", runDynamicPeakCases());
+
+    auto* cache = new juce::DynamicObject();
+    cache->setProperty("fillMode", options.precomputeCutCoefficients ? "precompute" : "lazy");
+    cache->setProperty("hits", cacheStatistics.hits);
+    cache->setProperty("misses", cacheStatistics.misses);
+    cache->setProperty("hitRate", cacheStatistics.getHitRate());
+    cache->setProperty("maxFilledBytes", cacheStatistics.filledBytes);
+    cache->setProperty("maxReservedBytes", cacheStatistics.reservedBytes);
+    cache->setProperty("maxTables", cacheStatistics.numTables);
+    results->setProperty("coefficientCache", juce::var(cache));
+
+    return juce::var(results);
+}
+
+juce::var ProcessBlockBenchmark::runCase(const Case& benchmarkCase)
+{
+    SimpleEQAudioProcessor processor;
+    processor.setFilterEngine(benchmarkCase.engine);
+    processor.setFilterTopology(benchmarkCase.topology);
+    processor.setOversamplingFactor(benchmarkCase.oversamplingFactor);
+    processor.setLinearPhase(benchmarkCase.linearPhaseKernelSize > 0, benchmarkCase.linearPhaseKernelSize);
+    processor.setProcessingPrecision(benchmarkCase.doublePrecision ? juce::AudioProcessor::doublePrecision
+                                                                   : juce::AudioProcessor::singlePrecision);
+
+    processor.setStageElision(benchmarkCase.stageElision);
+    processor.setParameterSmoothing(benchmarkCase.smoothingInterval > 0, benchmarkCase.smoothingInterval);
+    processor.setCoefficientCacheFillMode(options.precomputeCutCoefficients ? CoefficientCache::FillMode::precompute
+                                                                            : CoefficientCache::FillMode::lazy);
+
+    setParameter(processor, LOW_CUT_FREQ, benchmarkCase.lowCutFreq);
+    setParameter(processor, LOW_CUT_SLOPE, (float) benchmarkCase.lowCutSlope);
+    setParameter(processor, HIGH_CUT_FREQ, benchmarkCase.highCutFreq);
+    setParameter(processor, HIGH_CUT_SLOPE, (float) benchmarkCase.highCutSlope);
+    setParameter(processor, PEAK_FREQ, 1000.f);
+    setParameter(processor, PEAK_GAIN, benchmarkCase.peakGain);
+    setParameter(processor, PEAK_Q, 1.f);
+
+    // The extra bands are peaks, alternately boosting and cutting
+    for (int band = 0; band < benchmarkCase.numActiveExtraBands; ++band)
+    {
+        setParameter(processor, getExtraBandParameterID(band, BAND_ON), 1.f);
+        setParameter(processor, getExtraBandParameterID(band, BAND_GAIN), (band & 1) != 0 ? -3.f : 3.f);
+    }
+
+    // The side channel's bands match the main ones' slopes, so Mid/Side
+    // runs as many biquads as stereo
+    if (benchmarkCase.midSide)
+    {
+        setParameter(processor, MID_SIDE, 1.f);
+        setParameter(processor, SIDE_LOW_CUT_FREQ, 150.f);
+        setParameter(processor, SIDE_LOW_CUT_SLOPE, (float) benchmarkCase.lowCutSlope);
+        setParameter(processor, SIDE_PEAK_FREQ, 2000.f);
+        setParameter(processor, SIDE_PEAK_GAIN, -3.f);
+        setParameter(processor, SIDE_HIGH_CUT_FREQ, 16000.f);
+        setParameter(processor, SIDE_HIGH_CUT_SLOPE, (float) benchmarkCase.highCutSlope);
+    }
+
+    // A threshold the noise is well over, so the gain keeps moving
+    if (benchmarkCase.dynamicPeak)
+    {
+        setParameter(processor, DYNAMIC_ON, 1.f);
+        setParameter(processor, DYNAMIC_THRESHOLD, -40.f);
+        setParameter(processor, DYNAMIC_RATIO, 4.f);
+        setParameter(processor, DYNAMIC_ATTACK, 5.f);
+        setParameter(processor, DYNAMIC_RELEASE, 50.f);
+        setParameter(processor, DYNAMIC_SIDECHAIN, benchmarkCase.sidechain ? 1.f : 0.f);
+    }
+
+    // The sidechain bus is off unless the case uses it. Its channels come
+    // after the main ones in the buffer.
+    auto numSidechainChannels = benchmarkCase.sidechain ? 2 : 0;
+    auto numBufferChannels = options.numChannels + numSidechainChannels;
+
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(juce::AudioChannelSet::canonicalChannelSet(options.numChannels));
+    layout.inputBuses.add(benchmarkCase.sidechain ? juce::AudioChannelSet::stereo() : juce::AudioChannelSet::disabled());
+    layout.outputBuses.add(juce::AudioChannelSet::canonicalChannelSet(options.numChannels));
+    processor.setBusesLayout(layout);
+
+    auto blockSize = benchmarkCase.blockSize;
+    processor.setRateAndBufferSizeDetails(benchmarkCase.sampleRate, blockSize);
+    processor.prepareToPlay(benchmarkCase.sampleRate, blockSize);
+
+    // White noise, copied in fresh before every block so the filters always
+    // see a realistic signal
+    juce::AudioBuffer<float> noise(numBufferChannels, blockSize);
+    juce::AudioBuffer<float> buffer(numBufferChannels, blockSize);
+    juce::MidiBuffer midi;
+    juce::Random random(1234);
+
+    if (benchmarkCase.silentInput)
+        noise.clear();
+    else
+        for (int channel = 0; channel < numBufferChannels; ++channel)
+            for (int i = 0; i < blockSize; ++i)
+                noise.setSample(channel, i, random.nextFloat() * 2.f - 1.f);
+
+    // The same noise for the double cases
+    juce::AudioBuffer<double> doubleNoise, doubleBuffer;
+
+    if (benchmarkCase.doublePrecision)
+    {
+        doubleNoise.makeCopyOf(noise);
+        doubleBuffer.setSize(numBufferChannels, blockSize);
+    }
+
+    // Copies the noise in and times processBlock on it
+    auto timeBlock = [&](auto& source, auto& destination)
+    {
+        for (int channel = 0; channel < numBufferChannels; ++channel)
+            destination.copyFrom(channel, 0, source, channel, 0, blockSize);
+
+        auto start = juce::Time::getHighResolutionTicks();
+
+        {
+            AllocationTracker::RealtimeSection realtimeSection;
+            processor.processBlock(destination, midi);
+        }
+
+        return juce::Time::getHighResolutionTicks() - start;
+    };
+
+    auto numBlocks = juce::jmax(1, (int) (benchmarkCase.sampleRate * options.secondsPerCase) / blockSize);
+    auto allocationsBefore = AllocationTracker::getNumAllocations();
+    auto locksBefore = AllocationTracker::getNumLocks();
+    juce::int64 ticks = 0;
+
+    for (int block = 0; block < numBlocks; ++block)
+    {
+        // Sweep the peak and low cut back and forth. The new coefficients are
+        // designed here, outside the timing, rather than left to the design
+        // thread, so every block picks up a change whatever the thread
+        // scheduling, and runs comparably from one run to the next.
+        if (benchmarkCase.changeParameters)
+        {
+            setParameter(processor, PEAK_FREQ, (block & 1) != 0 ? 1000.f : 1200.f);
+            setParameter(processor, LOW_CUT_FREQ, (block & 1) != 0 ? 80.f : 100.f);
+            processor.publishParameterChanges();
+        }
+
+        if (benchmarkCase.switchPresets)
+            processor.setCurrentProgram(block % processor.getNumPrograms());
+
+        ticks += benchmarkCase.doublePrecision ? timeBlock(doubleNoise, doubleBuffer)
+                                               : timeBlock(noise, buffer);
+    }
+
+    auto allocations = AllocationTracker::getNumAllocations() - allocationsBefore;
+    auto locks = AllocationTracker::getNumLocks() - locksBefore;
+    totalAllocations += allocations;
+    totalLocks += locks;
+
+    auto caseCache = processor.getCoefficientCacheStatistics();
+    cacheStatistics.hits += caseCache.hits;
+    cacheStatistics.misses += caseCache.misses;
+    cacheStatistics.filledBytes = juce::jmax(cacheStatistics.filledBytes, caseCache.filledBytes);
+    cacheStatistics.reservedBytes = juce::jmax(cacheStatistics.reservedBytes, caseCache.reservedBytes);
+    cacheStatistics.numTables = juce::jmax(cacheStatistics.numTables, caseCache.numTables);
+
+    auto seconds = juce::Time::highResolutionTicksToSeconds(ticks);
+    auto nsPerSample = seconds * 1.0e9 / ((double) numBlocks * blockSize);
+
+    auto* result = new juce::DynamicObject();
+    result->setProperty("engine", getEngineName(benchmarkCase.engine));
+    result->setProperty("blockSize", blockSize);
+    result->setProperty("sampleRate", benchmarkCase.sampleRate);
+    result->setProperty("lowCutSlope", getSlopeInDbPerOctave(benchmarkCase.lowCutSlope));
+    result->setProperty("highCutSlope", getSlopeInDbPerOctave(benchmarkCase.highCutSlope));
+    result->setProperty("peakGain", benchmarkCase.peakGain);
+    result->setProperty("parameterChanges", benchmarkCase.changeParameters);
+    result->setProperty("stageElision", benchmarkCase.stageElision);
+    result->setProperty("silentInput", benchmarkCase.silentInput);
+    result->setProperty("switchPresets", benchmarkCase.switchPresets);
+    result->setProperty("activeExtraBands", benchmarkCase.numActiveExtraBands);
+    result->setProperty("precision", benchmarkCase.doublePrecision ? "double" : "float");
+    result->setProperty("topology", getTopologyName(benchmarkCase.topology));
+    result->setProperty("oversampling", benchmarkCase.oversamplingFactor);
+    result->setProperty("smoothingInterval", benchmarkCase.smoothingInterval);
+    result->setProperty("linearPhaseKernel", benchmarkCase.linearPhaseKernelSize);
+    result->setProperty("midSide", benchmarkCase.midSide);
+    result->setProperty("dynamicPeak", benchmarkCase.dynamicPeak);
+    result->setProperty("sidechain", benchmarkCase.sidechain);
+    result->setProperty("latencySamples", processor.getLatencySamples());
+    result->setProperty("nsPerSample", nsPerSample);
+    result->setProperty("allocations", allocations);
+    result->setProperty("locks", locks);
+
+    return juce::var(result);
+}
+
+juce::Array<juce::var> ProcessBlockBenchmark::runElisionCases()
+{
+    juce::Array<juce::var> comparisons;
+
+    for (auto engine : { SimpleEQAudioProcessor::FilterEngine::monoChains, SimpleEQAudioProcessor::FilterEngine::simd })
+    {
+        for (auto& neutral : neutralBandSets)
+        {
+            Case benchmarkCase { engine, 512, 48000.0, Slope_48, Slope_48,
+                                 neutral.peak ? 0.f : 6.f, false };
+
+            benchmarkCase.stageElision = false;
+            auto withoutElision = runCase(benchmarkCase);
+
+            benchmarkCase.stageElision = true;
+            auto withElision = runCase(benchmarkCase);
+
+            double nsWithout = withoutElision["nsPerSample"];
+            double nsWith = withElision["nsPerSample"];
+
+            auto* comparison = new juce::DynamicObject();
+            comparison->setProperty("engine", getEngineName(engine));
+            comparison->setProperty("neutralBands", neutral.name);
+            comparison->setProperty("nsPerSampleWithoutElision", nsWithout);
+            comparison->setProperty("nsPerSampleWithElision", nsWith);
+            comparison->setProperty("saving", nsWithout > 0.0 ? 1.0 - nsWith / nsWithout : 0.0);
+
+            comparisons.add(juce::var(comparison));
+        }
+    }
+
+    return comparisons;
+}
+
+juce::Array<juce::var> ProcessBlockBenchmark::runSilenceCases()
+{
+    juce::Array<juce::var> silenceCases;
+
+    // The same busy settings with noise and then with silence. The silent
+    // case includes the tail before the filters go to sleep, so its time per
+    // sample keeps falling as --seconds-per-case goes up.
+    for (auto engine : { SimpleEQAudioProcessor::FilterEngine::monoChains, SimpleEQAudioProcessor::FilterEngine::simd })
+    {
+        for (auto silentInput : { false, true })
+        {
+            Case benchmarkCase { engine, 512, 48000.0, Slope_48, Slope_48, 6.f, false };
+            benchmarkCase.silentInput = silentInput;
+
+            silenceCases.add(runCase(benchmarkCase));
+        }
+    }
+
+    return silenceCases;
+}
+
+juce::Array<juce::var> ProcessBlockBenchmark::runPresetCases()
+{
+    juce::Array<juce::var> presetCases;
+
+    // A new preset every block is far more than any session would see, but
+    // it keeps a crossfade running the whole time
+    for (auto engine : { SimpleEQAudioProcessor::FilterEngine::monoChains, SimpleEQAudioProcessor::FilterEngine::simd })
+    {
+        for (auto blockSize : { 64, 512 })
+        {
+            Case benchmarkCase { engine, blockSize, 48000.0, Slope_12, Slope_12, 0.f, false };
+            benchmarkCase.switchPresets = true;
+
+            presetCases.add(runCase(benchmarkCase));
+        }
+    }
+
+    return presetCases;
+}
+
+juce::Array<juce::var> ProcessBlockBenchmark::runBandCases()
+{
+    juce::Array<juce::var> bandCases;
+
+    // Every engine with more and more of the extra bands switched on. The
+    // rest are off, so these show what each active band costs on top of
+    // the cuts and peak.
+    for (auto engine : { SimpleEQAudioProcessor::FilterEngine::monoChains,
+                         SimpleEQAudioProcessor::FilterEngine::simd,
+                         SimpleEQAudioProcessor::FilterEngine::bandArray })
+    {
+        for (auto blockSize : { 32, 512 })
+        {
+            for (auto numActiveExtraBands : activeExtraBandCounts)
+            {
+                Case benchmarkCase { engine, blockSize, 48000.0, Slope_24, Slope_24, 3.f, false };
+                benchmarkCase.numActiveExtraBands = numActiveExtraBands;
+
+                bandCases.add(runCase(benchmarkCase));
+            }
+        }
+    }
+
+    return bandCases;
+}
+
+juce::Array<juce::var> ProcessBlockBenchmark::runPrecisionCases()
+{
+    juce::Array<juce::var> precisionCases;
+
+    // The settings that suffer most in float: a steep low cut near the bottom
+    // of the range, at a high sample rate. In float the band array runs it,
+    // so the two topologies go through the same engine; in double
+    // everything does.
+    for (auto doublePrecision : { false, true })
+    {
+        for (auto topology : { FilterTopology::transposedDirectForm, FilterTopology::stateVariable })
+        {
+            for (auto sampleRate : { 48000.0, 192000.0 })
+            {
+                for (auto blockSize : { 32, 512 })
+                {
+                    Case benchmarkCase { SimpleEQAudioProcessor::FilterEngine::bandArray, blockSize, sampleRate,
+                                         Slope_48, Slope_12, 3.f, false, 25.f };
+                    benchmarkCase.doublePrecision = doublePrecision;
+                    benchmarkCase.topology = topology;
+
+                    precisionCases.add(runCase(benchmarkCase));
+                }
+            }
+        }
+    }
+
+    return precisionCases;
+}
+
+juce::Array<juce::var> ProcessBlockBenchmark::runOversamplingCases()
+{
+    juce::Array<juce::var> oversamplingCases;
+
+    // Settings with the high cut and peak both doing something, at the
+    // rates where oversampling matters. The time per sample is per host
+    // sample, so it includes the resampling as well as running the filters
+    // on more samples.
+    for (auto oversamplingFactor : { 1, 2, 4 })
+    {
+        for (auto sampleRate : { 44100.0, 48000.0 })
+        {
+            for (auto blockSize : { 64, 512 })
+            {
+                Case benchmarkCase { SimpleEQAudioProcessor::FilterEngine::simd, blockSize, sampleRate,
+                                     Slope_24, Slope_48, 6.f, false, 80.f, 16000.f };
+                benchmarkCase.oversamplingFactor = oversamplingFactor;
+
+                oversamplingCases.add(runCase(benchmarkCase));
+            }
+        }
+    }
+
+    return oversamplingCases;
+}
+
+juce::Array<juce::var> ProcessBlockBenchmark::runSmoothingCases()
+{
+    juce::Array<juce::var> smoothingCases;
+
+    // The parameters change every block, so a ramp is always running and
+    // the coefficients are redesigned on the audio thread once per
+    // interval. 0 is smoothing off, where they only change when the engine
+    // publishes a new design.
+    for (auto smoothingInterval : { 0, 8, 16, 32, 64 })
+    {
+        for (auto blockSize : { 64, 512 })
+        {
+            Case benchmarkCase { SimpleEQAudioProcessor::FilterEngine::simd, blockSize, 48000.0,
+                                 Slope_24, Slope_24, 6.f, true };
+            benchmarkCase.smoothingInterval = smoothingInterval;
+
+            smoothingCases.add(runCase(benchmarkCase));
+        }
+    }
+
+    return smoothingCases;
+}
+
+juce::Array<juce::var> ProcessBlockBenchmark::runLinearPhaseCases()
+{
+    juce::Array<juce::var> linearPhaseCases;
+
+    // A kernel size of 0 is the IIR filters, for comparison. The
+    // convolution's cost hardly depends on the settings, so one set does.
+    for (auto kernelSize : { 0, 2048, 8192, 32768 })
+    {
+        for (auto blockSize : { 64, 512 })
+        {
+            Case benchmarkCase { SimpleEQAudioProcessor::FilterEngine::simd, blockSize, 48000.0,
+                                 Slope_24, Slope_24, 6.f, false };
+            benchmarkCase.linearPhaseKernelSize = kernelSize;
+
+            auto result = runCase(benchmarkCase);
+
+            // The convolution runs each channel on its own, so this is the
+            // figure to compare across channel counts
+            if (auto* object = result.getDynamicObject())
+                object->setProperty("nsPerChannelSample", (double) result["nsPerSample"] / options.numChannels);
+
+            linearPhaseCases.add(result);
+        }
+    }
+
+    return linearPhaseCases;
+}
+
+juce::Array<juce::var> ProcessBlockBenchmark::runMidSideCases()
+{
+    juce::Array<juce::var> midSideCases;
+
+    // The mid channel gets the usual bands and the side channel a low cut
+    // and a peak of its own, so both run the same number of biquads as
+    // the stereo cases. Mid/Side always runs in the band arrays, so the
+    // stereo cases are timed with both the SIMD engine and the band array.
+    for (auto engine : { SimpleEQAudioProcessor::FilterEngine::simd, SimpleEQAudioProcessor::FilterEngine::bandArray })
+    {
+        for (auto midSide : { false, true })
+        {
+            for (auto blockSize : { 64, 512 })
+            {
+                Case benchmarkCase { engine, blockSize, 48000.0, Slope_24, Slope_24, 6.f, false, 80.f, 12000.f };
+                benchmarkCase.midSide = midSide;
+
+                midSideCases.add(runCase(benchmarkCase));
+            }
+        }
+    }
+
+    return midSideCases;
+}
+
+juce::Array<juce::var> ProcessBlockBenchmark::runCascadeCases()
+{
+    juce::Array<juce::var> cascadeCases;
+
+    // The shallowest and steepest slopes, three and nine biquads with the
+    // peak, on blocks from L1 sized up to well past it
+    for (auto slope : { Slope_12, Slope_48 })
+    {
+        for (auto blockSize : { 1024, 4096, 16384 })
+        {
+            Case benchmarkCase { SimpleEQAudioProcessor::FilterEngine::monoChains, blockSize, 48000.0, slope, slope, 6.f, false };
+            auto monoChains = runCase(benchmarkCase);
+
+            benchmarkCase.engine = SimpleEQAudioProcessor::FilterEngine::cascade;
+            auto cascade = runCase(benchmarkCase);
+
+            auto cascadeNs = (double) cascade["nsPerSample"];
+
+            if (auto* object = cascade.getDynamicObject())
+                object->setProperty("speedupOverMonoChains", cascadeNs > 0.0 ? (double) monoChains["nsPerSample"] / cascadeNs : 0.0);
+
+            cascadeCases.add(monoChains);
+            cascadeCases.add(cascade);
+        }
+    }
+
+    return cascadeCases;
+}
+
+juce::Array<juce::var> ProcessBlockBenchmark::runDynamicPeakCases()
+{
+    juce::Array<juce::var> dynamicCases;
+
+    // The usual vocal track settings, with the peak left static, then with
+    // its dynamics following the input and a stereo sidechain. The
+    // overhead is what an instance on every track pays for the dynamics.
+    for (auto engine : { SimpleEQAudioProcessor::FilterEngine::simd, SimpleEQAudioProcessor::FilterEngine::bandArray })
+    {
+        for (auto blockSize : { 64, 512 })
+        {
+            Case benchmarkCase { engine, blockSize, 48000.0, Slope_24, Slope_12, 6.f, false, 80.f, 12000.f };
+            auto staticPeak = runCase(benchmarkCase);
+            auto staticNs = (double) staticPeak["nsPerSample"];
+            dynamicCases.add(staticPeak);
+
+            for (auto sidechain : { false, true })
+            {
+                benchmarkCase.dynamicPeak = true;
+                benchmarkCase.sidechain = sidechain;
+                auto dynamicPeak = runCase(benchmarkCase);
+
+                if (auto* object = dynamicPeak.getDynamicObject())
+                    object->setProperty("overheadNsPerSample", (double) dynamicPeak["nsPerSample"] - staticNs);
+
+                dynamicCases.add(dynamicPeak);
+            }
+        }
+    }
+
+    return dynamicCases;
+}
+
+juce::var ProcessBlockBenchmark::runStateCases()
+{
+    constexpr int numRepeats = 1000;
+
+    SimpleEQAudioProcessor processor;
+    setParameter(processor, LOW_CUT_FREQ, 80.f);
+    setParameter(processor, PEAK_GAIN, 3.f);
+
+    // Times numRepeats calls and returns the average in microseconds
+    auto timeMicroseconds = [](const std::function<void()>& function)
+    {
+        auto start = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < numRepeats; ++i)
+            function();
+
+        return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1.0e6 / numRepeats;
+    };
+
+    juce::MemoryBlock binaryState, xmlState;
+    processor.getStateInformation(binaryState);
+    processor.getStateInformationAsXml(xmlState);
+
+    auto* results = new juce::DynamicObject();
+    results->setProperty("binaryBytes", (int) binaryState.getSize());
+    results->setProperty("xmlBytes", (int) xmlState.getSize());
+
+    results->setProperty("binarySaveMicroseconds", timeMicroseconds([&] { processor.getStateInformation(binaryState); }));
+    results->setProperty("binaryLoadMicroseconds", timeMicroseconds([&] { processor.setStateInformation(binaryState.getData(), (int) binaryState.getSize()); }));
+    results->setProperty("xmlSaveMicroseconds", timeMicroseconds([&] { processor.getStateInformationAsXml(xmlState); }));
+    results->setProperty("xmlLoadMicroseconds", timeMicroseconds([&] { processor.setStateInformation(xmlState.getData(), (int) xmlState.getSize()); }));
+
+    return juce::var(results);
+}
+
+juce::Array<juce::var> ProcessBlockBenchmark::runResponseCurveCases()
+{
+    constexpr int numRepeats = 2000;
+
+    juce::Array<juce::var> curveCases;
+
+    SimpleEQSettings settings;
+    settings.lowCutFreq = 80.f;
+    settings.lowCutSlope = Slope_48;
+    settings.peakFreq = 750.f;
+    settings.peakGain = 3.f;
+    settings.peakQ = 1.f;
+    settings.highCutFreq = 12000.f;
+    settings.highCutSlope = Slope_48;
+
+    for (auto numPoints : responseCurvePoints)
+    {
+        ResponseCurve curve(numPoints);
+        curve.prepare(48000.0);
+        curve.updateAll(settings);
+
+        // Both runs move the peak gain every time, as dragging the gain knob
+        // would, so the only difference is how much gets recomputed
+        auto timeMicroseconds = [&](bool incremental)
+        {
+            auto start = juce::Time::getHighResolutionTicks();
+
+            for (int i = 0; i < numRepeats; ++i)
+            {
+                settings.peakGain = (i & 1) != 0 ? 3.f : 4.f;
+
+                if (incremental)
+                    curve.update(settings);
+                else
+                    curve.updateAll(settings);
+            }
+
+            return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1.0e6 / numRepeats;
+        };
+
+        auto fullMicroseconds = timeMicroseconds(false);
+        auto incrementalMicroseconds = timeMicroseconds(true);
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("numPoints", numPoints);
+        result->setProperty("fullMicroseconds", fullMicroseconds);
+        result->setProperty("incrementalMicroseconds", incrementalMicroseconds);
+        result->setProperty("speedup", incrementalMicroseconds > 0.0 ? fullMicroseconds / incrementalMicroseconds : 0.0);
+        curveCases.add(juce::var(result));
+    }
+
+    return curveCases;
+}
@@ -0,0 +1,139 @@
+/*
+  ==============================================================================
+
+    This file contains the processBlock benchmarks. They time the processor
+    headlessly across block sizes, sample rates and settings, and write the
+    results out as JSON so releases can be compared.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+//==============================================================================
+/**
+    Runs SimpleEQAudioProcessor::processBlock over every combination of:
+
+      - filter engine (MonoChain, SIMD, band array and cascade)
+      - block size, 16 to 4096
+      - sample rate, 44.1 kHz to 192 kHz
+      - low cut and high cut slope
+      - peak gain of 0 dB and +6 dB
+      - with and without parameter changes between blocks, designed
+        before each block so every block picks one up
+
+    and reports the time per sample frame (all channels together).
+
+    A second set of cases measures stage elision: the peak is parked at its
+    neutral setting and timed with elision on and off, so the results show
+    what skipping neutral bands saves. A third set feeds in
+    silence, to time an idle track once the filters have gone to sleep.
+
+    The preset cases switch program every block, which crossfades between
+    precomputed coefficient sets, and the state cases time saving and
+    loading an instance's state in the binary and XML formats. The response
+    curve cases compare recomputing the whole curve with the incremental
+    update when only the peak band moves. The band cases switch on more and
+    more of the extra bands in each engine, including the band array. The
+    precision cases run a 48 dB/oct low cut at 25 Hz in float and double,
+    with each filter topology, at 48 kHz and 192 kHz. The oversampling cases
+    time each oversampling factor at 44.1 kHz and 48 kHz, to show what the
+    extra accuracy at the top of the band costs. The smoothing cases keep
+    the parameters moving with smoothing off and at each redesign interval
+    from 8 to 64 samples. The linear phase cases
+    time a few kernel lengths against the IIR filters they replace, and the
+    Mid/Side cases time the fused Mid/Side path against plain stereo with
+    the same bands. The cascade cases compare the single pass cascade
+    engine with MonoChain on blocks of up to 16384 samples, where the
+    chain's pass per biquad has to go out to memory, and report the
+    speedup. The dynamic peak cases time the peak band with its dynamics
+    on, listening to the input and to a sidechain, against the same band
+    left static, and report what the detector and the per-interval peak
+    designs add per sample.
+
+    Every
+    processBlock call runs inside an AllocationTracker::RealtimeSection, so
+    each case also reports how many allocations and locks happened on the
+    audio thread. The results end with the cut filter cache's hit rate and
+    memory use over every case.
+*/
+class ProcessBlockBenchmark
+{
+public:
+    struct Options
+    {
+        // Seconds of audio to time for each case
+        double secondsPerCase = 0.25;
+
+        int numChannels = 2;
+
+        // Has each case design its cut filter table up front
+        bool precomputeCutCoefficients = false;
+    };
+
+    explicit ProcessBlockBenchmark(const Options& options);
+
+    // Runs every case and returns the results as a JSON object
+    juce::var run();
+
+    // Total allocations and locks seen inside processBlock over all cases
+    juce::int64 getTotalAllocations() const noexcept   { return totalAllocations; }
+    juce::int64 getTotalLocks() const noexcept         { return totalLocks; }
+
+private:
+    struct Case
+    {
+        SimpleEQAudioProcessor::FilterEngine engine;
+        int blockSize;
+        double sampleRate;
+        Slope lowCutSlope, highCutSlope;
+        float peakGain;
+        bool changeParameters;
+
+        float lowCutFreq = 80.f;
+        float highCutFreq = 12000.f;
+        bool stageElision = true;
+        bool silentInput = false;
+        bool switchPresets = false;
+        int numActiveExtraBands = 0;
+        bool doublePrecision = false;
+        FilterTopology topology = FilterTopology::transposedDirectForm;
+        int oversamplingFactor = 1;
+        int smoothingInterval = 32;
+        int linearPhaseKernelSize = 0;
+        bool midSide = false;
+        bool dynamicPeak = false;
+        bool sidechain = false;
+    };
+
+    juce::var runCase(const Case& benchmarkCase);
+    juce::Array<juce::var> runElisionCases();
+    juce::Array<juce::var> runSilenceCases();
+    juce::Array<juce::var> runPresetCases();
+    juce::Array<juce::var> runBandCases();
+    juce::Array<juce::var> runPrecisionCases();
+    juce::Array<juce::var> runOversamplingCases();
+    juce::Array<juce::var> runSmoothingCases();
+    juce::Array<juce::var> runLinearPhaseCases();
+    juce::Array<juce::var> runMidSideCases();
+    juce::Array<juce::var> runCascadeCases();
+    juce::Array<juce::var> runDynamicPeakCases();
+    juce::var runStateCases();
+    juce::Array<juce::var> runResponseCurveCases();
+
+    static void setParameter(SimpleEQAudioProcessor& processor, const std::string& parameterID, float value);
+
+    Options options;
+    juce::int64 totalAllocations = 0;
+    juce::int64 totalLocks = 0;
+
+    // Each case's processor has the cut filter cache's table to itself, and
+    // frees it at the end of the case, so the figures are collected case by
+    // case: the lookups summed, the memory at its largest
+    CoefficientCache::Statistics cacheStatistics;
+
+    JUCE_DECLARE_NON_COPYABLE (ProcessBlockBenchmark)
+};
@@ -0,0 +1,576 @@
+/*
+  ==============================================================================
+
+    This file contains the band array, a filter engine that runs any number
+    of bands (up to maxBands) from flat arrays of coefficients and state
+    rather than a fixed chain of filter objects.
+
+  ==============================================================================
+*/
+
+#include "BandArray.h"
+
+namespace
+{
+    template <typename SampleType>
+    using Section = std::array<SampleType, 6>;
+
+    template <typename SampleType>
+    Section<SampleType> toSection(const BasicBiquadCoefficients<SampleType>& c) noexcept
+    {
+        return { c[0], c[1], c[2], c[3], c[4], SampleType(0) };
+    }
+
+    template <typename SampleType>
+    Section<SampleType> toSection(const BiquadCoefficients& c) noexcept
+    {
+        return { (SampleType) c[0], (SampleType) c[1], (SampleType) c[2], (SampleType) c[3], (SampleType) c[4], SampleType(0) };
+    }
+
+    // g for the state variable filter, worked out in double whatever the
+    // sample type, since this is where the precision matters
+    double getWarpedFrequency(float frequency, double sampleRate) noexcept
+    {
+        return std::tan(juce::MathConstants<double>::pi * juce::jmax((double) frequency, 2.0) / sampleRate);
+    }
+
+    // A state variable section with cutoff g and damping k (1 / Q), mixing
+    // its input, band pass and low pass outputs by m0, m1 and m2
+    template <typename SampleType>
+    Section<SampleType> makeStateVariableSection(double g, double k, double m0, double m1, double m2) noexcept
+    {
+        auto a1 = 1.0 / (1.0 + g * (g + k));
+        auto a2 = g * a1;
+        auto a3 = g * a2;
+
+        return { (SampleType) a1, (SampleType) a2, (SampleType) a3, (SampleType) m0, (SampleType) m1, (SampleType) m2 };
+    }
+}
+
+template <typename SampleType>
+bool BasicBandArray<SampleType>::isActive(const BandSettings& band) noexcept
+{
+    if (! band.enabled)
+        return false;
+
+    // The same threshold the stage elider uses for the peak band
+    return band.type == BandType::notch || std::abs(band.gain) >= 0.05f;
+}
+
+template <typename SampleType>
+BasicBandArray<SampleType>::BasicBandArray()
+{
+    bandRunning.fill(true);
+}
+
+template <typename SampleType>
+void BasicBandArray<SampleType>::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = spec.sampleRate;
+    numChannels = spec.numChannels;
+    state.calloc(numChannels * maxBiquads * 2);
+
+    for (int band = 0; band < maxBands; ++band)
+        setBand(band, nullptr, 0);
+
+    packActiveBiquads();
+}
+
+template <typename SampleType>
+void BasicBandArray<SampleType>::reset() noexcept
+{
+    std::fill(state.get(), state.get() + numChannels * maxBiquads * 2, SampleType(0));
+}
+
+template <typename SampleType>
+void BasicBandArray<SampleType>::setTopology(FilterTopology newTopology) noexcept
+{
+    if (newTopology == topology)
+        return;
+
+    topology = newTopology;
+    reset();
+}
+
+template <typename SampleType>
+void BasicBandArray<SampleType>::setBand(int band, const Section* sections, int numSections) noexcept
+{
+    jassert(juce::isPositiveAndBelow(band, maxBands));
+    jassert(numSections >= 0 && numSections <= maxBiquadsPerBand);
+
+    auto firstSlot = (size_t) (band * maxBiquadsPerBand);
+
+    for (size_t i = 0; i < (size_t) numSections; ++i)
+        for (size_t c = 0; c < (size_t) numSectionCoefficients; ++c)
+            coefficients[c][firstSlot + i] = sections[i][c];
+
+    // If the band still has as many biquads, and the packed arrays are up to
+    // date, its new coefficients can go straight into them
+    if (! needsPacking && numBandBiquads[(size_t) band] == numSections)
+    {
+        if (bandRunning[(size_t) band])
+            for (size_t i = 0; i < (size_t) numSections; ++i)
+                for (size_t c = 0; c < (size_t) numSectionCoefficients; ++c)
+                    active[c][(size_t) bandStarts[(size_t) band] + i] = sections[i][c];
+
+        return;
+    }
+
+    numBandBiquads[(size_t) band] = numSections;
+    needsPacking = true;
+}
+
+template <typename SampleType>
+void BasicBandArray<SampleType>::setChainCoefficients(const ChainCoefficients& chainCoefficients) noexcept
+{
+    // These are biquad coefficients, which mean nothing to a state variable
+    // filter. Use setChainSettings for that.
+    jassert(topology == FilterTopology::transposedDirectForm);
+
+    const auto& settings = chainCoefficients.settings;
+    std::array<Section, maxBiquadsPerBand> sections;
+
+    // A slope of n uses the first (n + 1) stages of the cut filter
+    auto setCut = [this, &sections](int band, const std::array<BiquadCoefficients, 4>& cut, Slope slope)
+    {
+        for (int i = 0; i <= slope; ++i)
+            sections[(size_t) i] = toSection<SampleType>(cut[(size_t) i]);
+
+        setBand(band, sections.data(), slope + 1);
+    };
+
+    setCut(LowCutStage, chainCoefficients.lowCut, settings.lowCutSlope);
+
+    sections[0] = toSection<SampleType>(chainCoefficients.peak);
+    setBand(PeakStage, sections.data(), 1);
+
+    setCut(HighCutStage, chainCoefficients.highCut, settings.highCutSlope);
+
+    for (size_t band = 0; band < (size_t) numExtraBands; ++band)
+    {
+        sections[0] = toSection<SampleType>(chainCoefficients.extraBands[band]);
+        setBand(getExtraBandIndex((int) band), sections.data(), isActive(settings.extraBands[band]) ? 1 : 0);
+    }
+}
+
+template <typename SampleType>
+void BasicBandArray<SampleType>::setChainSettings(const SimpleEQSettings& settings) noexcept
+{
+    setCutBand(LowCutStage, CutType::lowCut, settings.lowCutFreq, settings.lowCutSlope);
+    setBandFromSettings(PeakStage, { true, BandType::peak, settings.peakFreq, settings.peakGain, settings.peakQ });
+    setCutBand(HighCutStage, CutType::highCut, settings.highCutFreq, settings.highCutSlope);
+
+    for (size_t band = 0; band < (size_t) numExtraBands; ++band)
+    {
+        if (isActive(settings.extraBands[band]))
+            setBandFromSettings(getExtraBandIndex((int) band), settings.extraBands[band]);
+        else
+            setBand(getExtraBandIndex((int) band), nullptr, 0);
+    }
+}
+
+template <typename SampleType>
+void BasicBandArray<SampleType>::setPeak(const BasicBiquadCoefficients<SampleType>& biquad, const BandSettings& settings) noexcept
+{
+    if (topology == FilterTopology::stateVariable)
+    {
+        setBandFromSettings(PeakStage, settings);
+        return;
+    }
+
+    auto section = toSection(biquad);
+    setBand(PeakStage, &section, 1);
+}
+
+template <typename SampleType>
+void BasicBandArray<SampleType>::setCutBand(int band, CutType type, float frequency, Slope slope) noexcept
+{
+    std::array<Section, maxBiquadsPerBand> sections;
+
+    if (topology == FilterTopology::stateVariable)
+    {
+        // The same Butterworth stages, taken from the high or low pass output
+        auto g = getWarpedFrequency(frequency, sampleRate);
+
+        for (int stage = 0; stage <= slope; ++stage)
+        {
+            auto k = 1.0 / getButterworthQ(slope, stage);
+
+            sections[(size_t) stage] = type == CutType::lowCut ? makeStateVariableSection<SampleType>(g, k, 1.0, -k, -1.0)
+                                                               : makeStateVariableSection<SampleType>(g, k, 0.0, 0.0, 1.0);
+        }
+    }
+    else
+    {
+        std::array<BasicBiquadCoefficients<SampleType>, 4> biquads;
+        makeCutCoefficients(type, sampleRate, (SampleType) frequency, slope, biquads);
+
+        for (int stage = 0; stage <= slope; ++stage)
+            sections[(size_t) stage] = toSection(biquads[(size_t) stage]);
+    }
+
+    setBand(band, sections.data(), slope + 1);
+}
+
+template <typename SampleType>
+void BasicBandArray<SampleType>::setBandFromSettings(int band, const BandSettings& settings) noexcept
+{
+    Section section;
+
+    if (topology == FilterTopology::stateVariable)
+    {
+        // Simper's versions of the cookbook peak, shelves and notch. They
+        // come from the same analog prototypes with the same prewarping, so
+        // the responses match the biquads.
+        auto A = std::pow(10.0, (double) settings.gain / 40.0);
+        auto g = getWarpedFrequency(settings.frequency, sampleRate);
+        auto k = 1.0 / (double) settings.Q;
+
+        switch (settings.type)
+        {
+            case BandType::peak:
+                k /= A;
+                section = makeStateVariableSection<SampleType>(g, k, 1.0, k * (A * A - 1.0), 0.0);
+                break;
+
+            case BandType::lowShelf:
+                section = makeStateVariableSection<SampleType>(g / std::sqrt(A), k, 1.0, k * (A - 1.0), A * A - 1.0);
+                break;
+
+            case BandType::highShelf:
+                section = makeStateVariableSection<SampleType>(g * std::sqrt(A), k, A * A, k * (1.0 - A) * A, 1.0 - A * A);
+                break;
+
+            case BandType::notch:
+            default:
+                section = makeStateVariableSection<SampleType>(g, k, 1.0, -k, 0.0);
+                break;
+        }
+    }
+    else
+    {
+        section = toSection(makeBandCoefficients<SampleType>(sampleRate, settings));
+    }
+
+    setBand(band, &section, 1);
+}
+
+template <typename SampleType>
+void BasicBandArray<SampleType>::setBandRunning(int band, bool shouldRun) noexcept
+{
+    jassert(juce::isPositiveAndBelow(band, maxBands));
+
+    if (bandRunning[(size_t) band] == shouldRun)
+        return;
+
+    bandRunning[(size_t) band] = shouldRun;
+    needsPacking = true;
+}
+
+template <typename SampleType>
+void BasicBandArray<SampleType>::resetBand(int band) noexcept
+{
+    jassert(juce::isPositiveAndBelow(band, maxBands));
+
+    // Clear every slot the band owns, including any it isn't using right now
+    for (size_t channel = 0; channel < numChannels; ++channel)
+    {
+        auto* bandState = state.get() + (channel * maxBiquads + (size_t) (band * maxBiquadsPerBand)) * 2;
+        std::fill(bandState, bandState + maxBiquadsPerBand * 2, SampleType(0));
+    }
+}
+
+template <typename SampleType>
+int BasicBandArray<SampleType>::getNumActiveBiquads() noexcept
+{
+    if (needsPacking)
+        packActiveBiquads();
+
+    return numActive;
+}
+
+template <typename SampleType>
+void BasicBandArray<SampleType>::packActiveBiquads() noexcept
+{
+    numActive = 0;
+
+    for (size_t band = 0; band < (size_t) maxBands; ++band)
+    {
+        bandStarts[band] = numActive;
+
+        if (! bandRunning[band])
+            continue;
+
+        for (int i = 0; i < numBandBiquads[band]; ++i)
+        {
+            auto slot = band * maxBiquadsPerBand + (size_t) i;
+            auto index = (size_t) numActive++;
+
+            for (size_t c = 0; c < (size_t) numSectionCoefficients; ++c)
+                active[c][index] = coefficients[c][slot];
+
+            activeSlots[index] = (int) slot;
+        }
+    }
+
+    bandStarts[maxBands] = numActive;
+    needsPacking = false;
+}
+
+template <typename SampleType>
+void BasicBandArray<SampleType>::processBands(const juce::dsp::AudioBlock<SampleType>& block, int firstBand, int lastBand) noexcept
+{
+    jassert(block.getNumChannels() <= numChannels);
+    jassert(0 <= firstBand && firstBand <= lastBand && lastBand <= maxBands);
+
+    if (needsPacking)
+        packActiveBiquads();
+
+    auto firstActive = bandStarts[(size_t) firstBand];
+    auto lastActive = bandStarts[(size_t) lastBand];
+
+    // Nothing to do if none of the bands are active
+    if (firstActive == lastActive)
+        return;
+
+    auto numSamples = block.getNumSamples();
+    auto numBlockChannels = juce::jmin(block.getNumChannels(), numChannels);
+
+    for (size_t channel = 0; channel < numBlockChannels; ++channel)
+    {
+        auto* samples = block.getChannelPointer(channel);
+        auto* channelState = state.get() + channel * maxBiquads * 2;
+
+        if (topology == FilterTopology::stateVariable)
+            processStateVariable(samples, numSamples, channelState, firstActive, lastActive);
+        else
+            processTransposedDirectForm(samples, numSamples, channelState, firstActive, lastActive);
+    }
+}
+
+template <typename SampleType>
+void BasicBandArray<SampleType>::processTransposedDirectForm(SampleType* samples, size_t numSamples, SampleType* channelState,
+                                                             int firstActive, int lastActive) noexcept
+{
+    // Run each active biquad over the whole block, keeping its state in
+    // locals while it does
+    for (auto i = (size_t) firstActive; i < (size_t) lastActive; ++i)
+    {
+        auto b0 = active[0][i];
+        auto b1 = active[1][i];
+        auto b2 = active[2][i];
+        auto a1 = active[3][i];
+        auto a2 = active[4][i];
+
+        auto* slotState = channelState + activeSlots[i] * 2;
+        auto s1 = slotState[0];
+        auto s2 = slotState[1];
+
+        for (size_t n = 0; n < numSamples; ++n)
+        {
+            auto input = samples[n];
+            auto output = (b0 * input) + s1;
+            s1 = (b1 * input) - (a1 * output) + s2;
+            s2 = (b2 * input) - (a2 * output);
+            samples[n] = output;
+        }
+
+        slotState[0] = s1;
+        slotState[1] = s2;
+    }
+}
+
+template <typename SampleType>
+void BasicBandArray<SampleType>::processStateVariable(SampleType* samples, size_t numSamples, SampleType* channelState,
+                                                      int firstActive, int lastActive) noexcept
+{
+    for (auto i = (size_t) firstActive; i < (size_t) lastActive; ++i)
+    {
+        auto a1 = active[0][i];
+        auto a2 = active[1][i];
+        auto a3 = active[2][i];
+        auto m0 = active[3][i];
+        auto m1 = active[4][i];
+        auto m2 = active[5][i];
+
+        // The two integrators' equivalent currents
+        auto* slotState = channelState + activeSlots[i] * 2;
+        auto ic1eq = slotState[0];
+        auto ic2eq = slotState[1];
+
+        for (size_t n = 0; n < numSamples; ++n)
+        {
+            auto v0 = samples[n];
+            auto v3 = v0 - ic2eq;
+            auto v1 = a1 * ic1eq + a2 * v3;
+            auto v2 = ic2eq + a2 * ic1eq + a3 * v3;
+            ic1eq = 2 * v1 - ic1eq;
+            ic2eq = 2 * v2 - ic2eq;
+            samples[n] = m0 * v0 + m1 * v1 + m2 * v2;
+        }
+
+        slotState[0] = ic1eq;
+        slotState[1] = ic2eq;
+    }
+}
+
+template <typename SampleType>
+typename BasicBandArray<SampleType>::Section BasicBandArray<SampleType>::getActiveSection(int index) const noexcept
+{
+    Section section;
+
+    for (size_t c = 0; c < (size_t) numSectionCoefficients; ++c)
+        section[c] = active[c][(size_t) index];
+
+    return section;
+}
+
+template <typename SampleType>
+void BasicBandArray<SampleType>::processActive(SampleType* samples, size_t numSamples, int firstActive, int lastActive) noexcept
+{
+    // The first channel's state
+    if (topology == FilterTopology::stateVariable)
+        processStateVariable(samples, numSamples, state.get(), firstActive, lastActive);
+    else
+        processTransposedDirectForm(samples, numSamples, state.get(), firstActive, lastActive);
+}
+
+template <typename SampleType>
+void BasicBandArray<SampleType>::processMidSide(BasicBandArray& side, const juce::dsp::AudioBlock<SampleType>& block) noexcept
+{
+    jassert(block.getNumChannels() == 2 && numChannels > 0 && side.numChannels > 0);
+    jassert(topology == side.topology);
+
+    if (needsPacking)
+        packActiveBiquads();
+
+    if (side.needsPacking)
+        side.packActiveBiquads();
+
+    // Encoding and decoding with nothing in between gives back the input
+    if (numActive == 0 && side.numActive == 0)
+        return;
+
+    auto* left = block.getChannelPointer(0);
+    auto* right = block.getChannelPointer(1);
+    auto numSamples = block.getNumSamples();
+
+    // One sample through one section, with its two state values in z. The
+    // same sums as the block loops.
+    if (topology == FilterTopology::stateVariable)
+    {
+        processMidSide(side, left, right, numSamples, { 0, 0, 0, 1, 0, 0 },
+                       [](const Section& c, SampleType v0, SampleType* z) noexcept
+                       {
+                           auto v3 = v0 - z[1];
+                           auto v1 = c[0] * z[0] + c[1] * v3;
+                           auto v2 = z[1] + c[1] * z[0] + c[2] * v3;
+                           z[0] = 2 * v1 - z[0];
+                           z[1] = 2 * v2 - z[1];
+                           return c[3] * v0 + c[4] * v1 + c[5] * v2;
+                       });
+    }
+    else
+    {
+        processMidSide(side, left, right, numSamples, { 1, 0, 0, 0, 0, 0 },
+                       [](const Section& c, SampleType input, SampleType* z) noexcept
+                       {
+                           auto output = (c[0] * input) + z[0];
+                           z[0] = (c[1] * input) - (c[3] * output) + z[1];
+                           z[1] = (c[2] * input) - (c[4] * output);
+                           return output;
+                       });
+    }
+}
+
+template <typename SampleType>
+template <typename Tick>
+void BasicBandArray<SampleType>::processMidSide(BasicBandArray& side, SampleType* left, SampleType* right, size_t numSamples,
+                                                const Section& passThrough, Tick&& tick) noexcept
+{
+    // Each channel's biquads split into the first, which runs in the
+    // encoding loop, the last, which runs in the decoding loop, and any in
+    // between, which run in place on the left (mid) or right (side)
+    // channel with the usual block loops. A channel short of biquads gets
+    // a pass-through section in the fused loops instead, with its state
+    // in a local that's thrown away.
+    struct End
+    {
+        Section section;
+        SampleType* state;
+        SampleType z[2];
+
+        void load() noexcept    { z[0] = state[0]; z[1] = state[1]; }
+        void store() noexcept   { state[0] = z[0]; state[1] = z[1]; }
+    };
+
+    SampleType unusedState[2] {};
+
+    auto getEnd = [&](BasicBandArray& array, int index, bool exists)
+    {
+        End end { passThrough, unusedState, {} };
+
+        if (exists)
+        {
+            end.section = array.getActiveSection(index);
+            end.state = array.state.get() + array.activeSlots[(size_t) index] * 2;
+        }
+
+        end.load();
+        return end;
+    };
+
+    auto numMid = numActive;
+    auto numSide = side.numActive;
+    auto isSinglePass = numMid <= 1 && numSide <= 1;
+
+    auto firstMid = getEnd(*this, 0, numMid > 0);
+    auto firstSide = getEnd(side, 0, numSide > 0);
+
+    for (size_t n = 0; n < numSamples; ++n)
+    {
+        auto mid = tick(firstMid.section, (left[n] + right[n]) * SampleType(0.5), firstMid.z);
+        auto sideSample = tick(firstSide.section, (left[n] - right[n]) * SampleType(0.5), firstSide.z);
+
+        if (isSinglePass)
+        {
+            left[n] = mid + sideSample;
+            right[n] = mid - sideSample;
+        }
+        else
+        {
+            left[n] = mid;
+            right[n] = sideSample;
+        }
+    }
+
+    firstMid.store();
+    firstSide.store();
+
+    if (isSinglePass)
+        return;
+
+    if (numMid > 2)
+        processActive(left, numSamples, 1, numMid - 1);
+
+    if (numSide > 2)
+        side.processActive(right, numSamples, 1, numSide - 1);
+
+    auto lastMid = getEnd(*this, numMid - 1, numMid > 1);
+    auto lastSide = getEnd(side, numSide - 1, numSide > 1);
+
+    for (size_t n = 0; n < numSamples; ++n)
+    {
+        auto mid = tick(lastMid.section, left[n], lastMid.z);
+        auto sideSample = tick(lastSide.section, right[n], lastSide.z);
+
+        left[n] = mid + sideSample;
+        right[n] = mid - sideSample;
+    }
+
+    lastMid.store();
+    lastSide.store();
+}
+
+template class BasicBandArray<float>;
+template class BasicBandArray<double>;
@@ -0,0 +1,160 @@
+/*
+  ==============================================================================
+
+    This file contains the band array, a filter engine that runs any number
+    of bands (up to maxBands) from flat arrays of coefficients and state
+    rather than a fixed chain of filter objects.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CoefficientEngine.h"
+
+//==============================================================================
+/**
+    Every band owns maxBiquadsPerBand consecutive second order slots. The
+    coefficients are stored structure-of-arrays, one array per coefficient
+    across all the slots, and each channel's state is one array of
+    two-value pairs, so a band's coefficients and state are each contiguous.
+
+    Only the slots that are doing something get processed. Whenever a band
+    changes, the active slots are gathered, in band order, into a second
+    set of packed arrays, and the processing loop runs straight down those.
+    Cost scales with the number of active biquads rather than maxBands, and
+    for small blocks everything the loop touches stays in the L1 cache.
+
+    The usual low cut, peak and high cut are bands 0 to 2 (in ChainStage
+    order), with the extra bands after them, so setChainCoefficients
+    reproduces the MonoChain layout exactly.
+
+    SampleType is float or double. The float version is the BandArray the
+    float processing path uses; the double version, with its coefficients
+    designed in double too, is DoubleBandArray. Each is compiled separately,
+    so neither pays anything for the other. Everything after prepare is
+    allocation-free.
+*/
+template <typename SampleType>
+class BasicBandArray
+{
+public:
+    static constexpr int maxBands = NumChainStages + numExtraBands;
+    static constexpr int maxBiquadsPerBand = 4;
+    static constexpr int maxBiquads = maxBands * maxBiquadsPerBand;
+
+    // The index of an extra band in the array
+    static constexpr int getExtraBandIndex(int extraBand) noexcept      { return NumChainStages + extraBand; }
+
+    // Whether an extra band changes the sound at all. Bands that are off,
+    // and peaks and shelves at 0 dB, are left out of the processing.
+    static bool isActive(const BandSettings& band) noexcept;
+
+    BasicBandArray();
+
+    // Allocates the filter state. Call this from prepareToPlay.
+    void prepare(const juce::dsp::ProcessSpec& spec);
+
+    // Clears the filter state of every band
+    void reset() noexcept;
+
+    // The two topologies use their state differently, so this clears it.
+    // Set the bands again afterwards.
+    void setTopology(FilterTopology newTopology) noexcept;
+    FilterTopology getTopology() const noexcept     { return topology; }
+
+    // Sets every band from a designed chain: the cuts and peak, then the
+    // extra bands that are active. Only for the transposed direct form.
+    void setChainCoefficients(const ChainCoefficients& chainCoefficients) noexcept;
+
+    // Designs every band for the settings itself, at SampleType precision
+    // and in the current topology
+    void setChainSettings(const SimpleEQSettings& settings) noexcept;
+
+    // Sets just the peak band, for the peak band's dynamics. The biquad is
+    // used as it is in the transposed direct form; the state variable
+    // filter is designed from the settings. When it's only the coefficients
+    // that change, they go straight into the packed arrays, with no
+    // repacking.
+    void setPeak(const BasicBiquadCoefficients<SampleType>& biquad, const BandSettings& settings) noexcept;
+
+    // Takes a band out of the processing, or puts it back. A band that's
+    // out keeps its coefficients and state.
+    void setBandRunning(int band, bool shouldRun) noexcept;
+
+    // Clears the filter state of one band
+    void resetBand(int band) noexcept;
+
+    // Filters every channel of the block in place with all the active bands
+    void process(const juce::dsp::AudioBlock<SampleType>& block) noexcept    { processBands(block, 0, maxBands); }
+
+    // Filters every channel of the block in place with the active bands in
+    // [firstBand, lastBand)
+    void processBands(const juce::dsp::AudioBlock<SampleType>& block, int firstBand, int lastBand) noexcept;
+
+    // Filters a stereo block in Mid/Side: this array's active bands run on
+    // the mid channel and side's on the side channel. The encode is folded
+    // into the loop that runs each channel's first biquad and the decode
+    // into the one that runs its last, so the block is filtered in place
+    // with no more passes over it than process makes. Each array keeps its
+    // channel's state in its first channel. Both must be in the same
+    // topology.
+    void processMidSide(BasicBandArray& side, const juce::dsp::AudioBlock<SampleType>& block) noexcept;
+
+    // How many biquads a call to process would run
+    int getNumActiveBiquads() noexcept;
+
+private:
+    // One second order section. For the transposed direct form it's b0, b1,
+    // b2, a1, a2 and an unused zero; for the state variable filter it's the
+    // a1, a2, a3 that set the filter and the m0, m1, m2 that mix its
+    // outputs, as Simper names them.
+    static constexpr int numSectionCoefficients = 6;
+    using Section = std::array<SampleType, numSectionCoefficients>;
+
+    // One array per coefficient, indexed by slot
+    using CoefficientArrays = std::array<std::array<SampleType, maxBiquads>, numSectionCoefficients>;
+
+    void setBand(int band, const Section* sections, int numSections) noexcept;
+    void setCutBand(int band, CutType type, float frequency, Slope slope) noexcept;
+    void setBandFromSettings(int band, const BandSettings& settings) noexcept;
+    void packActiveBiquads() noexcept;
+
+    void processTransposedDirectForm(SampleType* samples, size_t numSamples, SampleType* channelState, int firstActive, int lastActive) noexcept;
+    void processStateVariable(SampleType* samples, size_t numSamples, SampleType* channelState, int firstActive, int lastActive) noexcept;
+    void processActive(SampleType* samples, size_t numSamples, int firstActive, int lastActive) noexcept;
+
+    template <typename Tick>
+    void processMidSide(BasicBandArray& side, SampleType* left, SampleType* right, size_t numSamples,
+                        const Section& passThrough, Tick&& tick) noexcept;
+
+    Section getActiveSection(int index) const noexcept;
+
+    FilterTopology topology = FilterTopology::transposedDirectForm;
+    double sampleRate = 44100.0;
+
+    // Every slot's coefficients, and how many slots each band uses
+    CoefficientArrays coefficients {};
+    std::array<int, maxBands> numBandBiquads {};
+    std::array<bool, maxBands> bandRunning {};
+
+    // The active biquads, packed in band order. activeSlots maps each one
+    // back to its slot for the state, and bandStarts gives where each
+    // band's run of them starts.
+    CoefficientArrays active {};
+    std::array<int, maxBiquads> activeSlots {};
+    std::array<int, maxBands + 1> bandStarts {};
+    int numActive = 0;
+    bool needsPacking = true;
+
+    // numChannels runs of maxBiquads state pairs: (s1, s2) for the direct
+    // form, (ic1eq, ic2eq) for the state variable filter
+    juce::HeapBlock<SampleType> state;
+    size_t numChannels = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BasicBandArray)
+};
+
+using BandArray = BasicBandArray<float>;
+using DoubleBandArray = BasicBandArray<double>;
@@ -0,0 +1,195 @@
+/*
+  ==============================================================================
+
+    This file contains the plain-data coefficient type that gets passed
+    between the designers and the audio thread, along with allocation-free
+    versions of the filter designs the EQ uses.
+
+  ==============================================================================
+*/
+
+#include "BiquadCoefficients.h"
+
+namespace
+{
+    // Normalises by a0, the same as the juce::dsp::IIR::Coefficients constructor
+    template <typename SampleType>
+    BasicBiquadCoefficients<SampleType> normalise(SampleType b0, SampleType b1, SampleType b2, SampleType a0, SampleType a1, SampleType a2) noexcept
+    {
+        auto a0inv = a0 != SampleType(0) ? SampleType(1) / a0 : SampleType(0);
+        return { b0 * a0inv, b1 * a0inv, b2 * a0inv, a1 * a0inv, a2 * a0inv };
+    }
+
+    // The Q of each second order stage in an even order Butterworth filter.
+    // Row n is for a slope of n, which is a filter of order 2 * (n + 1).
+    std::array<std::array<double, 4>, 4> makeButterworthQs()
+    {
+        std::array<std::array<double, 4>, 4> qs {};
+
+        for (int slope = 0; slope < 4; ++slope)
+        {
+            auto order = (slope + 1) * 2;
+
+            for (int stage = 0; stage <= slope; ++stage)
+                qs[(size_t) slope][(size_t) stage] = 1.0 / (2.0 * std::cos((2.0 * stage + 1.0) * juce::MathConstants<double>::pi / (order * 2.0)));
+        }
+
+        return qs;
+    }
+
+    // Built once when the plugin loads so the audio thread never has to
+    const auto butterworthQs = makeButterworthQs();
+}
+
+double getButterworthQ(Slope slope, int stage) noexcept
+{
+    return butterworthQs[(size_t) slope][(size_t) stage];
+}
+
+template <typename SampleType>
+BasicBiquadCoefficients<SampleType> makePeakCoefficients(double sampleRate, SampleType frequency, SampleType Q, SampleType gainFactor) noexcept
+{
+    auto A = juce::jmax(SampleType(0), std::sqrt(gainFactor));
+    auto omega = (2 * juce::MathConstants<SampleType>::pi * juce::jmax(frequency, SampleType(2))) / static_cast<SampleType>(sampleRate);
+    auto alpha = std::sin(omega) / (Q * 2);
+    auto c2 = -2 * std::cos(omega);
+    auto alphaTimesA = alpha * A;
+    auto alphaOverA = alpha / A;
+
+    return normalise<SampleType>(1 + alphaTimesA, c2, 1 - alphaTimesA, 1 + alphaOverA, c2, 1 - alphaOverA);
+}
+
+template <typename SampleType>
+BasicBiquadCoefficients<SampleType> makeLowShelfCoefficients(double sampleRate, SampleType frequency, SampleType Q, SampleType gainFactor) noexcept
+{
+    auto A = juce::jmax(SampleType(0), std::sqrt(gainFactor));
+    auto aminus1 = A - 1;
+    auto aplus1 = A + 1;
+    auto omega = (2 * juce::MathConstants<SampleType>::pi * juce::jmax(frequency, SampleType(2))) / static_cast<SampleType>(sampleRate);
+    auto coso = std::cos(omega);
+    auto beta = std::sin(omega) * std::sqrt(A) / Q;
+    auto aminus1TimesCoso = aminus1 * coso;
+
+    return normalise<SampleType>(A * (aplus1 - aminus1TimesCoso + beta),
+                                 A * 2 * (aminus1 - aplus1 * coso),
+                                 A * (aplus1 - aminus1TimesCoso - beta),
+                                 aplus1 + aminus1TimesCoso + beta,
+                                 -2 * (aminus1 + aplus1 * coso),
+                                 aplus1 + aminus1TimesCoso - beta);
+}
+
+template <typename SampleType>
+BasicBiquadCoefficients<SampleType> makeHighShelfCoefficients(double sampleRate, SampleType frequency, SampleType Q, SampleType gainFactor) noexcept
+{
+    auto A = juce::jmax(SampleType(0), std::sqrt(gainFactor));
+    auto aminus1 = A - 1;
+    auto aplus1 = A + 1;
+    auto omega = (2 * juce::MathConstants<SampleType>::pi * juce::jmax(frequency, SampleType(2))) / static_cast<SampleType>(sampleRate);
+    auto coso = std::cos(omega);
+    auto beta = std::sin(omega) * std::sqrt(A) / Q;
+    auto aminus1TimesCoso = aminus1 * coso;
+
+    return normalise<SampleType>(A * (aplus1 + aminus1TimesCoso + beta),
+                                 A * -2 * (aminus1 + aplus1 * coso),
+                                 A * (aplus1 + aminus1TimesCoso - beta),
+                                 aplus1 - aminus1TimesCoso + beta,
+                                 2 * (aminus1 - aplus1 * coso),
+                                 aplus1 - aminus1TimesCoso - beta);
+}
+
+template <typename SampleType>
+BasicBiquadCoefficients<SampleType> makeNotchCoefficients(double sampleRate, SampleType frequency, SampleType Q) noexcept
+{
+    auto n = 1 / std::tan(juce::MathConstants<SampleType>::pi * frequency / static_cast<SampleType>(sampleRate));
+    auto nSquared = n * n;
+    auto invQ = 1 / Q;
+    auto c1 = 1 / (1 + n * invQ + nSquared);
+
+    return normalise<SampleType>(c1 * (1 + nSquared), 2 * c1 * (1 - nSquared), c1 * (1 + nSquared),
+                                 1, c1 * 2 * (1 - nSquared), c1 * (1 - n * invQ + nSquared));
+}
+
+template <typename SampleType>
+BasicBiquadCoefficients<SampleType> makeBandCoefficients(double sampleRate, const BandSettings& band) noexcept
+{
+    auto frequency = static_cast<SampleType>(band.frequency);
+    auto Q = static_cast<SampleType>(band.Q);
+    auto gainFactor = juce::Decibels::decibelsToGain(static_cast<SampleType>(band.gain));
+
+    switch (band.type)
+    {
+        case BandType::peak:        return makePeakCoefficients(sampleRate, frequency, Q, gainFactor);
+        case BandType::lowShelf:    return makeLowShelfCoefficients(sampleRate, frequency, Q, gainFactor);
+        case BandType::highShelf:   return makeHighShelfCoefficients(sampleRate, frequency, Q, gainFactor);
+        case BandType::notch:       return makeNotchCoefficients(sampleRate, frequency, Q);
+    }
+
+    return { 1, 0, 0, 0, 0 };
+}
+
+template <typename SampleType>
+void makeCutCoefficients(CutType type, double sampleRate, SampleType frequency, Slope slope, std::array<BasicBiquadCoefficients<SampleType>, 4>& coefficients) noexcept
+{
+    coefficients.fill({ 1, 0, 0, 0, 0 });
+
+    // Every stage shares the same warped frequency, only the Q changes
+    auto warped = std::tan(juce::MathConstants<SampleType>::pi * frequency / static_cast<SampleType>(sampleRate));
+    auto n = type == CutType::lowCut ? warped : 1 / warped;
+    auto nSquared = n * n;
+
+    for (int stage = 0; stage <= slope; ++stage)
+    {
+        auto invQ = static_cast<SampleType>(1.0 / butterworthQs[(size_t) slope][(size_t) stage]);
+        auto c1 = 1 / (1 + invQ * n + nSquared);
+
+        if (type == CutType::lowCut)
+            coefficients[(size_t) stage] = normalise<SampleType>(c1, c1 * -2, c1, 1, c1 * 2 * (nSquared - 1), c1 * (1 - invQ * n + nSquared));
+        else
+            coefficients[(size_t) stage] = normalise<SampleType>(c1, c1 * 2, c1, 1, c1 * 2 * (1 - nSquared), c1 * (1 - invQ * n + nSquared));
+    }
+}
+
+// The designs are only needed at these two precisions
+#define SIMPLEEQ_INSTANTIATE_DESIGNS(SampleType) \
+    template BasicBiquadCoefficients<SampleType> makePeakCoefficients(double, SampleType, SampleType, SampleType) noexcept; \
+    template BasicBiquadCoefficients<SampleType> makeLowShelfCoefficients(double, SampleType, SampleType, SampleType) noexcept; \
+    template BasicBiquadCoefficients<SampleType> makeHighShelfCoefficients(double, SampleType, SampleType, SampleType) noexcept; \
+    template BasicBiquadCoefficients<SampleType> makeNotchCoefficients(double, SampleType, SampleType) noexcept; \
+    template BasicBiquadCoefficients<SampleType> makeBandCoefficients<SampleType>(double, const BandSettings&) noexcept; \
+    template void makeCutCoefficients(CutType, double, SampleType, Slope, std::array<BasicBiquadCoefficients<SampleType>, 4>&) noexcept;
+
+SIMPLEEQ_INSTANTIATE_DESIGNS(float)
+SIMPLEEQ_INSTANTIATE_DESIGNS(double)
+
+#undef SIMPLEEQ_INSTANTIATE_DESIGNS
+
+double getDecaySamples(const BiquadCoefficients& coefficients, double decayDecibels) noexcept
+{
+    // The poles are the roots of z^2 + a1 z + a2
+    auto a1 = (double) coefficients[3];
+    auto a2 = (double) coefficients[4];
+    auto discriminant = a1 * a1 - 4.0 * a2;
+
+    double radius;
+
+    if (discriminant < 0.0)
+    {
+        // A complex pair, both with the same radius
+        radius = std::sqrt(a2);
+    }
+    else
+    {
+        auto root = std::sqrt(discriminant);
+        radius = juce::jmax(std::abs((-a1 + root) * 0.5), std::abs((-a1 - root) * 0.5));
+    }
+
+    // Pass-through and FIR stages have no poles to ring. The two samples
+    // cover the stage's own delay line.
+    if (radius <= 0.0)
+        return 2.0;
+
+    if (radius >= 1.0)
+        return std::numeric_limits<double>::max();
+
+    return 2.0 + (-decayDecibels / 20.0) * std::log(10.0) / -std::log(radius);
+}
@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    This file contains the plain-data coefficient type that gets passed
+    between the designers and the audio thread, along with allocation-free
+    versions of the filter designs the EQ uses.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SimpleEQSettings.h"
+
+// A single biquad's coefficients, normalised and laid out the same way
+// juce::dsp::IIR::Coefficients stores them: b0, b1, b2, a1, a2.
+template <typename SampleType>
+using BasicBiquadCoefficients = std::array<SampleType, 5>;
+
+// Everything outside the double precision path works in float
+using BiquadCoefficients = BasicBiquadCoefficients<float>;
+
+constexpr BiquadCoefficients passThroughCoefficients { 1.f, 0.f, 0.f, 0.f, 0.f };
+
+// Which of the two cut bands a design is for. The low cut is a Butterworth
+// high pass and the high cut is a Butterworth low pass.
+enum class CutType
+{
+    lowCut,
+    highCut
+};
+
+// These give the same coefficients as juce::dsp::IIR::Coefficients::makePeakFilter,
+// makeLowShelf, makeHighShelf and makeNotch, and
+// FilterDesign::designIIR...HighOrderButterworthMethod, but write straight
+// into plain arrays. They never allocate, so they're safe to call from the
+// audio thread. They're worked out at the precision of SampleType, and
+// only exist for float and double.
+template <typename SampleType>
+BasicBiquadCoefficients<SampleType> makePeakCoefficients(double sampleRate, SampleType frequency, SampleType Q, SampleType gainFactor) noexcept;
+
+template <typename SampleType>
+BasicBiquadCoefficients<SampleType> makeLowShelfCoefficients(double sampleRate, SampleType frequency, SampleType Q, SampleType gainFactor) noexcept;
+
+template <typename SampleType>
+BasicBiquadCoefficients<SampleType> makeHighShelfCoefficients(double sampleRate, SampleType frequency, SampleType Q, SampleType gainFactor) noexcept;
+
+template <typename SampleType>
+BasicBiquadCoefficients<SampleType> makeNotchCoefficients(double sampleRate, SampleType frequency, SampleType Q) noexcept;
+
+// Designs one of the extra bands with whichever of the above its type needs
+template <typename SampleType = float>
+BasicBiquadCoefficients<SampleType> makeBandCoefficients(double sampleRate, const BandSettings& band) noexcept;
+
+// Fills the first (slope + 1) stages and sets the rest to pass-through
+template <typename SampleType>
+void makeCutCoefficients(CutType type, double sampleRate, SampleType frequency, Slope slope, std::array<BasicBiquadCoefficients<SampleType>, 4>& coefficients) noexcept;
+
+// The Q of one second order stage of the Butterworth cut filter for a slope
+double getButterworthQ(Slope slope, int stage) noexcept;
+
+// How many samples the biquad's impulse response takes to fall to
+// decayDecibels (a negative level, e.g. -120), going by the radius of its
+// poles. Unstable or marginal
+// designs return a very large number rather than infinity.
+double getDecaySamples(const BiquadCoefficients& coefficients, double decayDecibels) noexcept;
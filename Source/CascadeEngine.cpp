@@ -0,0 +1,167 @@
+/*
+  ==============================================================================
+
+    This file contains the cascade engine. It runs the same low cut, peak
+    and high cut biquads as MonoChain, but runs the whole cascade on each
+    sample before moving on to the next, in a single pass over the block.
+
+  ==============================================================================
+*/
+
+#include "CascadeEngine.h"
+
+void CascadeEngine::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    numChannels = spec.numChannels;
+    state.calloc(numChannels * numPositions * 2);
+
+    coefficients.fill(passThroughCoefficients);
+    numLowCutBiquads = 0;
+    numHighCutBiquads = 0;
+    updateActivePositions();
+}
+
+void CascadeEngine::reset() noexcept
+{
+    std::fill(state.get(), state.get() + numChannels * numPositions * 2, 0.f);
+}
+
+void CascadeEngine::setCoefficients(const ChainCoefficients& chainCoefficients) noexcept
+{
+    const auto& settings = chainCoefficients.settings;
+
+    // A slope of n uses the first (n + 1) stages of the cut filter
+    numLowCutBiquads = settings.lowCutSlope + 1;
+    numHighCutBiquads = settings.highCutSlope + 1;
+
+    for (int stage = 0; stage < numLowCutBiquads; ++stage)
+        coefficients[(size_t) (lowCutPosition + stage)] = chainCoefficients.lowCut[(size_t) stage];
+
+    coefficients[peakPosition] = chainCoefficients.peak;
+
+    for (int stage = 0; stage < numHighCutBiquads; ++stage)
+        coefficients[(size_t) (highCutPosition + stage)] = chainCoefficients.highCut[(size_t) stage];
+
+    updateActivePositions();
+}
+
+void CascadeEngine::setStageRunning(ChainStage stage, bool shouldRun) noexcept
+{
+    if (stageRunning[(size_t) stage] == shouldRun)
+        return;
+
+    stageRunning[(size_t) stage] = shouldRun;
+    updateActivePositions();
+}
+
+void CascadeEngine::updateActivePositions() noexcept
+{
+    const std::array<int, NumChainStages> firstPositions { lowCutPosition, peakPosition, highCutPosition };
+    const std::array<int, NumChainStages> numBiquads { numLowCutBiquads, 1, numHighCutBiquads };
+
+    numActivePositions = 0;
+
+    for (size_t stage = 0; stage < (size_t) NumChainStages; ++stage)
+    {
+        stageStarts[stage] = numActivePositions;
+
+        if (stageRunning[stage])
+            for (int i = 0; i < numBiquads[stage]; ++i)
+                activePositions[(size_t) numActivePositions++] = firstPositions[stage] + i;
+    }
+
+    stageStarts[NumChainStages] = numActivePositions;
+}
+
+void CascadeEngine::resetStage(ChainStage stage) noexcept
+{
+    // Clear every position the band owns, including the ones the current
+    // slope doesn't use
+    auto firstPosition = stage == LowCutStage ? lowCutPosition : stage == PeakStage ? peakPosition : highCutPosition;
+    auto lastPosition = stage == LowCutStage ? peakPosition : stage == PeakStage ? highCutPosition : numPositions;
+
+    for (size_t channel = 0; channel < numChannels; ++channel)
+    {
+        auto* channelState = state.get() + channel * numPositions * 2;
+        std::fill(channelState + firstPosition * 2, channelState + lastPosition * 2, 0.f);
+    }
+}
+
+void CascadeEngine::process(const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    processPositions(block, 0, numActivePositions);
+}
+
+void CascadeEngine::processStage(const juce::dsp::AudioBlock<float>& block, ChainStage stage) noexcept
+{
+    processPositions(block, stageStarts[(size_t) stage], stageStarts[(size_t) stage + 1]);
+}
+
+void CascadeEngine::processPositions(const juce::dsp::AudioBlock<float>& block, int firstActive, int lastActive) noexcept
+{
+    jassert(block.getNumChannels() <= numChannels);
+
+    auto numSamples = block.getNumSamples();
+    auto numBlockChannels = juce::jmin(block.getNumChannels(), numChannels);
+
+    for (size_t channel = 0; channel < numBlockChannels; ++channel)
+    {
+        auto* samples = block.getChannelPointer(channel);
+        auto* channelState = state.get() + channel * numPositions * 2;
+
+        // Pick the loop built for exactly this many biquads. Nothing to do
+        // if every band has been taken out.
+        switch (lastActive - firstActive)
+        {
+            case 1:  processChannel<1>(samples, numSamples, channelState, firstActive); break;
+            case 2:  processChannel<2>(samples, numSamples, channelState, firstActive); break;
+            case 3:  processChannel<3>(samples, numSamples, channelState, firstActive); break;
+            case 4:  processChannel<4>(samples, numSamples, channelState, firstActive); break;
+            case 5:  processChannel<5>(samples, numSamples, channelState, firstActive); break;
+            case 6:  processChannel<6>(samples, numSamples, channelState, firstActive); break;
+            case 7:  processChannel<7>(samples, numSamples, channelState, firstActive); break;
+            case 8:  processChannel<8>(samples, numSamples, channelState, firstActive); break;
+            case 9:  processChannel<9>(samples, numSamples, channelState, firstActive); break;
+            default: break;
+        }
+    }
+}
+
+template <int numBiquads>
+void CascadeEngine::processChannel(float* samples, size_t numSamples, float* channelState, int firstActive) const noexcept
+{
+    // Copy the coefficients and state into locals so the compiler knows
+    // nothing else can change them, and can keep them in registers
+    std::array<BiquadCoefficients, numBiquads> c;
+    std::array<float, numBiquads> s1, s2;
+
+    for (size_t k = 0; k < (size_t) numBiquads; ++k)
+    {
+        auto position = (size_t) activePositions[(size_t) firstActive + k];
+        c[k] = coefficients[position];
+        s1[k] = channelState[position * 2];
+        s2[k] = channelState[position * 2 + 1];
+    }
+
+    for (size_t n = 0; n < numSamples; ++n)
+    {
+        auto sample = samples[n];
+
+        for (size_t k = 0; k < (size_t) numBiquads; ++k)
+        {
+            auto output = (c[k][0] * sample) + s1[k];
+            s1[k] = (c[k][1] * sample) - (c[k][3] * output) + s2[k];
+            s2[k] = (c[k][2] * sample) - (c[k][4] * output);
+            sample = output;
+        }
+
+        samples[n] = sample;
+    }
+
+    for (size_t k = 0; k < (size_t) numBiquads; ++k)
+    {
+        auto position = (size_t) activePositions[(size_t) firstActive + k];
+        channelState[position * 2] = s1[k];
+        channelState[position * 2 + 1] = s2[k];
+    }
+}
@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    This file contains the cascade engine. It runs the same low cut, peak
+    and high cut biquads as MonoChain, but runs the whole cascade on each
+    sample before moving on to the next, in a single pass over the block.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CoefficientEngine.h"
+
+//==============================================================================
+/**
+    MonoChain runs each biquad over the whole block before the next one
+    starts, so a 48 dB/oct low cut, the peak and a 48 dB/oct high cut make
+    nine passes over the block, with a bypass check between each. Once the
+    block is too big for the L1 cache, every one of those passes goes out
+    to memory.
+
+    This engine instead keeps every active biquad's coefficients and state
+    in locals and takes each sample through all of them in turn, so the
+    block is read and written once. The per-sample loop is a template on
+    the number of active biquads, instantiated for every count from one
+    to nine, so the loop over the biquads is unrolled with no checks
+    inside it and the compiler can keep the whole cascade in registers.
+    Every combination of slopes, with the peak in or out, comes down to
+    one of those nine counts.
+
+    The biquads use the same transposed direct form II as
+    juce::dsp::IIR::Filter, so the output matches the MonoChain path.
+*/
+class CascadeEngine
+{
+public:
+    CascadeEngine() = default;
+
+    // Allocates the filter state. Call this from prepareToPlay; nothing
+    // after this allocates.
+    void prepare(const juce::dsp::ProcessSpec& spec);
+
+    // Clears the filter state
+    void reset() noexcept;
+
+    // Copies in a new set of coefficients and works out which stages are
+    // active for the selected slopes
+    void setCoefficients(const ChainCoefficients& chainCoefficients) noexcept;
+
+    // Replaces just the peak's coefficients, for the peak band's dynamics
+    void setPeakCoefficients(const BiquadCoefficients& peak) noexcept    { coefficients[peakPosition] = peak; }
+
+    // Takes a whole band out of the cascade, or puts it back. A band that's
+    // out keeps its state but isn't processed at all.
+    void setStageRunning(ChainStage stage, bool shouldRun) noexcept;
+
+    // Clears the filter state of one band
+    void resetStage(ChainStage stage) noexcept;
+
+    // Filters every channel of the block in place
+    void process(const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    // Filters every channel of the block in place with just one band
+    void processStage(const juce::dsp::AudioBlock<float>& block, ChainStage stage) noexcept;
+
+private:
+    // Positions of the nine biquads, laid out the same way as in the SIMD
+    // engine. Each one keeps its own state even while it's inactive, so
+    // changing the slope doesn't move state between stages.
+    static constexpr int numPositions = 9;
+    static constexpr int lowCutPosition = 0;
+    static constexpr int peakPosition = 4;
+    static constexpr int highCutPosition = 5;
+
+    void updateActivePositions() noexcept;
+    void processPositions(const juce::dsp::AudioBlock<float>& block, int firstActive, int lastActive) noexcept;
+
+    template <int numBiquads>
+    void processChannel(float* samples, size_t numSamples, float* channelState, int firstActive) const noexcept;
+
+    std::array<BiquadCoefficients, numPositions> coefficients;
+    int numLowCutBiquads = 0;
+    int numHighCutBiquads = 0;
+    std::array<bool, NumChainStages> stageRunning { true, true, true };
+
+    // The positions to run, in chain order, and where each band's run of
+    // them starts and ends
+    std::array<int, numPositions> activePositions;
+    int numActivePositions = 0;
+    std::array<int, NumChainStages + 1> stageStarts {};
+
+    // Two state values per position per channel
+    juce::HeapBlock<float> state;
+    size_t numChannels = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CascadeEngine)
+};
@@ -0,0 +1,190 @@
+/*
+  ==============================================================================
+
+    This file contains the chain parameters. They read the settings straight
+    from the parameters' values, and keep count of which groups of
+    parameters have changed.
+
+  ==============================================================================
+*/
+
+#include "ChainParameters.h"
+
+ChainParameters::Values::Values(juce::AudioProcessorValueTreeState& ap_tree_state)
+{
+    auto get = [&ap_tree_state](const std::string& parameterID)
+    {
+        auto* value = ap_tree_state.getRawParameterValue(parameterID);
+
+        // Every parameter the settings need should be in the layout
+        jassert(value != nullptr);
+        return value;
+    };
+
+    lowCutFreq = get(LOW_CUT_FREQ);
+    lowCutSlope = get(LOW_CUT_SLOPE);
+    peakFreq = get(PEAK_FREQ);
+    peakGain = get(PEAK_GAIN);
+    peakQ = get(PEAK_Q);
+    highCutFreq = get(HIGH_CUT_FREQ);
+    highCutSlope = get(HIGH_CUT_SLOPE);
+
+    for (int index = 0; index < numExtraBands; ++index)
+    {
+        auto& band = extraBands[(size_t) index];
+
+        band.enabled = get(getExtraBandParameterID(index, BAND_ON));
+        band.type = get(getExtraBandParameterID(index, BAND_TYPE));
+        band.frequency = get(getExtraBandParameterID(index, BAND_FREQ));
+        band.gain = get(getExtraBandParameterID(index, BAND_GAIN));
+        band.Q = get(getExtraBandParameterID(index, BAND_Q));
+    }
+
+    midSide = get(MID_SIDE);
+    sideLowCutFreq = get(SIDE_LOW_CUT_FREQ);
+    sideLowCutSlope = get(SIDE_LOW_CUT_SLOPE);
+    sidePeakFreq = get(SIDE_PEAK_FREQ);
+    sidePeakGain = get(SIDE_PEAK_GAIN);
+    sidePeakQ = get(SIDE_PEAK_Q);
+    sideHighCutFreq = get(SIDE_HIGH_CUT_FREQ);
+    sideHighCutSlope = get(SIDE_HIGH_CUT_SLOPE);
+
+    dynamicOn = get(DYNAMIC_ON);
+    dynamicThreshold = get(DYNAMIC_THRESHOLD);
+    dynamicRatio = get(DYNAMIC_RATIO);
+    dynamicAttack = get(DYNAMIC_ATTACK);
+    dynamicRelease = get(DYNAMIC_RELEASE);
+    dynamicSidechain = get(DYNAMIC_SIDECHAIN);
+}
+
+SimpleEQSettings ChainParameters::Values::load() const noexcept
+{
+    SimpleEQSettings settings;
+
+    settings.lowCutFreq = lowCutFreq->load();
+    settings.lowCutSlope = static_cast<Slope>(lowCutSlope->load());
+    settings.highCutFreq = highCutFreq->load();
+    settings.highCutSlope = static_cast<Slope>(highCutSlope->load());
+    settings.peakFreq = peakFreq->load();
+    settings.peakGain = peakGain->load();
+    settings.peakQ = peakQ->load();
+
+    for (size_t index = 0; index < (size_t) numExtraBands; ++index)
+    {
+        auto& band = settings.extraBands[index];
+        const auto& bandValues = extraBands[index];
+
+        band.enabled = bandValues.enabled->load() > 0.5f;
+        band.type = static_cast<BandType>(juce::roundToInt(bandValues.type->load()));
+        band.frequency = bandValues.frequency->load();
+        band.gain = bandValues.gain->load();
+        band.Q = bandValues.Q->load();
+    }
+
+    settings.midSide = midSide->load() > 0.5f;
+    settings.side.lowCutFreq = sideLowCutFreq->load();
+    settings.side.lowCutSlope = static_cast<Slope>(sideLowCutSlope->load());
+    settings.side.highCutFreq = sideHighCutFreq->load();
+    settings.side.highCutSlope = static_cast<Slope>(sideHighCutSlope->load());
+    settings.side.peakFreq = sidePeakFreq->load();
+    settings.side.peakGain = sidePeakGain->load();
+    settings.side.peakQ = sidePeakQ->load();
+
+    settings.dynamic.enabled = dynamicOn->load() > 0.5f;
+    settings.dynamic.threshold = dynamicThreshold->load();
+    settings.dynamic.ratio = dynamicRatio->load();
+    settings.dynamic.attackMs = dynamicAttack->load();
+    settings.dynamic.releaseMs = dynamicRelease->load();
+    settings.dynamic.useSidechain = dynamicSidechain->load() > 0.5f;
+
+    return settings;
+}
+
+//==============================================================================
+ChainParameters::ChainParameters(juce::AudioProcessorValueTreeState& apts)
+    : ap_tree_state(apts),
+      values(apts)
+{
+    for (int group = 0; group < NumParameterGroups; ++group)
+        for (auto& parameterID : getParameterIDs(static_cast<ParameterGroup>(group)))
+            ap_tree_state.addParameterListener(parameterID, &listeners[(size_t) group]);
+}
+
+ChainParameters::~ChainParameters()
+{
+    for (int group = 0; group < NumParameterGroups; ++group)
+        for (auto& parameterID : getParameterIDs(static_cast<ParameterGroup>(group)))
+            ap_tree_state.removeParameterListener(parameterID, &listeners[(size_t) group]);
+}
+
+ChainParameters::Versions ChainParameters::getVersions() const noexcept
+{
+    Versions versions;
+
+    for (size_t group = 0; group < versions.size(); ++group)
+        versions[group] = listeners[group].version.load();
+
+    return versions;
+}
+
+int ChainParameters::getChangedGroups(const Versions& before, const Versions& after) noexcept
+{
+    int changedGroups = 0;
+
+    for (size_t group = 0; group < before.size(); ++group)
+        if (before[group] != after[group])
+            changedGroups |= 1 << group;
+
+    return changedGroups;
+}
+
+juce::StringArray ChainParameters::getParameterIDs(ParameterGroup group)
+{
+    juce::StringArray parameterIDs;
+
+    auto add = [&parameterIDs](std::initializer_list<const std::string*> groupIDs)
+    {
+        for (auto* parameterID : groupIDs)
+            parameterIDs.add(*parameterID);
+    };
+
+    switch (group)
+    {
+        case LowCutGroup:
+            add({ &LOW_CUT_FREQ, &LOW_CUT_SLOPE });
+            break;
+
+        case PeakGroup:
+            add({ &PEAK_FREQ, &PEAK_GAIN, &PEAK_Q });
+            break;
+
+        case HighCutGroup:
+            add({ &HIGH_CUT_FREQ, &HIGH_CUT_SLOPE });
+            break;
+
+        case ExtraBandsGroup:
+            for (int band = 0; band < numExtraBands; ++band)
+                for (auto* suffix : { &BAND_ON, &BAND_TYPE, &BAND_FREQ, &BAND_GAIN, &BAND_Q })
+                    parameterIDs.add(getExtraBandParameterID(band, *suffix));
+            break;
+
+        case SideGroup:
+            add({ &MID_SIDE,
+                  &SIDE_LOW_CUT_FREQ, &SIDE_LOW_CUT_SLOPE,
+                  &SIDE_PEAK_FREQ, &SIDE_PEAK_GAIN, &SIDE_PEAK_Q,
+                  &SIDE_HIGH_CUT_FREQ, &SIDE_HIGH_CUT_SLOPE });
+            break;
+
+        // The dynamics don't change the designs, but the audio thread gets
+        // its settings along with the coefficients
+        case DynamicGroup:
+            add({ &DYNAMIC_ON, &DYNAMIC_THRESHOLD, &DYNAMIC_RATIO,
+                  &DYNAMIC_ATTACK, &DYNAMIC_RELEASE, &DYNAMIC_SIDECHAIN });
+            break;
+
+        case NumParameterGroups:
+            break;
+    }
+
+    return parameterIDs;
+}
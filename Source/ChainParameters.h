@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+    This file contains the chain parameters. They read the settings straight
+    from the parameters' values, and keep count of which groups of
+    parameters have changed.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SimpleEQSettings.h"
+
+// The parameters, in groups that are designed and applied separately. The
+// first three line up with ChainStage.
+enum ParameterGroup
+{
+    LowCutGroup,
+    PeakGroup,
+    HighCutGroup,
+    ExtraBandsGroup,
+    SideGroup,
+    DynamicGroup,
+    NumParameterGroups
+};
+
+static_assert((int) LowCutGroup == (int) LowCutStage
+               && (int) PeakGroup == (int) PeakStage
+               && (int) HighCutGroup == (int) HighCutStage,
+              "The cut and peak groups should match their chain stages");
+
+//==============================================================================
+/**
+    Looking a parameter up by ID turns the std::string ID into a
+    juce::String and searches the tree's parameter map, which costs far more
+    than reading the value. So every parameter's value is looked up once,
+    here, and after that the settings are read straight from the atomics.
+
+    Each group also has a version that goes up whenever one of its
+    parameters changes. There's a listener per group doing the counting, so
+    a change never has to look at the parameter's ID to know which group
+    it's in. That matters because hosts can automate from the audio thread.
+
+    Read the versions before the settings. A parameter that changes in
+    between will have moved its version on too, so the next read is sure to
+    notice, and a set of settings is never marked newer than it is.
+*/
+class ChainParameters
+{
+public:
+    using Versions = std::array<juce::uint32, NumParameterGroups>;
+
+    // Just the values, for anything that reads the settings once and doesn't
+    // need to know what changed
+    struct Values
+    {
+        explicit Values(juce::AudioProcessorValueTreeState& ap_tree_state);
+
+        // Never allocates or locks, so it's fine on any thread
+        SimpleEQSettings load() const noexcept;
+
+    private:
+        struct BandValues
+        {
+            std::atomic<float>* enabled;
+            std::atomic<float>* type;
+            std::atomic<float>* frequency;
+            std::atomic<float>* gain;
+            std::atomic<float>* Q;
+        };
+
+        std::atomic<float>* lowCutFreq;
+        std::atomic<float>* lowCutSlope;
+        std::atomic<float>* peakFreq;
+        std::atomic<float>* peakGain;
+        std::atomic<float>* peakQ;
+        std::atomic<float>* highCutFreq;
+        std::atomic<float>* highCutSlope;
+
+        std::array<BandValues, numExtraBands> extraBands;
+
+        std::atomic<float>* midSide;
+        std::atomic<float>* sideLowCutFreq;
+        std::atomic<float>* sideLowCutSlope;
+        std::atomic<float>* sidePeakFreq;
+        std::atomic<float>* sidePeakGain;
+        std::atomic<float>* sidePeakQ;
+        std::atomic<float>* sideHighCutFreq;
+        std::atomic<float>* sideHighCutSlope;
+
+        std::atomic<float>* dynamicOn;
+        std::atomic<float>* dynamicThreshold;
+        std::atomic<float>* dynamicRatio;
+        std::atomic<float>* dynamicAttack;
+        std::atomic<float>* dynamicRelease;
+        std::atomic<float>* dynamicSidechain;
+    };
+
+    explicit ChainParameters(juce::AudioProcessorValueTreeState& ap_tree_state);
+    ~ChainParameters();
+
+    SimpleEQSettings load() const noexcept              { return values.load(); }
+
+    Versions getVersions() const noexcept;
+
+    // A bit (1 << group) for each group whose version differs
+    static int getChangedGroups(const Versions& before, const Versions& after) noexcept;
+
+    // The IDs of every parameter in a group
+    static juce::StringArray getParameterIDs(ParameterGroup group);
+
+private:
+    // Counts the changes to one group's parameters
+    struct GroupListener  : public juce::AudioProcessorValueTreeState::Listener
+    {
+        void parameterChanged(const juce::String&, float) override     { ++version; }
+
+        std::atomic<juce::uint32> version { 0 };
+    };
+
+    juce::AudioProcessorValueTreeState& ap_tree_state;
+    Values values;
+    std::array<GroupListener, NumParameterGroups> listeners;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChainParameters)
+};
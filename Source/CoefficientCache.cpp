@@ -0,0 +1,240 @@
+/*
+  ==============================================================================
+
+    This file contains the coefficient cache. The cut filter frequencies snap
+    to 1 Hz steps and there are only four slopes, so every possible cut
+    filter design for a sample rate fits in a table. The table is shared by
+    every plugin instance in the process.
+
+  ==============================================================================
+*/
+
+#include "CoefficientCache.h"
+
+namespace
+{
+    constexpr int numCutTypes = 2;
+    constexpr int numSlopes = 4;
+
+    // A slope of n has (n + 1) stages, so all four slopes together need
+    // 1 + 2 + 3 + 4 stages. These are where each slope's stages start.
+    constexpr std::array<int, numSlopes> firstStageForSlope { 0, 1, 3, 6 };
+    constexpr int stagesPerFrequency = 10;
+
+    int getNumStages(Slope slope) noexcept
+    {
+        return static_cast<int>(slope) + 1;
+    }
+
+    // Designs a cut filter the same way the processor always has, with
+    // juce::dsp::FilterDesign. This allocates.
+    void designCut(CutType type, float frequency, Slope slope, double sampleRate, std::array<BiquadCoefficients, 4>& coefficients)
+    {
+        int order = getNumStages(slope) * 2;
+
+        auto designed = type == CutType::lowCut
+            ? juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(frequency, sampleRate, order)
+            : juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(frequency, sampleRate, order);
+
+        coefficients.fill(passThroughCoefficients);
+
+        for (int i = 0; i < designed.size(); ++i)
+        {
+            auto& source = designed[i]->coefficients;
+            jassert(source.size() == (int) coefficients[(size_t) i].size());
+            std::copy(source.begin(), source.end(), coefficients[(size_t) i].begin());
+        }
+    }
+}
+
+//==============================================================================
+CoefficientCache::Table::Table(double rate)
+    : sampleRate(rate),
+      entryStates(new std::atomic<juce::uint8>[(size_t) (numCutTypes * numSlopes * numFrequencies)]()),
+      stages((size_t) (numCutTypes * stagesPerFrequency * numFrequencies))
+{
+}
+
+int CoefficientCache::Table::getFrequencyIndex(float frequency) const noexcept
+{
+    auto rounded = juce::roundToInt(frequency);
+
+    if (std::abs(frequency - (float) rounded) > 1.0e-3f
+        || rounded < minFrequency || rounded > maxFrequency)
+        return -1;
+
+    return rounded - minFrequency;
+}
+
+size_t CoefficientCache::Table::getEntryIndex(CutType type, Slope slope, int frequencyIndex) const noexcept
+{
+    return (size_t) (((int) type * numSlopes + (int) slope) * numFrequencies + frequencyIndex);
+}
+
+BiquadCoefficients* CoefficientCache::Table::getStages(CutType type, Slope slope, int frequencyIndex) const noexcept
+{
+    // Each (type, slope) gets its own run of the table so the stages for
+    // neighbouring frequencies sit next to each other
+    auto slopeStart = ((int) type * stagesPerFrequency + firstStageForSlope[(size_t) slope]) * numFrequencies;
+    return stages + slopeStart + frequencyIndex * getNumStages(slope);
+}
+
+bool CoefficientCache::Table::store(CutType type, Slope slope, int frequencyIndex, const std::array<BiquadCoefficients, 4>& coefficients)
+{
+    // Only the first thread to get here writes the entry. Anyone else who
+    // designed the same entry at the same time just uses their own copy.
+    auto& state = entryStates[getEntryIndex(type, slope, frequencyIndex)];
+    auto expected = static_cast<juce::uint8>(empty);
+
+    if (! state.compare_exchange_strong(expected, static_cast<juce::uint8>(filling), std::memory_order_acq_rel))
+        return false;
+
+    auto numStages = getNumStages(slope);
+    std::copy(coefficients.begin(), coefficients.begin() + numStages, getStages(type, slope, frequencyIndex));
+    filledBytes += (juce::int64) (numStages * sizeof(BiquadCoefficients));
+
+    state.store(ready, std::memory_order_release);
+    return true;
+}
+
+void CoefficientCache::Table::getCutCoefficients(CutType type, float frequency, Slope slope, std::array<BiquadCoefficients, 4>& coefficients)
+{
+    auto frequencyIndex = getFrequencyIndex(frequency);
+
+    if (frequencyIndex < 0)
+    {
+        ++misses;
+        designCut(type, frequency, slope, sampleRate, coefficients);
+        return;
+    }
+
+    if (entryStates[getEntryIndex(type, slope, frequencyIndex)].load(std::memory_order_acquire) == ready)
+    {
+        ++hits;
+        coefficients.fill(passThroughCoefficients);
+
+        auto* stored = getStages(type, slope, frequencyIndex);
+        std::copy(stored, stored + getNumStages(slope), coefficients.begin());
+        return;
+    }
+
+    ++misses;
+    designCut(type, frequency, slope, sampleRate, coefficients);
+    store(type, slope, frequencyIndex, coefficients);
+}
+
+void CoefficientCache::Table::fillAll(const std::function<bool()>& shouldExit)
+{
+    // The Butterworth designs are only valid up to Nyquist, so anything above
+    // that is left to be designed (and asserted on) if it's ever asked for
+    auto highestFrequency = juce::jmin(maxFrequency, (int) (sampleRate * 0.5));
+    std::array<BiquadCoefficients, 4> coefficients;
+
+    for (int type = 0; type < numCutTypes; ++type)
+    {
+        for (int slope = 0; slope < numSlopes; ++slope)
+        {
+            for (int frequency = minFrequency; frequency <= highestFrequency; ++frequency)
+            {
+                if (shouldExit())
+                    return;
+
+                auto cutType = static_cast<CutType>(type);
+                auto cutSlope = static_cast<Slope>(slope);
+                auto frequencyIndex = frequency - minFrequency;
+
+                if (entryStates[getEntryIndex(cutType, cutSlope, frequencyIndex)].load(std::memory_order_acquire) != empty)
+                    continue;
+
+                designCut(cutType, (float) frequency, cutSlope, sampleRate, coefficients);
+                store(cutType, cutSlope, frequencyIndex, coefficients);
+            }
+        }
+    }
+}
+
+//==============================================================================
+CoefficientCache::CoefficientCache()
+{
+}
+
+CoefficientCache::~CoefficientCache()
+{
+    precomputePool.removeAllJobs(true, 5000);
+}
+
+std::shared_ptr<CoefficientCache::Table> CoefficientCache::getTable(double sampleRate, FillMode fillMode)
+{
+    std::shared_ptr<Table> table;
+
+    {
+        const juce::ScopedLock sl(tablesLock);
+
+        // Forget the rates nobody's using any more
+        for (auto it = tables.begin(); it != tables.end();)
+            it = it->second.expired() ? tables.erase(it) : std::next(it);
+
+        auto& entry = tables[sampleRate];
+        table = entry.lock();
+
+        if (table == nullptr)
+        {
+            table = std::make_shared<Table>(sampleRate);
+            entry = table;
+        }
+    }
+
+    if (fillMode == FillMode::precompute)
+        startPrecompute(table);
+
+    return table;
+}
+
+void CoefficientCache::startPrecompute(const std::shared_ptr<Table>& table)
+{
+    // Each table only ever gets filled once
+    if (table->precomputeStarted.exchange(true))
+        return;
+
+    // The job keeps the table alive while it fills it, but gives up if it's
+    // the only one left holding it
+    precomputePool.addJob([table]
+    {
+        auto* job = juce::ThreadPoolJob::getCurrentThreadPoolJob();
+        table->fillAll([job, &table] { return (job != nullptr && job->shouldExit()) || table.use_count() == 1; });
+    });
+}
+
+CoefficientCache::Statistics CoefficientCache::getStatistics() const
+{
+    Statistics statistics;
+
+    const juce::ScopedLock sl(tablesLock);
+
+    for (auto& entry : tables)
+    {
+        auto tablePointer = entry.second.lock();
+
+        if (tablePointer == nullptr)
+            continue;
+
+        auto& table = *tablePointer;
+        ++statistics.numTables;
+        statistics.hits += table.hits.load();
+        statistics.misses += table.misses.load();
+        statistics.filledBytes += table.filledBytes.load();
+        statistics.reservedBytes += (juce::int64) (numCutTypes * stagesPerFrequency * numFrequencies * sizeof(BiquadCoefficients)
+                                                   + numCutTypes * numSlopes * numFrequencies * sizeof(std::atomic<juce::uint8>));
+    }
+
+    return statistics;
+}
+
+juce::String CoefficientCache::Statistics::toString() const
+{
+    return juce::String(numTables) + " table(s), "
+         + juce::String(hits) + " hits, " + juce::String(misses) + " misses ("
+         + juce::String(getHitRate() * 100.0, 1) + "% hit rate), "
+         + juce::File::descriptionOfSizeInBytes(filledBytes) + " filled of "
+         + juce::File::descriptionOfSizeInBytes(reservedBytes) + " reserved";
+}
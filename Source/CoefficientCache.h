@@ -0,0 +1,148 @@
+/*
+  ==============================================================================
+
+    This file contains the coefficient cache. The cut filter frequencies snap
+    to 1 Hz steps and there are only four slopes, so every possible cut
+    filter design for a sample rate fits in a table. The table is shared by
+    every plugin instance in the process.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SimpleEQSettings.h"
+#include "BiquadCoefficients.h"
+
+//==============================================================================
+/**
+    Process-wide cache of Butterworth cut filter designs. Get hold of it with
+    juce::SharedResourcePointer<CoefficientCache>.
+
+    By default the tables fill lazily: the first time a frequency and slope is
+    asked for it's designed and stored, after that it's a copy out of the
+    table. An instance can ask for a table in precompute mode instead, and
+    then the whole table is designed on a background thread straight away.
+    That costs the memory and a second or so of one core up front, in
+    exchange for never designing a cut on the design thread again.
+
+    A full table is around 8 MB, and with oversampling and rate changes an
+    instance can go through several rates. So each table only lives as long
+    as someone is holding on to it: once no instance is running at its
+    rate any more, it's freed.
+
+    The peak band isn't cached. It has three continuous parameters, so a
+    table would be far too big, and a single peak design is cheap anyway.
+*/
+class CoefficientCache
+{
+public:
+    enum class FillMode
+    {
+        lazy,
+        precompute
+    };
+
+    //==============================================================================
+    // All the cut filter designs for one sample rate. Entries are written
+    // once and never change afterwards, so any number of threads can read
+    // from the table at once.
+    class Table
+    {
+    public:
+        explicit Table(double sampleRate);
+
+        double getSampleRate() const noexcept { return sampleRate; }
+
+        // Fills coefficients with the stages for the given cut filter. Stages
+        // past the slope are set to pass-through. Frequencies that aren't on
+        // the 1 Hz grid are designed directly and not stored.
+        void getCutCoefficients(CutType type, float frequency, Slope slope, std::array<BiquadCoefficients, 4>& coefficients);
+
+        // Designs every entry that's still missing. Stops early if
+        // shouldExit returns true.
+        void fillAll(const std::function<bool()>& shouldExit);
+
+    private:
+        friend class CoefficientCache;
+
+        enum EntryState : juce::uint8
+        {
+            empty,
+            filling,
+            ready
+        };
+
+        int getFrequencyIndex(float frequency) const noexcept;
+        size_t getEntryIndex(CutType type, Slope slope, int frequencyIndex) const noexcept;
+        BiquadCoefficients* getStages(CutType type, Slope slope, int frequencyIndex) const noexcept;
+        bool store(CutType type, Slope slope, int frequencyIndex, const std::array<BiquadCoefficients, 4>& coefficients);
+
+        const double sampleRate;
+
+        // One state per (type, slope, frequency) and 1 + 2 + 3 + 4 = 10
+        // biquad stages per (type, frequency)
+        std::unique_ptr<std::atomic<juce::uint8>[]> entryStates;
+        juce::HeapBlock<BiquadCoefficients> stages;
+
+        std::atomic<juce::int64> hits { 0 }, misses { 0 }, filledBytes { 0 };
+        std::atomic<bool> precomputeStarted { false };
+
+        JUCE_DECLARE_NON_COPYABLE (Table)
+    };
+
+    //==============================================================================
+    struct Statistics
+    {
+        juce::int64 hits = 0;
+        juce::int64 misses = 0;
+
+        // Bytes holding designs that have been filled in, and the total
+        // bytes set aside for every table. Only tables still in use count.
+        juce::int64 filledBytes = 0;
+        juce::int64 reservedBytes = 0;
+
+        int numTables = 0;
+
+        double getHitRate() const noexcept
+        {
+            auto lookups = hits + misses;
+            return lookups > 0 ? (double) hits / (double) lookups : 0.0;
+        }
+
+        juce::String toString() const;
+    };
+
+    //==============================================================================
+    CoefficientCache();
+    ~CoefficientCache();
+
+    // Returns the table for the given sample rate, creating it if needed. The
+    // table is shared with anyone else using the same rate and is freed when
+    // the last of them lets go of it. In precompute mode the table is filled
+    // in the background, if nobody has started that already. Don't call this
+    // from the audio thread.
+    std::shared_ptr<Table> getTable(double sampleRate, FillMode fillMode = FillMode::lazy);
+
+    Statistics getStatistics() const;
+
+    // Frequency range covered by the tables. This matches the range of the
+    // LOW_CUT_FREQ and HIGH_CUT_FREQ parameters.
+    static constexpr int minFrequency = 20;
+    static constexpr int maxFrequency = 20000;
+    static constexpr int numFrequencies = maxFrequency - minFrequency + 1;
+
+private:
+    void startPrecompute(const std::shared_ptr<Table>& table);
+
+    // Only weak references, so the cache never keeps a table alive by
+    // itself. Entries whose table has gone are cleared out in getTable.
+    juce::CriticalSection tablesLock;
+    std::map<double, std::weak_ptr<Table>> tables;
+
+    // Declared last so its jobs are stopped before the cache goes away
+    juce::ThreadPool precomputePool { 1 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CoefficientCache)
+};
@@ -0,0 +1,186 @@
+/*
+  ==============================================================================
+
+    This file contains the coefficient engine. It designs the filter
+    coefficients away from the audio thread and hands them over to the
+    audio thread without locking or allocating.
+
+  ==============================================================================
+*/
+
+#include "CoefficientEngine.h"
+#include "BandArray.h"
+
+namespace
+{
+    // Anything longer than this is treated as a mistake in the design
+    constexpr double maximumTailSeconds = 10.0;
+
+    double getSideTailSamples(const SideSettings& side, double sampleRate) noexcept
+    {
+        std::array<BiquadCoefficients, 4> cut;
+        auto tail = getDecaySamples(makePeakCoefficients(sampleRate, side.peakFreq, side.peakQ,
+                                                         juce::Decibels::decibelsToGain(side.peakGain)),
+                                    tailDecibels);
+
+        makeCutCoefficients(CutType::lowCut, sampleRate, side.lowCutFreq, side.lowCutSlope, cut);
+
+        for (int stage = 0; stage <= side.lowCutSlope; ++stage)
+            tail += getDecaySamples(cut[(size_t) stage], tailDecibels);
+
+        makeCutCoefficients(CutType::highCut, sampleRate, side.highCutFreq, side.highCutSlope, cut);
+
+        for (int stage = 0; stage <= side.highCutSlope; ++stage)
+            tail += getDecaySamples(cut[(size_t) stage], tailDecibels);
+
+        return tail;
+    }
+
+    void copyCoefficients(const juce::dsp::IIR::Coefficients<float>& source, BiquadCoefficients& destination)
+    {
+        // Peak filters are second order, so there are always five
+        jassert(source.coefficients.size() == (int) destination.size());
+        std::copy(source.coefficients.begin(), source.coefficients.end(), destination.begin());
+    }
+}
+
+void designChainCoefficients(ChainCoefficients& chainCoefficients, CoefficientCache::Table& cacheTable)
+{
+    const auto& settings = chainCoefficients.settings;
+
+    auto peakCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(cacheTable.getSampleRate(), settings.peakFreq, settings.peakQ, juce::Decibels::decibelsToGain(settings.peakGain));
+    copyCoefficients(*peakCoefficients, chainCoefficients.peak);
+
+    // The cut filters are Butterworth designs whose order is based on the
+    // selected slope. Each 12 db/oct of slope is one more second order stage.
+    cacheTable.getCutCoefficients(CutType::lowCut, settings.lowCutFreq, settings.lowCutSlope, chainCoefficients.lowCut);
+    cacheTable.getCutCoefficients(CutType::highCut, settings.highCutFreq, settings.highCutSlope, chainCoefficients.highCut);
+
+    for (size_t band = 0; band < (size_t) numExtraBands; ++band)
+        chainCoefficients.extraBands[band] = BandArray::isActive(settings.extraBands[band])
+                                               ? makeBandCoefficients(cacheTable.getSampleRate(), settings.extraBands[band])
+                                               : passThroughCoefficients;
+
+    chainCoefficients.tailSamples = calculateTailSamples(chainCoefficients, cacheTable.getSampleRate());
+}
+
+int calculateTailSamples(const ChainCoefficients& chainCoefficients, double sampleRate) noexcept
+{
+    const auto& settings = chainCoefficients.settings;
+    auto tail = getDecaySamples(chainCoefficients.peak, tailDecibels);
+
+    for (int stage = 0; stage <= settings.lowCutSlope; ++stage)
+        tail += getDecaySamples(chainCoefficients.lowCut[(size_t) stage], tailDecibels);
+
+    for (int stage = 0; stage <= settings.highCutSlope; ++stage)
+        tail += getDecaySamples(chainCoefficients.highCut[(size_t) stage], tailDecibels);
+
+    for (size_t band = 0; band < (size_t) numExtraBands; ++band)
+        if (BandArray::isActive(settings.extraBands[band]))
+            tail += getDecaySamples(chainCoefficients.extraBands[band], tailDecibels);
+
+    // The side channel's bands are designed on the audio thread, so work
+    // out what they'll be here. Mid and side ring out side by side.
+    if (settings.midSide)
+        tail = juce::jmax(tail, getSideTailSamples(settings.side, sampleRate));
+
+    return (int) std::ceil(juce::jmin(tail, maximumTailSeconds * sampleRate));
+}
+
+//==============================================================================
+CoefficientEngine::CoefficientEngine(ChainParameters& parameters)
+    : chainParameters(parameters)
+{
+    designThread->addTimeSliceClient(this);
+}
+
+CoefficientEngine::~CoefficientEngine()
+{
+    // This waits for the background thread if it's in the middle of a design
+    designThread->removeTimeSliceClient(this);
+}
+
+void CoefficientEngine::prepare(double sampleRate, CoefficientCache::FillMode cacheFillMode)
+{
+    {
+        const juce::ScopedLock sl(designLock);
+        cacheTable = coefficientCache->getTable(sampleRate, cacheFillMode);
+    }
+    
+    currentSampleRate = sampleRate;
+    designAndPublish();
+}
+
+void CoefficientEngine::design(ChainCoefficients& chainCoefficients)
+{
+    const juce::ScopedLock sl(designLock);
+
+    // Nothing to design for until prepare has been called
+    jassert(cacheTable != nullptr);
+
+    if (cacheTable != nullptr)
+        designChainCoefficients(chainCoefficients, *cacheTable);
+}
+
+const ChainCoefficients* CoefficientEngine::pullLatest() noexcept
+{
+    // Nothing new since the last block
+    if ((sharedIndex.load(std::memory_order_acquire) & freshBit) == 0)
+        return nullptr;
+
+    // Hand our old slot back and take the fresh one
+    audioIndex = sharedIndex.exchange(audioIndex, std::memory_order_acq_rel) & ~freshBit;
+    return &slots[(size_t) audioIndex];
+}
+
+int CoefficientEngine::useTimeSlice()
+{
+    // The design thread is shared, so don't wait here for a ScopedBatch to
+    // finish. The host's callbacks run inside one, and every other instance
+    // would be stuck behind them. Skip this instance and try again soon.
+    const juce::ScopedTryLock stl(designLock);
+
+    if (! stl.isLocked())
+        return 1;
+
+    auto versions = chainParameters.getVersions();
+
+    if (currentSampleRate.load() > 0.0 && versions != checkedVersions)
+    {
+        checkedVersions = versions;
+        designAndPublish();
+    }
+
+    // Check back in a few milliseconds. When nothing has changed this is
+    // just a few atomic reads.
+    return 5;
+}
+
+void CoefficientEngine::publishChanges()
+{
+    const juce::ScopedLock sl(designLock);
+
+    auto versions = chainParameters.getVersions();
+
+    if (currentSampleRate.load() > 0.0 && versions != checkedVersions)
+    {
+        checkedVersions = versions;
+        designAndPublish();
+    }
+}
+
+void CoefficientEngine::designAndPublish()
+{
+    const juce::ScopedLock sl(designLock);
+
+    // Versions first, so a change while the settings are being read is
+    // picked up next time round
+    auto& chainCoefficients = slots[(size_t) designIndex];
+    chainCoefficients.versions = chainParameters.getVersions();
+    chainCoefficients.settings = chainParameters.load();
+    designChainCoefficients(chainCoefficients, *cacheTable);
+
+    // Publish the finished slot and take whichever one the audio thread
+    // isn't using as the next one to design into
+    designIndex = sharedIndex.exchange(designIndex | freshBit, std::memory_order_acq_rel) & ~freshBit;
+}
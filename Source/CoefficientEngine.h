@@ -0,0 +1,159 @@
+/*
+  ==============================================================================
+
+    This file contains the coefficient engine. It designs the filter
+    coefficients away from the audio thread and hands them over to the
+    audio thread without locking or allocating.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SimpleEQSettings.h"
+#include "BiquadCoefficients.h"
+#include "CoefficientCache.h"
+#include "ChainParameters.h"
+
+// Everything the audio thread needs to set up one processing chain. This is
+// plain data so it can be preallocated and copied around without touching
+// the heap. The low and high cut arrays have one entry per 12 db/oct stage;
+// only the first (slope + 1) entries are used. Extra bands that are switched
+// off are left as pass-through.
+struct ChainCoefficients
+{
+    SimpleEQSettings settings;
+
+    // The parameter versions the settings were read at. Comparing them with
+    // the last set's says which groups changed.
+    ChainParameters::Versions versions {};
+
+    std::array<BiquadCoefficients, 4> lowCut;
+    BiquadCoefficients peak { passThroughCoefficients };
+    std::array<BiquadCoefficients, 4> highCut;
+    std::array<BiquadCoefficients, numExtraBands> extraBands;
+
+    // How long the chain keeps ringing after its input stops, until it's
+    // below the noise floor. Filled in by designChainCoefficients.
+    int tailSamples = 0;
+
+    ChainCoefficients()
+    {
+        lowCut.fill(passThroughCoefficients);
+        highCut.fill(passThroughCoefficients);
+        extraBands.fill(passThroughCoefficients);
+    }
+};
+
+// Designs the coefficients for the given settings. The cut filters come out
+// of the shared cache table for the sample rate. Cache misses allocate (they
+// use juce::dsp::FilterDesign), so never call this from the audio thread.
+void designChainCoefficients(ChainCoefficients& chainCoefficients, CoefficientCache::Table& cacheTable);
+
+// The level the chain's tail has to fall to before it counts as silent
+constexpr double tailDecibels = -120.0;
+
+// Works out the tail length of the biquads the settings use. Each stage's
+// tail is added on as if it rang on for its full length after the stage
+// before it, which is the worst case for a cascade. Capped at ten
+// seconds.
+int calculateTailSamples(const ChainCoefficients& chainCoefficients, double sampleRate) noexcept;
+
+//==============================================================================
+/**
+    Watches the EQ parameters' versions and redesigns the coefficients
+    whenever one of them moves on. The design happens on a background thread
+    that's shared by every plugin instance in the process.
+
+    Finished designs are handed to the audio thread through a triple buffer:
+    the designer always owns one slot, the audio thread always owns another,
+    and the third is swapped between them with a single atomic exchange.
+    Neither side ever waits for the other.
+*/
+class CoefficientEngine  : private juce::TimeSliceClient
+{
+public:
+    explicit CoefficientEngine(ChainParameters& chainParameters);
+    ~CoefficientEngine() override;
+
+    // Called from prepareToPlay. Designs the coefficients for the new sample
+    // rate straight away so they're ready before the first block. The fill
+    // mode is how the cut filter cache's table for the rate gets filled.
+    void prepare(double sampleRate, CoefficientCache::FillMode cacheFillMode = CoefficientCache::FillMode::lazy);
+
+    // Called from the audio thread. Returns the newest coefficients if they've
+    // changed since the last call, otherwise nullptr. The returned set stays
+    // valid until the next call. Wait-free, never allocates.
+    const ChainCoefficients* pullLatest() noexcept;
+    
+    // Designs a set for the current sample rate, for anyone who wants
+    // coefficients ready ahead of time. Not for the audio thread.
+    void design(ChainCoefficients& chainCoefficients);
+
+    // Designs and publishes any parameter changes straight away on the
+    // calling thread, instead of leaving them for the design thread, so the
+    // next pullLatest is sure to see them. For benchmarks and tests that
+    // need to know which block picks a change up. Not for the audio thread.
+    void publishChanges();
+
+    // Holds off designing while several parameters change together, so the
+    // audio thread never picks up a set with only some of them changed. The
+    // design thread skips this instance while it's held, without holding up
+    // the others, and catches up as soon as this goes out of scope.
+    class ScopedBatch
+    {
+    public:
+        explicit ScopedBatch(CoefficientEngine& engine) : lock(engine.designLock) {}
+
+    private:
+        const juce::ScopedLock lock;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedBatch)
+    };
+    
+    // Hit rate and memory use of the cut filter cache shared by every instance
+    CoefficientCache::Statistics getCacheStatistics() const    { return coefficientCache->getStatistics(); }
+
+private:
+    // The background thread that does the designing for every instance
+    struct DesignThread  : public juce::TimeSliceThread
+    {
+        DesignThread() : juce::TimeSliceThread("SimpleEQ Coefficient Designer") { startThread(); }
+        ~DesignThread() override { stopThread(1000); }
+    };
+
+    int useTimeSlice() override;
+    void designAndPublish();
+
+    ChainParameters& chainParameters;
+    juce::SharedResourcePointer<DesignThread> designThread;
+    juce::SharedResourcePointer<CoefficientCache> coefficientCache;
+
+    std::atomic<double> currentSampleRate { 0.0 };
+    
+    // The versions the design thread or publishChanges last saw. Guarded by
+    // designLock.
+    ChainParameters::Versions checkedVersions {};
+
+    // Stops prepare(), design() and the background thread from designing at
+    // the same time, and holds designs off during a ScopedBatch. The
+    // background thread only ever tries it, so a batch never blocks it. The
+    // audio thread never touches it.
+    juce::CriticalSection designLock;
+    
+    // The cache table for the current sample rate. Holding it keeps it in
+    // the cache; the table for the last rate is let go in prepare. Guarded
+    // by designLock.
+    std::shared_ptr<CoefficientCache::Table> cacheTable;
+
+    // Triple buffer. The index in sharedIndex has freshBit set when it holds
+    // a set the audio thread hasn't picked up yet.
+    static constexpr int freshBit = 4;
+    std::array<ChainCoefficients, 3> slots;
+    int designIndex { 0 };
+    int audioIndex { 1 };
+    std::atomic<int> sharedIndex { 2 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CoefficientEngine)
+};
@@ -0,0 +1,176 @@
+/*
+  ==============================================================================
+
+    This file contains the peak band's dynamics: an envelope follower on the
+    level in the band, and the cheap peak design that follows it.
+
+  ==============================================================================
+*/
+
+#include "DynamicPeak.h"
+
+namespace
+{
+    // The gain can't go past the peak gain parameter's own range
+    constexpr float maxGainDecibels = 24.f;
+
+    // A one pole smoothing coefficient for a time constant in milliseconds
+    float getTimeCoefficient(float milliseconds, double sampleRate) noexcept
+    {
+        return (float) std::exp(-1.0 / (juce::jmax(0.01, (double) milliseconds) * 0.001 * sampleRate));
+    }
+}
+
+void DynamicPeak::prepare(double newHostSampleRate, double newFilterSampleRate, int maximumBlockSize)
+{
+    hostSampleRate = newHostSampleRate;
+    filterSampleRate = newFilterSampleRate;
+
+    // A chunk is never shorter than one sample, so this covers any chunk size
+    chunkReductions.assign((size_t) juce::jmax(1, maximumBlockSize), 0.f);
+    numChunks = 0;
+
+    // Force everything that depends on the rates to be worked out again
+    bandPassFrequency = bandPassQ = 0.f;
+    designFrequency = designQ = 0.f;
+    attackMs = releaseMs = 0.f;
+
+    reset();
+}
+
+void DynamicPeak::reset() noexcept
+{
+    s1 = s2 = 0.f;
+    envelope = 0.f;
+}
+
+void DynamicPeak::updateDetector(const SimpleEQSettings& settings) noexcept
+{
+    if (settings.peakFreq != bandPassFrequency || settings.peakQ != bandPassQ)
+    {
+        // The cookbook band-pass with 0 dB at its centre, so a tone at the
+        // peak's frequency reads at its own level
+        bandPassFrequency = settings.peakFreq;
+        bandPassQ = settings.peakQ;
+
+        auto omega = juce::MathConstants<double>::twoPi * juce::jmax(2.0, (double) bandPassFrequency) / hostSampleRate;
+        auto bandAlpha = std::sin(omega) / (2.0 * (double) bandPassQ);
+        auto a0Inverse = 1.0 / (1.0 + bandAlpha);
+
+        bandPass = { (float) (bandAlpha * a0Inverse), 0.f, (float) (-bandAlpha * a0Inverse),
+                     (float) (-2.0 * std::cos(omega) * a0Inverse), (float) ((1.0 - bandAlpha) * a0Inverse) };
+    }
+
+    if (settings.dynamic.attackMs != attackMs || settings.dynamic.releaseMs != releaseMs)
+    {
+        attackMs = settings.dynamic.attackMs;
+        releaseMs = settings.dynamic.releaseMs;
+        attackCoefficient = getTimeCoefficient(attackMs, hostSampleRate);
+        releaseCoefficient = getTimeCoefficient(releaseMs, hostSampleRate);
+    }
+}
+
+template <typename SampleType>
+void DynamicPeak::analyse(const juce::dsp::AudioBlock<SampleType>& detectorBlock, const SimpleEQSettings& settings, int chunkSize) noexcept
+{
+    jassert(chunkSize > 0);
+
+    updateDetector(settings);
+
+    auto numSamples = detectorBlock.getNumSamples();
+    auto numChannels = detectorBlock.getNumChannels();
+    auto channelGain = numChannels > 0 ? 1.f / (float) numChannels : 0.f;
+
+    auto threshold = settings.dynamic.threshold;
+    auto slope = 1.f - 1.f / juce::jmax(1.f, settings.dynamic.ratio);
+
+    // Work on locals so they can stay in registers
+    auto b0 = bandPass[0], b2 = bandPass[2], a1 = bandPass[3], a2 = bandPass[4];
+    auto state1 = s1, state2 = s2, level = envelope;
+
+    numChunks = 0;
+
+    for (size_t start = 0; start < numSamples; start += (size_t) chunkSize)
+    {
+        auto end = juce::jmin(numSamples, start + (size_t) chunkSize);
+        auto chunkLevel = 0.f;
+
+        for (size_t i = start; i < end; ++i)
+        {
+            auto input = 0.f;
+
+            for (size_t channel = 0; channel < numChannels; ++channel)
+                input += (float) detectorBlock.getChannelPointer(channel)[i];
+
+            input *= channelGain;
+
+            // The band-pass has no b1, and its b2 is -b0
+            auto output = b0 * input + state1;
+            state1 = state2 - a1 * output;
+            state2 = b2 * input - a2 * output;
+
+            auto rectified = std::abs(output);
+            auto coefficient = rectified > level ? attackCoefficient : releaseCoefficient;
+            level = rectified + coefficient * (level - rectified);
+
+            chunkLevel = juce::jmax(chunkLevel, level);
+        }
+
+        // One log per chunk turns the loudest point of it into how far over
+        // the threshold it went
+        if (numChunks < (int) chunkReductions.size())
+        {
+            auto over = juce::Decibels::gainToDecibels(chunkLevel) - threshold;
+            chunkReductions[(size_t) numChunks++] = juce::jmax(0.f, over) * slope;
+        }
+        else
+        {
+            // Only if the host sends a bigger block than it promised
+            jassertfalse;
+        }
+    }
+
+    s1 = state1;
+    s2 = state2;
+    envelope = level;
+}
+
+float DynamicPeak::getGainDecibels(int chunk, const SimpleEQSettings& settings) const noexcept
+{
+    auto reduction = numChunks > 0 ? chunkReductions[(size_t) juce::jlimit(0, numChunks - 1, chunk)] : 0.f;
+    return juce::jlimit(-maxGainDecibels, maxGainDecibels, settings.peakGain - reduction);
+}
+
+template <typename SampleType>
+BasicBiquadCoefficients<SampleType> DynamicPeak::makeCoefficients(const SimpleEQSettings& settings, float gainDecibels) noexcept
+{
+    if (settings.peakFreq != designFrequency || settings.peakQ != designQ)
+    {
+        designFrequency = settings.peakFreq;
+        designQ = settings.peakQ;
+
+        auto omega = juce::MathConstants<double>::twoPi * juce::jmax(2.0, (double) designFrequency) / filterSampleRate;
+        cosOmega = std::cos(omega);
+        alpha = std::sin(omega) / (2.0 * (double) designQ);
+    }
+
+    // The same design as makePeakCoefficients. Normalising by
+    // a0 = 1 + alpha / A is a multiply by A / (A + alpha), which leaves a
+    // single divide.
+    auto A = std::exp((double) gainDecibels * (std::log(10.0) / 40.0));
+    auto reciprocal = 1.0 / (A + alpha);
+    auto a0Inverse = A * reciprocal;
+    auto alphaTimesA = alpha * A;
+    auto a1 = -2.0 * cosOmega * a0Inverse;
+
+    return { (SampleType) ((1.0 + alphaTimesA) * a0Inverse),
+             (SampleType) a1,
+             (SampleType) ((1.0 - alphaTimesA) * a0Inverse),
+             (SampleType) a1,
+             (SampleType) ((A - alpha) * reciprocal) };
+}
+
+template void DynamicPeak::analyse<float>(const juce::dsp::AudioBlock<float>&, const SimpleEQSettings&, int) noexcept;
+template void DynamicPeak::analyse<double>(const juce::dsp::AudioBlock<double>&, const SimpleEQSettings&, int) noexcept;
+template BasicBiquadCoefficients<float> DynamicPeak::makeCoefficients<float>(const SimpleEQSettings&, float) noexcept;
+template BasicBiquadCoefficients<double> DynamicPeak::makeCoefficients<double>(const SimpleEQSettings&, float) noexcept;
@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    This file contains the peak band's dynamics: an envelope follower on the
+    level in the band, and the cheap peak design that follows it.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "BiquadCoefficients.h"
+
+//==============================================================================
+/**
+    Turns the peak band into a dynamic EQ. Its gain drops below the peak
+    gain setting by however much the level in the band goes over the
+    threshold, scaled by the ratio:
+
+      gain = peakGain - max(0, level - threshold) * (1 - 1 / ratio)
+
+    The level comes from the main input or the sidechain, summed to mono,
+    through a band-pass at the peak's frequency and Q (so it's the level
+    the band actually acts on), then rectified and followed with separate
+    attack and release times. The detector runs at the host's rate on the
+    whole block before any filtering, and keeps the gain reduction for
+    each chunk of it. The filters then take one new peak design per chunk.
+
+    Since only the gain changes between chunks, the parts of the cookbook
+    peak that depend on the frequency and Q are worked out once, when they
+    change, and each new design is just A = 10^(gain / 40), a handful of
+    multiplies and one divide to normalise. Nothing here allocates after
+    prepare.
+*/
+class DynamicPeak
+{
+public:
+    DynamicPeak() = default;
+
+    // The detector runs at the host's rate and the designs are for the rate
+    // the filters run at. Sizes the per-chunk storage for the biggest host
+    // block, so call this from prepareToPlay.
+    void prepare(double hostSampleRate, double filterSampleRate, int maximumBlockSize);
+
+    // Clears the envelope
+    void reset() noexcept;
+
+    // Runs the detector over a block of the input, in chunks of chunkSize
+    // samples, and keeps one gain reduction for each chunk
+    template <typename SampleType>
+    void analyse(const juce::dsp::AudioBlock<SampleType>& detectorBlock, const SimpleEQSettings& settings, int chunkSize) noexcept;
+
+    // The peak's gain for a chunk of the last analysed block, in decibels
+    float getGainDecibels(int chunk, const SimpleEQSettings& settings) const noexcept;
+
+    // The peak biquad at this gain, for the frequency and Q in settings
+    template <typename SampleType>
+    BasicBiquadCoefficients<SampleType> makeCoefficients(const SimpleEQSettings& settings, float gainDecibels) noexcept;
+
+private:
+    // The band-pass in front of the detector, in transposed direct form
+    void updateDetector(const SimpleEQSettings& settings) noexcept;
+
+    double hostSampleRate = 44100.0;
+    double filterSampleRate = 44100.0;
+
+    // Detector
+    std::array<float, 5> bandPass { 1.f, 0.f, 0.f, 0.f, 0.f };
+    float bandPassFrequency = 0.f, bandPassQ = 0.f;
+    float s1 = 0.f, s2 = 0.f;
+    float envelope = 0.f;
+    float attackMs = 0.f, releaseMs = 0.f;
+    float attackCoefficient = 0.f, releaseCoefficient = 0.f;
+
+    // One gain reduction in decibels per chunk of the last block
+    std::vector<float> chunkReductions;
+    int numChunks = 0;
+
+    // The frequency and Q dependent parts of the peak design
+    float designFrequency = 0.f, designQ = 0.f;
+    double cosOmega = 1.0, alpha = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DynamicPeak)
+};
@@ -0,0 +1,310 @@
+/*
+  ==============================================================================
+
+    This file contains the linear phase engine. It turns the EQ's magnitude
+    response into one long symmetric FIR and runs it with partitioned FFT
+    convolution.
+
+  ==============================================================================
+*/
+
+#include "LinearPhaseEngine.h"
+#include "ResponseCurve.h"
+
+namespace
+{
+    // The design FFT is this many times longer than the kernel. Sampling the
+    // magnitude that finely keeps the ideal response's time aliasing out of
+    // the part that's kept.
+    constexpr int designPadding = 4;
+
+    // The convolution's first partition. The rest of the kernel goes in
+    // bigger ones, which is what keeps long kernels cheap.
+    constexpr int convolutionHeadSize = 512;
+}
+
+//==============================================================================
+int LinearPhaseEngine::getKernelSizeForChoice(int choiceIndex) noexcept
+{
+    return juce::jmin(maxKernelSize, minKernelSize << juce::jmax(0, choiceIndex));
+}
+
+int LinearPhaseEngine::getChoiceForKernelSize(int kernelSize) noexcept
+{
+    int choiceIndex = 0;
+
+    while (getKernelSizeForChoice(choiceIndex) < juce::jmin(kernelSize, maxKernelSize))
+        ++choiceIndex;
+
+    return choiceIndex;
+}
+
+juce::StringArray LinearPhaseEngine::getKernelSizeChoices()
+{
+    juce::StringArray choices;
+
+    for (int size = minKernelSize; size <= maxKernelSize; size *= 2)
+        choices.add(juce::String(size));
+
+    return choices;
+}
+
+LinearPhaseEngine::LinearPhaseEngine(ChainParameters& parameters)
+    : chainParameters(parameters)
+{
+}
+
+LinearPhaseEngine::~LinearPhaseEngine()
+{
+    release();
+}
+
+void LinearPhaseEngine::prepare(const juce::dsp::ProcessSpec& spec, int newKernelSize)
+{
+    // Only instances in linear phase mode get prepared, so only they pay
+    // for a thread
+    designThread.addTimeSliceClient(this);
+    designThread.startThread();
+
+    const juce::ScopedLock sl(designLock);
+
+    sampleRate = spec.sampleRate;
+    kernelSize = juce::nextPowerOfTwo(juce::jlimit(minKernelSize, maxKernelSize, newKernelSize));
+
+    auto designSize = kernelSize * designPadding;
+    fft = std::make_unique<juce::dsp::FFT>(juce::roundToInt(std::log2((double) designSize)));
+    spectrum.assign((size_t) designSize * 2, 0.f);
+    kernels.setSize(2, kernelSize);
+    isMidSide = spec.numChannels == 2;
+
+    // A window one sample longer than the kernel, so its peak lands on the
+    // kernel's centre sample and the kernel is exactly symmetric about it
+    window.resize((size_t) kernelSize + 1);
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), window.size(),
+                                                             juce::dsp::WindowingFunction<float>::blackman, false);
+
+    convolutions.clear();
+
+    for (juce::uint32 channel = 0; channel < spec.numChannels; channel += 2)
+        convolutions.add(new juce::dsp::Convolution(juce::dsp::Convolution::NonUniform { convolutionHeadSize }, *convolutionQueue));
+
+    // Load the first kernel before preparing, so the convolution starts out
+    // with it rather than crossfading to it
+    designedVersions = chainParameters.getVersions();
+    designKernels(chainParameters.load());
+    loadKernels();
+
+    for (int pair = 0; pair < convolutions.size(); ++pair)
+    {
+        auto pairSpec = spec;
+        pairSpec.numChannels = juce::jmin((juce::uint32) 2, spec.numChannels - (juce::uint32) pair * 2);
+        convolutions.getUnchecked(pair)->prepare(pairSpec);
+    }
+
+    conversionBuffer.setSize((int) spec.numChannels, (int) spec.maximumBlockSize);
+
+    isPrepared = true;
+}
+
+void LinearPhaseEngine::release()
+{
+    // This waits for the design thread if it's in the middle of a design
+    designThread.removeTimeSliceClient(this);
+    designThread.stopThread(1000);
+
+    const juce::ScopedLock sl(designLock);
+
+    isPrepared = false;
+    convolutions.clear();
+    fft.reset();
+    spectrum = {};
+    window = {};
+    kernels.setSize(0, 0);
+    conversionBuffer.setSize(0, 0);
+}
+
+int LinearPhaseEngine::getLatencySamples() const noexcept
+{
+    auto convolutionLatency = convolutions.isEmpty() ? 0 : convolutions.getFirst()->getLatency();
+    return kernelSize / 2 + convolutionLatency;
+}
+
+void LinearPhaseEngine::process(const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    auto numChannels = block.getNumChannels();
+
+    if (isMidSide && numChannels == 2 && ! convolutions.isEmpty())
+    {
+        auto* left = block.getChannelPointer(0);
+        auto* right = block.getChannelPointer(1);
+        auto numSamples = block.getNumSamples();
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            auto mid = (left[i] + right[i]) * 0.5f;
+            auto side = (left[i] - right[i]) * 0.5f;
+            left[i] = mid;
+            right[i] = side;
+        }
+
+        juce::dsp::ProcessContextReplacing<float> context(block);
+        convolutions.getFirst()->process(context);
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            auto mid = left[i];
+            auto side = right[i];
+            left[i] = mid + side;
+            right[i] = mid - side;
+        }
+
+        return;
+    }
+
+    for (int pair = 0; pair < convolutions.size(); ++pair)
+    {
+        auto firstChannel = (size_t) pair * 2;
+
+        if (firstChannel >= numChannels)
+            break;
+
+        auto pairBlock = block.getSubsetChannelBlock(firstChannel, juce::jmin((size_t) 2, numChannels - firstChannel));
+        juce::dsp::ProcessContextReplacing<float> context(pairBlock);
+        convolutions.getUnchecked(pair)->process(context);
+    }
+}
+
+void LinearPhaseEngine::process(const juce::dsp::AudioBlock<double>& block) noexcept
+{
+    auto numChannels = block.getNumChannels();
+    auto numSamples = block.getNumSamples();
+
+    // The buffer is sized in prepare, so this only fails if the host sends
+    // a bigger block than it promised
+    if (numChannels > (size_t) conversionBuffer.getNumChannels() || numSamples > (size_t) conversionBuffer.getNumSamples())
+    {
+        jassertfalse;
+        return;
+    }
+
+    auto floatBlock = juce::dsp::AudioBlock<float>(conversionBuffer)
+                          .getSubsetChannelBlock(0, numChannels)
+                          .getSubBlock(0, numSamples);
+
+    for (size_t channel = 0; channel < numChannels; ++channel)
+        std::transform(block.getChannelPointer(channel), block.getChannelPointer(channel) + numSamples,
+                       floatBlock.getChannelPointer(channel), [](double sample) { return (float) sample; });
+
+    process(floatBlock);
+
+    for (size_t channel = 0; channel < numChannels; ++channel)
+        std::transform(floatBlock.getChannelPointer(channel), floatBlock.getChannelPointer(channel) + numSamples,
+                       block.getChannelPointer(channel), [](float sample) { return (double) sample; });
+}
+
+void LinearPhaseEngine::reset() noexcept
+{
+    for (auto* convolution : convolutions)
+        convolution->reset();
+}
+
+int LinearPhaseEngine::useTimeSlice()
+{
+    // prepare and release hold the lock while they swap the scratch and the
+    // convolutions, so rather than wait for them, come back shortly
+    const juce::ScopedTryLock stl(designLock);
+
+    if (! stl.isLocked())
+        return 1;
+
+    if (isPrepared)
+    {
+        // The dynamics don't run in linear phase mode, so turning their
+        // knobs leaves the kernel alone
+        auto versions = chainParameters.getVersions();
+        auto changedGroups = ChainParameters::getChangedGroups(designedVersions, versions);
+        designedVersions = versions;
+
+        if ((changedGroups & ~(1 << DynamicGroup)) != 0)
+        {
+            designKernels(chainParameters.load());
+            loadKernels();
+        }
+    }
+
+    // A knob being dragged sends a stream of changes. Checking every 20 ms
+    // designs at most 50 kernels a second, each crossfaded from the last.
+    return 20;
+}
+
+void LinearPhaseEngine::designKernels(const SimpleEQSettings& settings)
+{
+    designKernel(settings, 0);
+
+    // Only the side channel's three bands apply to it, as in the IIR path
+    if (isMidSide && settings.midSide)
+        designKernel(getSideChannelSettings(settings), 1);
+    else
+        kernels.copyFrom(1, 0, kernels, 0, 0, kernelSize);
+}
+
+void LinearPhaseEngine::designKernel(const SimpleEQSettings& settings, int channel)
+{
+    ResponseCurve::DoubleBiquads biquads;
+    auto numBiquads = ResponseCurve::getBiquads(settings, sampleRate * evaluationOversampling, biquads);
+
+    // The zero phase spectrum: the combined magnitude at every bin, as
+    // interleaved real and imaginary parts
+    auto designSize = kernelSize * designPadding;
+    auto omegaPerBin = juce::MathConstants<double>::twoPi / ((double) designSize * evaluationOversampling);
+
+    std::fill(spectrum.begin(), spectrum.end(), 0.f);
+
+    for (int bin = 0; bin <= designSize / 2; ++bin)
+    {
+        auto omega = omegaPerBin * bin;
+        auto cosOmega = std::cos(omega);
+        auto cosTwoOmega = std::cos(2.0 * omega);
+        auto magnitudeSquared = 1.0;
+
+        for (int i = 0; i < numBiquads; ++i)
+            magnitudeSquared *= ResponseCurve::getMagnitudeSquared(biquads[(size_t) i], cosOmega, cosTwoOmega);
+
+        spectrum[(size_t) bin * 2] = (float) std::sqrt(magnitudeSquared);
+    }
+
+    // Back to a zero phase impulse response, centred on sample 0 and
+    // wrapping round to the end. Shift it to the middle of the kernel and
+    // window it.
+    fft->performRealOnlyInverseTransform(spectrum.data());
+
+    auto* destination = kernels.getWritePointer(channel);
+
+    for (int i = 0; i < kernelSize; ++i)
+    {
+        auto source = (i - kernelSize / 2 + designSize) % designSize;
+        destination[i] = spectrum[(size_t) source] * window[(size_t) i];
+    }
+}
+
+void LinearPhaseEngine::loadKernels()
+{
+    // Each convolution takes its own copy, and does the rest of the work on
+    // the convolution queue's thread. In Mid/Side the one convolution gets
+    // both kernels, one per channel; otherwise every channel gets the first.
+    auto numKernels = isMidSide ? 2 : 1;
+
+    for (auto* convolution : convolutions)
+    {
+        juce::AudioBuffer<float> copy(numKernels, kernelSize);
+
+        for (int channel = 0; channel < numKernels; ++channel)
+            copy.copyFrom(channel, 0, kernels, channel, 0, kernelSize);
+
+        convolution->loadImpulseResponse(std::move(copy), sampleRate,
+                                         isMidSide ? juce::dsp::Convolution::Stereo::yes
+                                                   : juce::dsp::Convolution::Stereo::no,
+                                         juce::dsp::Convolution::Trim::no,
+                                         juce::dsp::Convolution::Normalise::no);
+    }
+}
@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    This file contains the linear phase engine. It turns the EQ's magnitude
+    response into one long symmetric FIR and runs it with partitioned FFT
+    convolution.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CoefficientEngine.h"
+
+//==============================================================================
+/**
+    The kernel is designed on a background thread of the engine's own,
+    whenever one of the EQ parameters changes:
+
+      - the magnitude of every band the IIR path would run is multiplied
+        together at each bin of a large FFT, with zero phase
+      - an inverse FFT gives the zero phase impulse response, which is
+        centred in kernelSize samples and Blackman windowed
+
+    The result is symmetric, so the only thing it does to the phase is delay
+    everything by kernelSize / 2 samples. The bands are designed at
+    evaluationOversampling times the sample rate before their magnitude is
+    taken, so the curve isn't cramped near Nyquist the way the bilinear
+    transform's is. A long kernel takes a while to design, so the thread
+    only runs while the engine is prepared and isn't shared: it never holds
+    up the coefficient designs, or another instance's kernels.
+
+    juce::dsp::Convolution does the filtering: non-uniformly partitioned, so
+    the cost stays low with long kernels, and with zero latency of its own.
+    It takes each new kernel on its own background thread and crossfades to
+    it on the audio thread, so parameter changes never click. It handles at
+    most two channels, so there's one per pair of channels.
+
+    With two channels, the engine always runs in Mid/Side. The mid channel
+    gets a kernel designed from the usual bands, and the side channel one
+    from the side bands when Mid/Side is on, or a copy of the mid one when
+    it's off, which comes out the same as running left and right. That
+    way, switching Mid/Side is just another kernel change, crossfaded like
+    the rest.
+*/
+class LinearPhaseEngine  : private juce::TimeSliceClient
+{
+public:
+    static constexpr int minKernelSize = 1024;
+    static constexpr int maxKernelSize = 65536;
+    static constexpr int defaultKernelSize = 8192;
+    static constexpr int evaluationOversampling = 4;
+
+    // The kernel sizes are offered as choices, from minKernelSize up to
+    // maxKernelSize in powers of two. Sizes in between round up.
+    static int getKernelSizeForChoice(int choiceIndex) noexcept;
+    static int getChoiceForKernelSize(int kernelSize) noexcept;
+    static juce::StringArray getKernelSizeChoices();
+
+    explicit LinearPhaseEngine(ChainParameters& chainParameters);
+    ~LinearPhaseEngine() override;
+
+    // Designs the first kernel straight away and sets up the convolution.
+    // kernelSize is rounded up to a power of two between minKernelSize and
+    // maxKernelSize. Allocates, so call from prepareToPlay.
+    void prepare(const juce::dsp::ProcessSpec& spec, int kernelSize);
+
+    // Frees the kernels and stops the design thread
+    void release();
+
+    int getKernelSize() const noexcept          { return kernelSize; }
+
+    // The delay the filter adds: half the kernel, plus whatever the
+    // convolution adds (nothing, as it's set up here)
+    int getLatencySamples() const noexcept;
+
+    // Called from the audio thread. Never allocates or waits.
+    void process(const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    // The convolution is float only, so the block goes through a float copy
+    void process(const juce::dsp::AudioBlock<double>& block) noexcept;
+
+    void reset() noexcept;
+
+private:
+    int useTimeSlice() override;
+    void designKernels(const SimpleEQSettings& settings);
+    void designKernel(const SimpleEQSettings& settings, int channel);
+    void loadKernels();
+
+    ChainParameters& chainParameters;
+    juce::TimeSliceThread designThread { "SimpleEQ Linear Phase Designer" };
+    juce::SharedResourcePointer<juce::dsp::ConvolutionMessageQueue> convolutionQueue;
+
+    std::atomic<bool> isPrepared { false };
+
+    // The versions of the parameters the kernel was last designed from.
+    // Guarded by designLock.
+    ChainParameters::Versions designedVersions {};
+
+    // Stops prepare and release from changing anything under the design
+    // thread. The design thread only ever tries it, and the audio thread
+    // never touches it.
+    juce::CriticalSection designLock;
+
+    double sampleRate = 0.0;
+    int kernelSize = 0;
+
+    // True when there are just two channels, which then run as mid and side
+    bool isMidSide = false;
+
+    // Scratch for the design, sized in prepare. Guarded by designLock. The
+    // kernels are the mid (or only) one, then the side one.
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> spectrum, window;
+    juce::AudioBuffer<float> kernels;
+
+    juce::OwnedArray<juce::dsp::Convolution> convolutions;
+    juce::AudioBuffer<float> conversionBuffer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LinearPhaseEngine)
+};
@@ -0,0 +1,204 @@
+/*
+  ==============================================================================
+
+    This file contains the load meter. It times every processBlock call and
+    keeps lock-free statistics on how much of the audio callback's budget
+    each instance is using.
+
+  ==============================================================================
+*/
+
+#include "LoadMeter.h"
+
+LoadMeter::LoadMeter()
+    : ticksPerSecond((double) juce::Time::getHighResolutionTicksPerSecond())
+{
+    clear();
+}
+
+void LoadMeter::prepare(double sampleRate)
+{
+    ticksPerSample = sampleRate > 0.0 ? ticksPerSecond / sampleRate : 0.0;
+    clear();
+}
+
+void LoadMeter::clear() noexcept
+{
+    for (auto& bucket : histogram)
+        bucket.store(0, std::memory_order_relaxed);
+
+    numBlocks.store(0, std::memory_order_relaxed);
+    numOverruns.store(0, std::memory_order_relaxed);
+    totalTicks.store(0, std::memory_order_relaxed);
+    totalBudgetTicks.store(0, std::memory_order_relaxed);
+    totalCoefficientTicks.store(0, std::memory_order_relaxed);
+    maxTicks.store(0, std::memory_order_relaxed);
+    maxLoad.store(0.0, std::memory_order_relaxed);
+    totalElidedBiquads.store(0, std::memory_order_relaxed);
+    totalBiquads.store(0, std::memory_order_relaxed);
+}
+
+void LoadMeter::addBlock(const ScopedBlock& block, juce::int64 blockTicks) noexcept
+{
+    if (resetRequested.load(std::memory_order_relaxed))
+    {
+        resetRequested.store(false, std::memory_order_relaxed);
+        clear();
+    }
+
+    auto budgetTicks = (juce::int64) (ticksPerSample * block.numSamples);
+
+    if (budgetTicks <= 0)
+        return;
+
+    auto load = (double) blockTicks / (double) budgetTicks;
+    auto bucket = juce::jlimit(0, numBuckets - 1, (int) (load * bucketsPerUnitLoad));
+
+    add(histogram[(size_t) bucket], (juce::uint32) 1);
+    add(numBlocks, (juce::int64) 1);
+    add(totalTicks, blockTicks);
+    add(totalBudgetTicks, budgetTicks);
+    add(totalCoefficientTicks, block.coefficientTicks);
+    add(totalElidedBiquads, (juce::int64) block.numElidedBiquads);
+    add(totalBiquads, (juce::int64) block.numBiquads);
+
+    if (load > 1.0)
+        add(numOverruns, (juce::int64) 1);
+
+    if (load > maxLoad.load(std::memory_order_relaxed))
+        maxLoad.store(load, std::memory_order_relaxed);
+
+    if (blockTicks > maxTicks.load(std::memory_order_relaxed))
+        maxTicks.store(blockTicks, std::memory_order_relaxed);
+}
+
+LoadMeter::Snapshot LoadMeter::getSnapshot() const
+{
+    Snapshot snapshot;
+
+    snapshot.numBlocks = numBlocks.load(std::memory_order_relaxed);
+    snapshot.numOverruns = numOverruns.load(std::memory_order_relaxed);
+    snapshot.maxLoad = maxLoad.load(std::memory_order_relaxed);
+    snapshot.maxBlockMicroseconds = (double) maxTicks.load(std::memory_order_relaxed) * 1.0e6 / ticksPerSecond;
+
+    auto total = totalTicks.load(std::memory_order_relaxed);
+    auto budget = totalBudgetTicks.load(std::memory_order_relaxed);
+    auto coefficients = totalCoefficientTicks.load(std::memory_order_relaxed);
+
+    if (budget > 0)
+        snapshot.averageLoad = (double) total / (double) budget;
+
+    if (total > 0)
+    {
+        snapshot.coefficientFraction = juce::jlimit(0.0, 1.0, (double) coefficients / (double) total);
+        snapshot.filterFraction = 1.0 - snapshot.coefficientFraction;
+    }
+
+    auto biquads = totalBiquads.load(std::memory_order_relaxed);
+
+    if (biquads > 0)
+        snapshot.elidedBiquadFraction = (double) totalElidedBiquads.load(std::memory_order_relaxed) / (double) biquads;
+
+    // Walk the histogram for the percentiles. The counts are read one at a
+    // time, so use their own total rather than numBlocks.
+    std::array<juce::uint32, numBuckets> counts;
+    juce::int64 numCounted = 0;
+
+    for (size_t i = 0; i < counts.size(); ++i)
+    {
+        counts[i] = histogram[i].load(std::memory_order_relaxed);
+        numCounted += counts[i];
+    }
+
+    auto getPercentile = [&counts, numCounted](double percentile)
+    {
+        auto target = (juce::int64) std::ceil(percentile * (double) numCounted);
+        juce::int64 seen = 0;
+
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            seen += counts[i];
+
+            // Report the top edge of the bucket
+            if (seen >= target && seen > 0)
+                return (double) (i + 1) / bucketsPerUnitLoad;
+        }
+
+        return 0.0;
+    };
+
+    snapshot.p50Load = getPercentile(0.50);
+    snapshot.p95Load = getPercentile(0.95);
+    snapshot.p99Load = getPercentile(0.99);
+
+    return snapshot;
+}
+
+//==============================================================================
+LoadMeter::ScopedBlock::ScopedBlock(LoadMeter& meter, int samples) noexcept
+    : loadMeter(meter),
+      isActive(meter.isEnabled()),
+      numSamples(samples),
+      startTicks(isActive ? juce::Time::getHighResolutionTicks() : 0)
+{
+}
+
+LoadMeter::ScopedBlock::~ScopedBlock() noexcept
+{
+    if (isActive)
+        loadMeter.addBlock(*this, juce::Time::getHighResolutionTicks() - startTicks);
+}
+
+void LoadMeter::ScopedBlock::beginCoefficients() noexcept
+{
+    if (isActive)
+        coefficientStartTicks = juce::Time::getHighResolutionTicks();
+}
+
+void LoadMeter::ScopedBlock::endCoefficients() noexcept
+{
+    if (isActive)
+        coefficientTicks += juce::Time::getHighResolutionTicks() - coefficientStartTicks;
+}
+
+void LoadMeter::ScopedBlock::setBiquadCounts(int numElided, int numTotal) noexcept
+{
+    numElidedBiquads = numElided;
+    numBiquads = numTotal;
+}
+
+//==============================================================================
+juce::String LoadMeter::Snapshot::toString() const
+{
+    auto percent = [](double load) { return juce::String(load * 100.0, 1) + "%"; };
+
+    return "Load avg " + percent(averageLoad)
+         + ", p50 " + percent(p50Load)
+         + ", p95 " + percent(p95Load)
+         + ", p99 " + percent(p99Load)
+         + ", max " + percent(maxLoad)
+         + " (" + juce::String(maxBlockMicroseconds, 1) + " us)"
+         + ", " + juce::String(numOverruns) + " overruns in " + juce::String(numBlocks) + " blocks"
+         + ", coefficients " + percent(coefficientFraction)
+         + " / filters " + percent(filterFraction)
+         + ", elided " + percent(elidedBiquadFraction) + " of biquads";
+}
+
+juce::var LoadMeter::Snapshot::toVar() const
+{
+    auto* object = new juce::DynamicObject();
+
+    object->setProperty("numBlocks", numBlocks);
+    object->setProperty("numOverruns", numOverruns);
+    object->setProperty("averageLoad", averageLoad);
+    object->setProperty("maxLoad", maxLoad);
+    object->setProperty("p50Load", p50Load);
+    object->setProperty("p95Load", p95Load);
+    object->setProperty("p99Load", p99Load);
+    object->setProperty("maxBlockMicroseconds", maxBlockMicroseconds);
+    object->setProperty("coefficientFraction", coefficientFraction);
+    object->setProperty("filterFraction", filterFraction);
+    object->setProperty("elidedBiquadFraction", elidedBiquadFraction);
+
+    return juce::var(object);
+}
@@ -0,0 +1,137 @@
+/*
+  ==============================================================================
+
+    This file contains the load meter. It times every processBlock call and
+    keeps lock-free statistics on how much of the audio callback's budget
+    each instance is using.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Per-instance DSP load statistics.
+
+    The audio thread is the only writer, so every counter is a plain atomic
+    load and store with no read-modify-write. Any other thread can read a
+    snapshot at any time without stopping the audio thread. A snapshot can
+    be a block out of date, which is fine for a meter.
+
+    Load is the time spent in processBlock divided by the time the block
+    represents (numSamples / sampleRate), so 1.0 means the instance alone
+    used up the whole callback.
+*/
+class LoadMeter
+{
+public:
+    LoadMeter();
+
+    struct Snapshot
+    {
+        juce::int64 numBlocks = 0;
+
+        // Blocks that took longer than the audio they held
+        juce::int64 numOverruns = 0;
+
+        double averageLoad = 0.0;
+        double maxLoad = 0.0;
+        double p50Load = 0.0;
+        double p95Load = 0.0;
+        double p99Load = 0.0;
+
+        double maxBlockMicroseconds = 0.0;
+
+        // How processBlock's time splits between picking up or designing
+        // coefficients and running the filters. These add up to 1.
+        double coefficientFraction = 0.0;
+        double filterFraction = 0.0;
+
+        // Share of the biquads the settings called for that were skipped
+        // because their band was neutral. Filter time goes roughly with the
+        // number of biquads run, so this is about what elision saved.
+        double elidedBiquadFraction = 0.0;
+
+        juce::String toString() const;
+        juce::var toVar() const;
+    };
+
+    // Call from prepareToPlay
+    void prepare(double sampleRate);
+
+    void setEnabled(bool shouldBeEnabled) noexcept    { enabled = shouldBeEnabled; }
+    bool isEnabled() const noexcept                   { return enabled; }
+
+    // Clears the statistics. Safe from any thread; the audio thread does the
+    // actual clearing at the start of its next block.
+    void reset() noexcept                             { resetRequested = true; }
+
+    Snapshot getSnapshot() const;
+
+    //==============================================================================
+    // Times one processBlock call. Create one at the top of processBlock;
+    // it records the block when it goes out of scope.
+    class ScopedBlock
+    {
+    public:
+        ScopedBlock(LoadMeter& meter, int numSamples) noexcept;
+        ~ScopedBlock() noexcept;
+
+        // Wrap any coefficient work in these so it's counted separately
+        // from the filtering
+        void beginCoefficients() noexcept;
+        void endCoefficients() noexcept;
+
+        // How many biquads the block skipped out of the number the
+        // settings call for
+        void setBiquadCounts(int numElided, int numTotal) noexcept;
+
+    private:
+        friend class LoadMeter;
+
+        LoadMeter& loadMeter;
+        const bool isActive;
+        const int numSamples;
+        const juce::int64 startTicks;
+        juce::int64 coefficientStartTicks = 0;
+        juce::int64 coefficientTicks = 0;
+        int numElidedBiquads = 0;
+        int numBiquads = 0;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedBlock)
+    };
+
+private:
+    void addBlock(const ScopedBlock& block, juce::int64 totalTicks) noexcept;
+    void clear() noexcept;
+
+    // Single-writer increment, see the class comment
+    template <typename Type>
+    static void add(std::atomic<Type>& value, Type amount) noexcept
+    {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    // The histogram covers loads from 0 to 2 in steps of 1/128. Anything
+    // heavier lands in the last bucket.
+    static constexpr int bucketsPerUnitLoad = 128;
+    static constexpr int numBuckets = bucketsPerUnitLoad * 2 + 1;
+
+    std::array<std::atomic<juce::uint32>, numBuckets> histogram;
+
+    std::atomic<juce::int64> numBlocks { 0 }, numOverruns { 0 };
+    std::atomic<juce::int64> totalTicks { 0 }, totalBudgetTicks { 0 }, totalCoefficientTicks { 0 }, maxTicks { 0 };
+    std::atomic<double> maxLoad { 0.0 };
+    std::atomic<juce::int64> totalElidedBiquads { 0 }, totalBiquads { 0 };
+
+    std::atomic<bool> enabled { true };
+    std::atomic<bool> resetRequested { false };
+
+    double ticksPerSample = 0.0;
+    const double ticksPerSecond;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoadMeter)
+};
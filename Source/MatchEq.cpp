@@ -0,0 +1,617 @@
+/*
+  ==============================================================================
+
+    This file contains the match EQ. It measures the long term spectra of a
+    reference file and a track in the background, and fits the EQ's bands
+    to the difference between them.
+
+  ==============================================================================
+*/
+
+#include "MatchEq.h"
+#include "ResponseCurve.h"
+
+namespace
+{
+    // Files shorter than this many frames per thread aren't worth splitting
+    constexpr juce::int64 minFramesPerJob = 64;
+
+    // The target is levelled to 0 dB over this range
+    constexpr float levelLowFrequency = 200.f, levelHighFrequency = 4000.f;
+
+    // Where the bands are allowed to go. The parameters' own ranges.
+    constexpr float minFrequency = 20.f, maxFrequency = 20000.f;
+    constexpr float maxGainDecibels = 24.f;
+    constexpr float minQ = 0.1f, maxQ = 10.f;
+
+    // Below this, the target and the fit count as silence. Without a floor
+    // the fit would chase the difference between two stopbands.
+    constexpr float floorDecibels = -60.f;
+
+    // How many frames of a file, counting a part-filled last frame
+    juce::int64 getNumFrames(juce::int64 lengthInSamples) noexcept
+    {
+        if (lengthInSamples <= MatchEq::fftSize)
+            return 1;
+
+        return 1 + (lengthInSamples - MatchEq::fftSize + MatchEq::hopSize - 1) / MatchEq::hopSize;
+    }
+
+    // The Q of a peak whose gain falls to half over this many octaves
+    float getQForBandwidth(double octaves) noexcept
+    {
+        auto ratio = std::pow(2.0, juce::jmax(1.0 / 6.0, octaves));
+        return juce::jlimit(minQ, maxQ, (float) (std::sqrt(ratio) / (ratio - 1.0)));
+    }
+
+    //==============================================================================
+    // Fits the bands to the target at the same frequencies. The response
+    // is worked out in double, since the fit is mostly deciding where the
+    // cuts go, and the float ResponseCurve is least accurate in their
+    // stopbands.
+    class BandFitter
+    {
+    public:
+        BandFitter(const std::vector<float>& f, double rate, const std::vector<float>& t, const std::vector<float>& w)
+            : frequencies(f), sampleRate(rate), target(t), weights(w)
+        {
+            for (auto frequency : frequencies)
+            {
+                auto omega = juce::MathConstants<double>::twoPi * (double) frequency / rate;
+                cosOmega.push_back(std::cos(omega));
+                cosTwoOmega.push_back(std::cos(2.0 * omega));
+            }
+
+            fitted.resize(frequencies.size(), 0.f);
+        }
+
+        float getError(const SimpleEQSettings& settings) noexcept
+        {
+            evaluate(settings);
+            auto error = 0.f;
+
+            for (size_t i = 0; i < target.size(); ++i)
+            {
+                auto difference = getDifference(i);
+                error += weights[i] * difference * difference;
+            }
+
+            return error;
+        }
+
+        // Tries every slope at frequencies from low to high, keeping
+        // whichever is closest to the target, including leaving the cut
+        // where it is
+        void fitCut(SimpleEQSettings& settings, float& frequency, Slope& slope, float low, float high)
+        {
+            constexpr int numSteps = 48;
+            auto bestError = getError(settings);
+            auto bestFrequency = frequency;
+            auto bestSlope = slope;
+
+            for (int step = 0; step <= numSteps; ++step)
+            {
+                frequency = low * std::pow(high / low, (float) step / (float) numSteps);
+
+                for (int s = Slope_12; s <= Slope_48; ++s)
+                {
+                    slope = static_cast<Slope>(s);
+                    auto error = getError(settings);
+
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        bestFrequency = frequency;
+                        bestSlope = slope;
+                    }
+                }
+            }
+
+            frequency = bestFrequency;
+            slope = bestSlope;
+            getError(settings);
+        }
+
+        // Puts a peak on the biggest difference left, then refines it.
+        // Returns false, leaving the band alone, if the fit is already
+        // within minResidualDecibels.
+        bool fitPeak(SimpleEQSettings& settings, float& frequency, float& gain, float& Q)
+        {
+            auto numPoints = (int) target.size();
+
+            int worst = -1;
+            auto worstDifference = 0.f;
+
+            for (int i = 0; i < numPoints; ++i)
+            {
+                auto difference = getDifference((size_t) i);
+
+                if (weights[(size_t) i] > 0.f && std::abs(difference) > std::abs(worstDifference))
+                {
+                    worst = i;
+                    worstDifference = difference;
+                }
+            }
+
+            if (worst < 0 || std::abs(worstDifference) < MatchEq::minResidualDecibels)
+                return false;
+
+            // Walk out each side to where the difference has halved
+            auto isWithinHalf = [&](int i)
+            {
+                auto difference = getDifference((size_t) i);
+                return weights[(size_t) i] > 0.f && difference * worstDifference > 0.f
+                        && std::abs(difference) > std::abs(worstDifference) * 0.5f;
+            };
+
+            auto lowest = worst, highest = worst;
+
+            while (lowest > 0 && isWithinHalf(lowest - 1))
+                --lowest;
+
+            while (highest < numPoints - 1 && isWithinHalf(highest + 1))
+                ++highest;
+
+            frequency = frequencies[(size_t) worst];
+            gain = juce::jlimit(-maxGainDecibels, maxGainDecibels, worstDifference);
+            Q = getQForBandwidth(std::log2((double) frequencies[(size_t) highest] / (double) frequencies[(size_t) lowest]));
+
+            refinePeak(settings, frequency, gain, Q);
+            return true;
+        }
+
+        // The response in dB for the last settings evaluated
+        const std::vector<float>& getFittedDecibels() const noexcept    { return fitted; }
+
+    private:
+        void evaluate(const SimpleEQSettings& settings) noexcept
+        {
+            ResponseCurve::DoubleBiquads biquads;
+            auto numBiquads = ResponseCurve::getBiquads(settings, sampleRate, biquads);
+
+            for (size_t i = 0; i < fitted.size(); ++i)
+            {
+                auto magnitudeSquared = 1.0;
+
+                for (int b = 0; b < numBiquads; ++b)
+                    magnitudeSquared *= ResponseCurve::getMagnitudeSquared(biquads[(size_t) b], cosOmega[i], cosTwoOmega[i]);
+
+                fitted[i] = (float) juce::jmax((double) ResponseCurve::minDecibels, 10.0 * std::log10(magnitudeSquared + 1.0e-30));
+            }
+        }
+
+        // What's left to fit at a point, for the last settings evaluated
+        float getDifference(size_t i) const noexcept
+        {
+            return target[i] - juce::jmax(floorDecibels, fitted[i]);
+        }
+
+        // A pattern search over the frequency and Q in octaves and the gain
+        // in dB, halving the steps whenever none of them helps
+        void refinePeak(SimpleEQSettings& settings, float& frequency, float& gain, float& Q)
+        {
+            auto frequencyStep = 1.f / 6.f, gainStep = 1.f, qStep = 0.5f;
+            auto bestError = getError(settings);
+
+            auto tryChange = [&](float& value, float newValue)
+            {
+                auto oldValue = value;
+                value = newValue;
+                auto error = getError(settings);
+
+                if (error < bestError)
+                {
+                    bestError = error;
+                    return true;
+                }
+
+                value = oldValue;
+                return false;
+            };
+
+            for (int iteration = 0; iteration < 64 && gainStep > 0.05f; ++iteration)
+            {
+                auto improved = false;
+
+                for (auto direction : { -1.f, 1.f })
+                {
+                    improved |= tryChange(frequency, juce::jlimit(minFrequency, maxFrequency, frequency * std::exp2(direction * frequencyStep)));
+                    improved |= tryChange(gain, juce::jlimit(-maxGainDecibels, maxGainDecibels, gain + direction * gainStep));
+                    improved |= tryChange(Q, juce::jlimit(minQ, maxQ, Q * std::exp2(direction * qStep)));
+                }
+
+                if (! improved)
+                {
+                    frequencyStep *= 0.5f;
+                    gainStep *= 0.5f;
+                    qStep *= 0.5f;
+                }
+            }
+
+            getError(settings);
+        }
+
+        const std::vector<float>& frequencies;
+        const double sampleRate;
+        const std::vector<float>& target;
+        const std::vector<float>& weights;
+        std::vector<double> cosOmega, cosTwoOmega;
+        std::vector<float> fitted;
+    };
+}
+
+//==============================================================================
+// Averages the power spectrum over a run of frames from one file, reading it
+// a hop at a time
+class MatchEq::SpectrumJob  : public juce::ThreadPoolJob
+{
+public:
+    SpectrumJob(MatchEq& o, int index, std::unique_ptr<juce::AudioFormatReader> r, juce::int64 first, juce::int64 count)
+        : juce::ThreadPoolJob("SimpleEQ Match Analysis"),
+          owner(o), fileIndex(index), reader(std::move(r)), firstFrame(first), numFrames(count)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        juce::dsp::FFT fft(fftOrder);
+        std::vector<float> window((size_t) fftSize), frame((size_t) fftSize), fftData((size_t) fftSize * 2);
+        juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), window.size(),
+                                                                 juce::dsp::WindowingFunction<float>::hann, false);
+
+        readBuffer.setSize(juce::jmax(1, (int) reader->numChannels), hopSize);
+        power.assign((size_t) fftSize / 2 + 1, 0.0);
+
+        auto position = firstFrame * hopSize;
+        readMono(position, frame.data());
+        readMono(position + hopSize, frame.data() + hopSize);
+
+        for (juce::int64 i = 0; i < numFrames; ++i)
+        {
+            if (shouldExit())
+                return jobHasFinished;
+
+            std::transform(frame.begin(), frame.end(), window.begin(), fftData.begin(), std::multiplies<float>());
+            std::fill(fftData.begin() + fftSize, fftData.end(), 0.f);
+            fft.performFrequencyOnlyForwardTransform(fftData.data(), true);
+
+            for (size_t bin = 0; bin < power.size(); ++bin)
+                power[bin] += (double) fftData[bin] * (double) fftData[bin];
+
+            ++owner.framesDone;
+
+            // Slide on by a hop
+            if (i + 1 < numFrames)
+            {
+                std::copy(frame.begin() + hopSize, frame.end(), frame.begin());
+                position += hopSize;
+                readMono(position + hopSize, frame.data() + hopSize);
+            }
+        }
+
+        owner.jobFinished();
+        return jobHasFinished;
+    }
+
+    const int fileIndex;
+    const juce::int64 numFrames;
+    std::vector<double> power;
+
+private:
+    // A hop of the file, averaged down to mono. Past the end reads silence.
+    void readMono(juce::int64 start, float* destination)
+    {
+        reader->read(&readBuffer, 0, hopSize, start, true, true);
+
+        auto numChannels = readBuffer.getNumChannels();
+        juce::FloatVectorOperations::copy(destination, readBuffer.getReadPointer(0), hopSize);
+
+        for (int channel = 1; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::add(destination, readBuffer.getReadPointer(channel), hopSize);
+
+        if (numChannels > 1)
+            juce::FloatVectorOperations::multiply(destination, 1.f / (float) numChannels, hopSize);
+    }
+
+    MatchEq& owner;
+    std::unique_ptr<juce::AudioFormatReader> reader;
+    const juce::int64 firstFrame;
+    juce::AudioBuffer<float> readBuffer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumJob)
+};
+
+//==============================================================================
+MatchEq::MatchEq(juce::AudioProcessorValueTreeState& apts)
+    : ap_tree_state(apts)
+{
+    formatManager.registerBasicFormats();
+}
+
+MatchEq::~MatchEq()
+{
+    cancel();
+    cancelPendingUpdate();
+}
+
+bool MatchEq::start(const juce::File& reference, const juce::File& track)
+{
+    cancel();
+
+    startingSettings = getChainSettings(ap_tree_state);
+
+    // Open both files up front, so a bad one is reported straight away
+    std::array<std::unique_ptr<juce::AudioFormatReader>, 2> readers;
+    const std::array<juce::File, 2> files { reference, track };
+
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        readers[i].reset(formatManager.createReaderFor(files[i]));
+
+        if (readers[i] == nullptr || readers[i]->sampleRate <= 0.0)
+        {
+            const juce::ScopedLock sl(resultLock);
+            result = {};
+            result.error = "Couldn't open " + files[i].getFullPathName();
+            return false;
+        }
+
+        spectra[i] = { files[i], readers[i]->sampleRate, 0, {} };
+    }
+
+    if (pool == nullptr)
+        pool = std::make_unique<juce::SharedResourcePointer<AnalysisPool>>();
+
+    auto numThreads = (juce::int64) (*pool)->getNumThreads();
+    totalFrames = 0;
+
+    // Split each file into runs of frames, one per thread at most. The
+    // first run uses the reader that's already open, and the rest open
+    // their own, since a reader can only be read from one thread at once.
+    for (int fileIndex = 0; fileIndex < 2; ++fileIndex)
+    {
+        auto numFrames = getNumFrames(readers[(size_t) fileIndex]->lengthInSamples);
+        auto numJobs = juce::jlimit((juce::int64) 1, numThreads, numFrames / minFramesPerJob);
+        totalFrames += numFrames;
+
+        for (juce::int64 job = 0; job < numJobs; ++job)
+        {
+            auto firstFrame = numFrames * job / numJobs;
+            auto lastFrame = numFrames * (job + 1) / numJobs;
+
+            std::unique_ptr<juce::AudioFormatReader> reader;
+
+            if (job == 0)
+                reader = std::move(readers[(size_t) fileIndex]);
+            else
+                reader.reset(formatManager.createReaderFor(files[(size_t) fileIndex]));
+
+            if (reader == nullptr)
+            {
+                jobs.clear();
+                const juce::ScopedLock sl(resultLock);
+                result = {};
+                result.error = "Couldn't open " + files[(size_t) fileIndex].getFullPathName();
+                return false;
+            }
+
+            jobs.add(new SpectrumJob(*this, fileIndex, std::move(reader), firstFrame, lastFrame - firstFrame));
+        }
+    }
+
+    framesDone = 0;
+    jobsRemaining = jobs.size();
+    finishedEvent.reset();
+    running = true;
+
+    for (auto* job : jobs)
+        (*pool)->addJob(job, false);
+
+    return true;
+}
+
+void MatchEq::cancel()
+{
+    // The analysis stops at the next frame, but the job that finishes last
+    // runs the fit, which doesn't check for that. Wait as long as it takes,
+    // since the jobs can't be deleted while one is still running.
+    if (pool != nullptr)
+        for (auto* job : jobs)
+            (*pool)->removeJob(job, true, -1);
+
+    jobs.clear();
+
+    // A fit that finished while this was happening isn't wanted any more
+    cancelPendingUpdate();
+
+    {
+        const juce::ScopedLock sl(resultLock);
+        resultPending = false;
+    }
+
+    if (running.exchange(false))
+        finishedEvent.signal();
+}
+
+float MatchEq::getProgress() const noexcept
+{
+    if (totalFrames <= 0)
+        return running ? 0.f : 1.f;
+
+    return juce::jlimit(0.f, 1.f, (float) ((double) framesDone.load() / (double) totalFrames));
+}
+
+bool MatchEq::waitUntilFinished(int timeoutMilliseconds)
+{
+    return finishedEvent.wait(timeoutMilliseconds);
+}
+
+MatchEq::Result MatchEq::getResult() const
+{
+    const juce::ScopedLock sl(resultLock);
+    return result;
+}
+
+void MatchEq::jobFinished()
+{
+    // The last job to finish does the fit, on its own thread
+    if (--jobsRemaining > 0)
+        return;
+
+    fit();
+
+    running = false;
+    finishedEvent.signal();
+    triggerAsyncUpdate();
+}
+
+void MatchEq::applyResult()
+{
+    cancelPendingUpdate();
+
+    SimpleEQSettings settings;
+
+    {
+        const juce::ScopedLock sl(resultLock);
+
+        if (! resultPending)
+            return;
+
+        resultPending = false;
+
+        if (! result.wasSuccessful())
+            return;
+
+        settings = result.settings;
+    }
+
+    setChainSettings(ap_tree_state, settings);
+}
+
+void MatchEq::handleAsyncUpdate()
+{
+    applyResult();
+
+    if (onFinished)
+        onFinished(getResult());
+}
+
+void MatchEq::fit()
+{
+    Result newResult;
+    newResult.settings = startingSettings;
+
+    // Add up each file's runs. The jobs are all finished, so nothing else
+    // touches them now.
+    for (auto& spectrum : spectra)
+    {
+        spectrum.power.assign((size_t) fftSize / 2 + 1, 0.0);
+        spectrum.numFrames = 0;
+    }
+
+    for (auto* job : jobs)
+    {
+        auto& spectrum = spectra[(size_t) job->fileIndex];
+
+        for (size_t bin = 0; bin < spectrum.power.size(); ++bin)
+            spectrum.power[bin] += job->power[bin];
+
+        spectrum.numFrames += job->numFrames;
+    }
+
+    // The fit is evaluated at the track's rate, which is the rate the EQ will
+    // run on it at, on a log frequency grid like ResponseCurve's
+    auto sampleRate = spectra[1].sampleRate;
+    auto& frequencies = newResult.frequencies;
+
+    for (int i = 0; i < numFitPoints; ++i)
+        frequencies.push_back(minFrequency * std::pow(maxFrequency / minFrequency, (float) i / (float) (numFitPoints - 1)));
+
+    newResult.targetDecibels.assign((size_t) numFitPoints, 0.f);
+
+    // Each point's power is the average over the bins within a sixth of an
+    // octave either side, with at least the nearest bin, so the low end
+    // isn't full of holes. Points above either file's Nyquist don't count.
+    std::vector<float> weights((size_t) numFitPoints, 0.f);
+    auto smoothingRatio = std::exp2(1.0 / 6.0);
+
+    auto getSmoothedDecibels = [&](const FileSpectrum& spectrum, double frequency)
+    {
+        auto binsPerHertz = (double) fftSize / spectrum.sampleRate;
+        auto lastBin = (int) spectrum.power.size() - 1;
+        auto low = juce::jlimit(0, lastBin, (int) std::floor(frequency / smoothingRatio * binsPerHertz));
+        auto high = juce::jlimit(low, lastBin, (int) std::ceil(frequency * smoothingRatio * binsPerHertz));
+
+        auto sum = 0.0;
+
+        for (auto bin = low; bin <= high; ++bin)
+            sum += spectrum.power[(size_t) bin];
+
+        auto average = sum / ((double) (high - low + 1) * (double) juce::jmax((juce::int64) 1, spectrum.numFrames));
+        return (float) (10.0 * std::log10(average + 1.0e-20));
+    };
+
+    auto nyquist = 0.5 * juce::jmin(spectra[0].sampleRate, spectra[1].sampleRate);
+    auto levelSum = 0.f;
+    int numLevelPoints = 0;
+
+    for (int i = 0; i < numFitPoints; ++i)
+    {
+        auto frequency = (double) frequencies[(size_t) i];
+
+        if (frequency > nyquist * 0.95)
+            continue;
+
+        weights[(size_t) i] = 1.f;
+        newResult.targetDecibels[(size_t) i] = getSmoothedDecibels(spectra[0], frequency) - getSmoothedDecibels(spectra[1], frequency);
+
+        if (frequency >= levelLowFrequency && frequency <= levelHighFrequency)
+        {
+            levelSum += newResult.targetDecibels[(size_t) i];
+            ++numLevelPoints;
+        }
+    }
+
+    // Level the midrange to 0 dB, and keep what's left inside what the
+    // bands can do. Anything deeper than this is as good as silence.
+    auto level = numLevelPoints > 0 ? levelSum / (float) numLevelPoints : 0.f;
+
+    for (auto& target : newResult.targetDecibels)
+        target = juce::jlimit(floorDecibels, maxGainDecibels, target - level);
+
+    // Start from a flat EQ, keeping the slopes and everything that isn't
+    // a band
+    auto& settings = newResult.settings;
+    settings.lowCutFreq = minFrequency;
+    settings.highCutFreq = maxFrequency;
+    settings.peakGain = 0.f;
+
+    for (auto& band : settings.extraBands)
+        band = {};
+
+    BandFitter fitter(frequencies, sampleRate, newResult.targetDecibels, weights);
+
+    fitter.fitCut(settings, settings.lowCutFreq, settings.lowCutSlope, minFrequency, 1000.f);
+    fitter.fitCut(settings, settings.highCutFreq, settings.highCutSlope, 1000.f, maxFrequency);
+
+    if (! fitter.fitPeak(settings, settings.peakFreq, settings.peakGain, settings.peakQ))
+        settings.peakGain = 0.f;
+
+    for (auto& band : settings.extraBands)
+    {
+        band = { true, BandType::peak, 1000.f, 0.f, 1.f };
+
+        if (! fitter.fitPeak(settings, band.frequency, band.gain, band.Q))
+        {
+            band = {};
+            break;
+        }
+    }
+
+    fitter.getError(settings);
+    newResult.fittedDecibels = fitter.getFittedDecibels();
+
+    const juce::ScopedLock sl(resultLock);
+    result = std::move(newResult);
+    resultPending = true;
+}
@@ -0,0 +1,145 @@
+/*
+  ==============================================================================
+
+    This file contains the match EQ. It measures the long term spectra of a
+    reference file and a track in the background, and fits the EQ's bands
+    to the difference between them.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SimpleEQSettings.h"
+
+//==============================================================================
+/**
+    Each file is streamed from disk a hop at a time, never loaded whole. It's
+    summed to mono, cut into Hann windowed frames overlapping by half, and
+    the power spectra of the frames are averaged. Long files are split into
+    runs of frames that are analysed at the same time on a pool of threads,
+    one per core, shared by every instance. The runs line up on the hop, so
+    together they cover exactly the frames one pass would.
+
+    The job that finishes last fits the bands. The target is the reference's
+    spectrum over the track's, in dB, smoothed to a third of an octave and
+    levelled so the midrange sits at 0 dB, since matching loudness is the
+    fader's job. Then, on a log frequency grid:
+
+      - the low cut frequency and slope, and then the high cut's, are picked
+        by trying every slope over a range of frequencies and keeping the
+        one closest to the target, or leaving the cut parked if that's
+        closer
+      - the peak goes on the biggest difference that's left, with the width
+        read off where the difference falls to half, then its gain and Q
+        are refined against the target
+      - each extra band does the same, while a difference of more than
+        minResidualDecibels remains
+
+    Everything else (the Mid/Side and dynamics settings) is left as it was.
+    When the fit is done, it's written into the parameters on the message
+    thread. None of this runs on the audio thread.
+*/
+class MatchEq  : private juce::AsyncUpdater
+{
+public:
+    static constexpr int fftOrder = 13;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = fftSize / 2;
+
+    // The fit is evaluated at this many points from 20 Hz to 20 kHz
+    static constexpr int numFitPoints = 192;
+
+    // Extra bands stop being added once the fit is this close everywhere
+    static constexpr float minResidualDecibels = 1.f;
+
+    struct Result
+    {
+        juce::String error;
+        SimpleEQSettings settings;
+
+        // The difference the fit aimed for, and what the fitted bands do, in
+        // dB at each of frequencies. For drawing.
+        std::vector<float> frequencies, targetDecibels, fittedDecibels;
+
+        bool wasSuccessful() const noexcept     { return error.isEmpty(); }
+    };
+
+    explicit MatchEq(juce::AudioProcessorValueTreeState& ap_tree_state);
+    ~MatchEq() override;
+
+    // Starts analysing in the background and returns straight away. The
+    // current parameters are the starting point, so call this on the message
+    // thread. Any analysis already running is cancelled. Returns false, with
+    // the reason in the result, if either file can't be opened.
+    bool start(const juce::File& reference, const juce::File& track);
+
+    // Stops the analysis, if it's running, and waits for its jobs to finish
+    void cancel();
+
+    bool isRunning() const noexcept             { return running; }
+
+    // How far through the files the analysis is, from 0 to 1
+    float getProgress() const noexcept;
+
+    // Blocks until the analysis is done, for callers without a message
+    // loop. Returns false if it timed out.
+    bool waitUntilFinished(int timeoutMilliseconds = -1);
+
+    // The last finished analysis. Message thread, or after waitUntilFinished.
+    Result getResult() const;
+
+    // Writes the last fit into the parameters. This happens by itself on the
+    // message thread once the analysis finishes; call it directly after
+    // waitUntilFinished when there's no message loop.
+    void applyResult();
+
+    // Called on the message thread after the fit has been applied
+    std::function<void(const Result&)> onFinished;
+
+private:
+    // The threads that do the analysis for every instance
+    struct AnalysisPool  : public juce::ThreadPool
+    {
+        AnalysisPool() : juce::ThreadPool(juce::jmax(1, juce::SystemStats::getNumCpus())) {}
+    };
+
+    // The running sum of one file's power spectrum
+    struct FileSpectrum
+    {
+        juce::File file;
+        double sampleRate = 0.0;
+        juce::int64 numFrames = 0;
+        std::vector<double> power;
+    };
+
+    class SpectrumJob;
+
+    void jobFinished();
+    void fit();
+    void handleAsyncUpdate() override;
+
+    juce::AudioProcessorValueTreeState& ap_tree_state;
+    juce::AudioFormatManager formatManager;
+
+    // Only made once the first analysis starts, so instances that never
+    // match don't keep a thread per core around
+    std::unique_ptr<juce::SharedResourcePointer<AnalysisPool>> pool;
+    juce::OwnedArray<SpectrumJob> jobs;
+
+    std::array<FileSpectrum, 2> spectra;
+    SimpleEQSettings startingSettings;
+
+    std::atomic<bool> running { false };
+    std::atomic<int> jobsRemaining { 0 };
+    std::atomic<juce::int64> framesDone { 0 };
+    juce::int64 totalFrames = 0;
+    juce::WaitableEvent finishedEvent { true };
+
+    mutable juce::CriticalSection resultLock;
+    Result result;
+    bool resultPending = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MatchEq)
+};
@@ -0,0 +1,172 @@
+/*
+  ==============================================================================
+
+    This file contains the parameter pages, the editor's tabs for everything
+    past the low cut, peak and high cut: one row or two of controls each,
+    attached to their parameters.
+
+  ==============================================================================
+*/
+
+#include "ParameterPages.h"
+
+//==============================================================================
+ParameterPage::ParameterPage(juce::AudioProcessorValueTreeState& apts)
+    : ap_tree_state(apts)
+{
+}
+
+void ParameterPage::addSlider(juce::Slider& slider, const std::string& parameterID, const std::string& labelText)
+{
+    addControl(slider, labelText);
+    sliderAttachments.add(new SliderAttachment(ap_tree_state, parameterID, slider));
+}
+
+void ParameterPage::addComboBox(juce::ComboBox& comboBox, const std::string& parameterID, const std::string& labelText)
+{
+    // The items have to be there before the attachment is made, so it can
+    // select the current one
+    addChoices(comboBox, parameterID);
+    addControl(comboBox, labelText);
+    comboBoxAttachments.add(new ComboBoxAttachment(ap_tree_state, parameterID, comboBox));
+}
+
+void ParameterPage::addToggle(juce::ToggleButton& button, const std::string& parameterID, const std::string& labelText)
+{
+    addControl(button, labelText);
+    buttonAttachments.add(new ButtonAttachment(ap_tree_state, parameterID, button));
+}
+
+void ParameterPage::addControl(juce::Component& control, const std::string& labelText)
+{
+    if (auto* slider = dynamic_cast<juce::Slider*>(&control))
+    {
+        slider->setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
+        slider->setTextBoxStyle(juce::Slider::TextBoxBelow, false, 80, 20);
+    }
+
+    addAndMakeVisible(control);
+    controls.add(&control);
+
+    auto* label = controlLabels.add(new juce::Label({}, labelText));
+    label->setJustificationType(juce::Justification::centred);
+    label->attachToComponent(&control, false);
+}
+
+void ParameterPage::addChoices(juce::ComboBox& comboBox, const std::string& parameterID)
+{
+    if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(ap_tree_state.getParameter(parameterID)))
+        comboBox.addItemList(choice->choices, 1);
+}
+
+void ParameterPage::resized()
+{
+    if (controls.isEmpty())
+        return;
+
+    auto bounds = getLocalBounds().reduced(10);
+
+    auto numRows = (controls.size() + maxControlsPerRow - 1) / maxControlsPerRow;
+    auto numColumns = (controls.size() + numRows - 1) / numRows;
+    auto rowHeight = bounds.getHeight() / numRows;
+    auto columnWidth = bounds.getWidth() / numColumns;
+
+    auto labelHeight = 20;
+    auto comboBoxHeight = 24;
+
+    for (int i = 0; i < controls.size(); ++i)
+    {
+        auto cell = juce::Rectangle<int>(bounds.getX() + (i % numColumns) * columnWidth,
+                                         bounds.getY() + (i / numColumns) * rowHeight,
+                                         columnWidth, rowHeight);
+        cell.removeFromTop(labelHeight);
+
+        // Only the knobs fill their cell. Everything else sits at the top,
+        // just under its label.
+        auto* control = controls.getUnchecked(i);
+
+        if (dynamic_cast<juce::Slider*>(control) != nullptr)
+            control->setBounds(cell.reduced(4, 0));
+        else
+            control->setBounds(cell.removeFromTop(comboBoxHeight).reduced(6, 0));
+    }
+}
+
+//==============================================================================
+BandPage::BandPage(juce::AudioProcessorValueTreeState& apts)
+    : ParameterPage(apts)
+{
+    for (int band = 0; band < numExtraBands; ++band)
+        bandSelector.addItem("Band " + juce::String(band + 1), band + 1);
+
+    bandSelector.onChange = [this] { showBand(bandSelector.getSelectedItemIndex()); };
+    addControl(bandSelector, "Band");
+
+    // Every band has the same types, so the first band's will do
+    addChoices(typeBox, getExtraBandParameterID(0, BAND_TYPE));
+
+    addControl(onButton, BAND_ON_LABEL);
+    addControl(typeBox, BAND_TYPE_LABEL);
+    addControl(freqSlider, BAND_FREQ_LABEL);
+    addControl(gainSlider, BAND_GAIN_LABEL);
+    addControl(qSlider, BAND_Q_LABEL);
+
+    bandSelector.setSelectedItemIndex(0, juce::sendNotificationSync);
+}
+
+void BandPage::showBand(int bandIndex)
+{
+    if (! juce::isPositiveAndBelow(bandIndex, numExtraBands))
+        return;
+
+    onAttachment.reset();
+    typeAttachment.reset();
+    freqAttachment.reset();
+    gainAttachment.reset();
+    qAttachment.reset();
+
+    onAttachment = std::make_unique<ButtonAttachment>(ap_tree_state, getExtraBandParameterID(bandIndex, BAND_ON), onButton);
+    typeAttachment = std::make_unique<ComboBoxAttachment>(ap_tree_state, getExtraBandParameterID(bandIndex, BAND_TYPE), typeBox);
+    freqAttachment = std::make_unique<SliderAttachment>(ap_tree_state, getExtraBandParameterID(bandIndex, BAND_FREQ), freqSlider);
+    gainAttachment = std::make_unique<SliderAttachment>(ap_tree_state, getExtraBandParameterID(bandIndex, BAND_GAIN), gainSlider);
+    qAttachment = std::make_unique<SliderAttachment>(ap_tree_state, getExtraBandParameterID(bandIndex, BAND_Q), qSlider);
+}
+
+//==============================================================================
+MidSidePage::MidSidePage(juce::AudioProcessorValueTreeState& apts)
+    : ParameterPage(apts)
+{
+    addToggle(midSideButton, MID_SIDE, MID_SIDE_LABEL);
+
+    addSlider(lowCutFreqSlider, SIDE_LOW_CUT_FREQ, SIDE_LOW_CUT_FREQ_LABEL);
+    addComboBox(lowCutSlopeBox, SIDE_LOW_CUT_SLOPE, SIDE_LOW_CUT_SLOPE_LABEL);
+
+    addSlider(peakFreqSlider, SIDE_PEAK_FREQ, SIDE_PEAK_FREQ_LABEL);
+    addSlider(peakGainSlider, SIDE_PEAK_GAIN, SIDE_PEAK_GAIN_LABEL);
+    addSlider(peakQSlider, SIDE_PEAK_Q, SIDE_PEAK_Q_LABEL);
+
+    addSlider(highCutFreqSlider, SIDE_HIGH_CUT_FREQ, SIDE_HIGH_CUT_FREQ_LABEL);
+    addComboBox(highCutSlopeBox, SIDE_HIGH_CUT_SLOPE, SIDE_HIGH_CUT_SLOPE_LABEL);
+}
+
+//==============================================================================
+DynamicsPage::DynamicsPage(juce::AudioProcessorValueTreeState& apts)
+    : ParameterPage(apts)
+{
+    addToggle(dynamicButton, DYNAMIC_ON, DYNAMIC_ON_LABEL);
+    addSlider(thresholdSlider, DYNAMIC_THRESHOLD, DYNAMIC_THRESHOLD_LABEL);
+    addSlider(ratioSlider, DYNAMIC_RATIO, DYNAMIC_RATIO_LABEL);
+    addSlider(attackSlider, DYNAMIC_ATTACK, DYNAMIC_ATTACK_LABEL);
+    addSlider(releaseSlider, DYNAMIC_RELEASE, DYNAMIC_RELEASE_LABEL);
+    addToggle(sidechainButton, DYNAMIC_SIDECHAIN, DYNAMIC_SIDECHAIN_LABEL);
+}
+
+//==============================================================================
+ProcessingPage::ProcessingPage(juce::AudioProcessorValueTreeState& apts)
+    : ParameterPage(apts)
+{
+    addComboBox(topologyBox, FILTER_TOPOLOGY, FILTER_TOPOLOGY_LABEL);
+    addComboBox(oversamplingBox, OVERSAMPLING, OVERSAMPLING_LABEL);
+    addToggle(linearPhaseButton, LINEAR_PHASE, LINEAR_PHASE_LABEL);
+    addComboBox(kernelSizeBox, KERNEL_SIZE, KERNEL_SIZE_LABEL);
+}
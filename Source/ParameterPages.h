@@ -0,0 +1,144 @@
+/*
+  ==============================================================================
+
+    This file contains the parameter pages, the editor's tabs for everything
+    past the low cut, peak and high cut: one row or two of controls each,
+    attached to their parameters.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SimpleEQSettings.h"
+
+//==============================================================================
+/**
+    Lays its controls out in a grid, in the order they were added, with each
+    one's label above it. The add functions attach a control to its
+    parameter for as long as the page exists. A page whose controls change
+    parameter, like the band page, makes its own attachments and only
+    uses addControl for the layout.
+*/
+class ParameterPage  : public juce::Component
+{
+public:
+    explicit ParameterPage(juce::AudioProcessorValueTreeState& ap_tree_state);
+
+    void resized() override;
+
+    // Pages with more controls than this wrap onto more rows
+    static constexpr int maxControlsPerRow = 6;
+
+protected:
+    using SliderAttachment = juce::AudioProcessorValueTreeState::SliderAttachment;
+    using ComboBoxAttachment = juce::AudioProcessorValueTreeState::ComboBoxAttachment;
+    using ButtonAttachment = juce::AudioProcessorValueTreeState::ButtonAttachment;
+
+    void addSlider(juce::Slider& slider, const std::string& parameterID, const std::string& labelText);
+    void addComboBox(juce::ComboBox& comboBox, const std::string& parameterID, const std::string& labelText);
+    void addToggle(juce::ToggleButton& button, const std::string& parameterID, const std::string& labelText);
+
+    // Adds a control to the layout with its label, without attaching it.
+    // Sliders get the same rotary style as the editor's.
+    void addControl(juce::Component& control, const std::string& labelText);
+
+    // Fills a combo box with a choice parameter's choices
+    void addChoices(juce::ComboBox& comboBox, const std::string& parameterID);
+
+    juce::AudioProcessorValueTreeState& ap_tree_state;
+
+private:
+    juce::Array<juce::Component*> controls;
+    juce::OwnedArray<juce::Label> controlLabels;
+
+    juce::OwnedArray<SliderAttachment> sliderAttachments;
+    juce::OwnedArray<ComboBoxAttachment> comboBoxAttachments;
+    juce::OwnedArray<ButtonAttachment> buttonAttachments;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParameterPage)
+};
+
+//==============================================================================
+/**
+    The extra bands, one at a time. Picking a band moves the five controls
+    over to its parameters, so there's no need for 105 knobs.
+*/
+class BandPage  : public ParameterPage
+{
+public:
+    explicit BandPage(juce::AudioProcessorValueTreeState& ap_tree_state);
+
+private:
+    void showBand(int bandIndex);
+
+    juce::ComboBox bandSelector;
+    juce::ToggleButton onButton;
+    juce::ComboBox typeBox;
+    juce::Slider freqSlider, gainSlider, qSlider;
+
+    // The attachments for the band that's showing. They're let go before
+    // the next band's are made, so a control is never attached twice.
+    std::unique_ptr<ButtonAttachment> onAttachment;
+    std::unique_ptr<ComboBoxAttachment> typeAttachment;
+    std::unique_ptr<SliderAttachment> freqAttachment, gainAttachment, qAttachment;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BandPage)
+};
+
+//==============================================================================
+/**
+    The Mid/Side switch and the side channel's cuts and peak. The main
+    controls are the mid channel's while it's on.
+*/
+class MidSidePage  : public ParameterPage
+{
+public:
+    explicit MidSidePage(juce::AudioProcessorValueTreeState& ap_tree_state);
+
+private:
+    juce::ToggleButton midSideButton;
+    juce::Slider lowCutFreqSlider;
+    juce::ComboBox lowCutSlopeBox;
+    juce::Slider peakFreqSlider, peakGainSlider, peakQSlider;
+    juce::Slider highCutFreqSlider;
+    juce::ComboBox highCutSlopeBox;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidSidePage)
+};
+
+//==============================================================================
+/**
+    The peak band's dynamics, and whether they listen to the sidechain
+*/
+class DynamicsPage  : public ParameterPage
+{
+public:
+    explicit DynamicsPage(juce::AudioProcessorValueTreeState& ap_tree_state);
+
+private:
+    juce::ToggleButton dynamicButton;
+    juce::Slider thresholdSlider, ratioSlider, attackSlider, releaseSlider;
+    juce::ToggleButton sidechainButton;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DynamicsPage)
+};
+
+//==============================================================================
+/**
+    The processing options: how the filters are run rather than what they
+    do. Each one is saved with the state, but none of them are in presets.
+*/
+class ProcessingPage  : public ParameterPage
+{
+public:
+    explicit ProcessingPage(juce::AudioProcessorValueTreeState& ap_tree_state);
+
+private:
+    juce::ComboBox topologyBox, oversamplingBox;
+    juce::ToggleButton linearPhaseButton;
+    juce::ComboBox kernelSizeBox;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ProcessingPage)
+};
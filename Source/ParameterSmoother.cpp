@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    This file contains the parameter smoother. It ramps the EQ settings
+    towards their targets on the audio thread and redesigns the coefficients
+    every few samples so automation doesn't zipper.
+
+  ==============================================================================
+*/
+
+#include "ParameterSmoother.h"
+
+void ParameterSmoother::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+
+    lowCutFreq.reset(sampleRate, rampLengthSeconds);
+    peakFreq.reset(sampleRate, rampLengthSeconds);
+    peakQ.reset(sampleRate, rampLengthSeconds);
+    peakGain.reset(sampleRate, rampLengthSeconds);
+    highCutFreq.reset(sampleRate, rampLengthSeconds);
+}
+
+void ParameterSmoother::reset(const SimpleEQSettings& settings) noexcept
+{
+    lowCutFreq.setCurrentAndTargetValue(settings.lowCutFreq);
+    peakFreq.setCurrentAndTargetValue(settings.peakFreq);
+    peakQ.setCurrentAndTargetValue(settings.peakQ);
+    peakGain.setCurrentAndTargetValue(settings.peakGain);
+    highCutFreq.setCurrentAndTargetValue(settings.highCutFreq);
+
+    lowCutSlope = settings.lowCutSlope;
+    highCutSlope = settings.highCutSlope;
+}
+
+void ParameterSmoother::setTargets(const SimpleEQSettings& settings) noexcept
+{
+    lowCutFreq.setTargetValue(settings.lowCutFreq);
+    peakFreq.setTargetValue(settings.peakFreq);
+    peakQ.setTargetValue(settings.peakQ);
+    peakGain.setTargetValue(settings.peakGain);
+    highCutFreq.setTargetValue(settings.highCutFreq);
+
+    lowCutSlope = settings.lowCutSlope;
+    highCutSlope = settings.highCutSlope;
+}
+
+bool ParameterSmoother::isSmoothing() const noexcept
+{
+    return lowCutFreq.isSmoothing() || peakFreq.isSmoothing() || peakQ.isSmoothing()
+        || peakGain.isSmoothing() || highCutFreq.isSmoothing();
+}
+
+void ParameterSmoother::designAndAdvance(int numSamples, ChainCoefficients& chainCoefficients) noexcept
+{
+    auto& settings = chainCoefficients.settings;
+
+    settings.lowCutFreq = lowCutFreq.getCurrentValue();
+    settings.lowCutSlope = lowCutSlope;
+    settings.peakFreq = peakFreq.getCurrentValue();
+    settings.peakGain = peakGain.getCurrentValue();
+    settings.peakQ = peakQ.getCurrentValue();
+    settings.highCutFreq = highCutFreq.getCurrentValue();
+    settings.highCutSlope = highCutSlope;
+
+    chainCoefficients.peak = makePeakCoefficients(sampleRate, settings.peakFreq, settings.peakQ, juce::Decibels::decibelsToGain(settings.peakGain));
+    makeCutCoefficients(CutType::lowCut, sampleRate, settings.lowCutFreq, settings.lowCutSlope, chainCoefficients.lowCut);
+    makeCutCoefficients(CutType::highCut, sampleRate, settings.highCutFreq, settings.highCutSlope, chainCoefficients.highCut);
+
+    lowCutFreq.skip(numSamples);
+    peakFreq.skip(numSamples);
+    peakQ.skip(numSamples);
+    peakGain.skip(numSamples);
+    highCutFreq.skip(numSamples);
+}
@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    This file contains the parameter smoother. It ramps the EQ settings
+    towards their targets on the audio thread and redesigns the coefficients
+    every few samples so automation doesn't zipper.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SimpleEQSettings.h"
+#include "CoefficientEngine.h"
+
+//==============================================================================
+/**
+    Smooths the continuous settings (frequencies and Q multiplicatively, gain
+    linearly in decibels) and designs coefficients for the smoothed values
+    with the closed-form designs in BiquadCoefficients.h. A design costs a
+    couple of trig calls and a few dozen multiplies, so doing one every
+    8-64 samples stays cheap.
+
+    The slopes are choices rather than continuous values, so they switch to
+    their new value at the next update.
+
+    Everything here runs on the audio thread and never allocates.
+*/
+class ParameterSmoother
+{
+public:
+    ParameterSmoother() = default;
+
+    // How long a ramp from one setting to another takes
+    static constexpr double rampLengthSeconds = 0.05;
+
+    void prepare(double sampleRate);
+
+    // Jumps straight to the given settings with no ramp
+    void reset(const SimpleEQSettings& settings) noexcept;
+
+    // Starts ramping towards the given settings
+    void setTargets(const SimpleEQSettings& settings) noexcept;
+
+    bool isSmoothing() const noexcept;
+
+    // Designs coefficients for the current smoothed settings, then moves the
+    // ramps on by numSamples ready for the next update
+    void designAndAdvance(int numSamples, ChainCoefficients& chainCoefficients) noexcept;
+
+private:
+    double sampleRate = 0.0;
+
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> lowCutFreq, peakFreq, peakQ, highCutFreq;
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> peakGain;
+
+    Slope lowCutSlope { Slope_12 };
+    Slope highCutSlope { Slope_12 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParameterSmoother)
+};
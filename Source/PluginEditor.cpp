@@ -11,30 +11,133 @@
 
 //==============================================================================
 SimpleEQAudioProcessorEditor::SimpleEQAudioProcessorEditor (SimpleEQAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p)
+    : AudioProcessorEditor (&p), audioProcessor (p), spectrumDisplay (p)
 {
+    addAndMakeVisible(spectrumDisplay);
+    
+    addSlider(lowCutFreqSlider, LOW_CUT_FREQ, LOW_CUT_FREQ_LABEL);
+    addComboBox(lowCutSlopeBox, LOW_CUT_SLOPE, LOW_CUT_SLOPE_LABEL);
+    
+    addSlider(peakFreqSlider, PEAK_FREQ, PEAK_FREQ_LABEL);
+    addSlider(peakGainSlider, PEAK_GAIN, PEAK_GAIN_LABEL);
+    addSlider(peakQSlider, PEAK_Q, PEAK_Q_LABEL);
+    
+    addSlider(highCutFreqSlider, HIGH_CUT_FREQ, HIGH_CUT_FREQ_LABEL);
+    addComboBox(highCutSlopeBox, HIGH_CUT_SLOPE, HIGH_CUT_SLOPE_LABEL);
+    
+    auto tabColour = getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId);
+    parameterTabs.addTab("Bands", tabColour, new BandPage(p.ap_tree_state), true);
+    parameterTabs.addTab("Mid/Side", tabColour, new MidSidePage(p.ap_tree_state), true);
+    parameterTabs.addTab("Dynamics", tabColour, new DynamicsPage(p.ap_tree_state), true);
+    parameterTabs.addTab("Processing", tabColour, new ProcessingPage(p.ap_tree_state), true);
+    addAndMakeVisible(parameterTabs);
+    
+    loadLabel.setJustificationType(juce::Justification::centredLeft);
+    loadLabel.setFont(12.0f);
+    addAndMakeVisible(loadLabel);
+    
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (400, 300);
+    setSize (600, 780);
+    
+    // The load statistics don't need to update any faster than this
+    startTimerHz(4);
+    timerCallback();
 }
 
 SimpleEQAudioProcessorEditor::~SimpleEQAudioProcessorEditor()
 {
 }
 
+void SimpleEQAudioProcessorEditor::addSlider(juce::Slider& slider, const std::string& parameterID, const std::string& labelText)
+{
+    slider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
+    slider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 80, 20);
+    addAndMakeVisible(slider);
+    
+    auto* label = controlLabels.add(new juce::Label({}, labelText));
+    label->setJustificationType(juce::Justification::centred);
+    label->attachToComponent(&slider, false);
+    
+    sliderAttachments.add(new SliderAttachment(audioProcessor.ap_tree_state, parameterID, slider));
+}
+
+void SimpleEQAudioProcessorEditor::addComboBox(juce::ComboBox& comboBox, const std::string& parameterID, const std::string& labelText)
+{
+    // The items have to be there before the attachment is made, so it can
+    // select the current one
+    if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(audioProcessor.ap_tree_state.getParameter(parameterID)))
+        comboBox.addItemList(choice->choices, 1);
+    
+    addAndMakeVisible(comboBox);
+    
+    auto* label = controlLabels.add(new juce::Label({}, labelText));
+    label->setJustificationType(juce::Justification::centred);
+    label->attachToComponent(&comboBox, false);
+    
+    comboBoxAttachments.add(new ComboBoxAttachment(audioProcessor.ap_tree_state, parameterID, comboBox));
+}
+
 //==============================================================================
 void SimpleEQAudioProcessorEditor::paint (juce::Graphics& g)
 {
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
-
-    g.setColour (juce::Colours::white);
-    g.setFont (15.0f);
-    g.drawFittedText ("Hello World!", getLocalBounds(), juce::Justification::centred, 1);
 }
 
 void SimpleEQAudioProcessorEditor::resized()
 {
-    // This is generally where you'll want to lay out the positions of any
-    // subcomponents in your editor..
+    auto bounds = getLocalBounds().reduced(10);
+    
+    spectrumDisplay.setBounds(bounds.removeFromTop(180));
+    bounds.removeFromTop(10);
+    
+    loadLabel.setBounds(bounds.removeFromBottom(20));
+    bounds.removeFromBottom(10);
+    
+    parameterTabs.setBounds(bounds.removeFromBottom(250));
+    bounds.removeFromBottom(10);
+    
+    // Three columns: low cut, peak, high cut. Leave room above each control
+    // for its label.
+    auto columnWidth = bounds.getWidth() / 3;
+    auto lowCutArea = bounds.removeFromLeft(columnWidth);
+    auto highCutArea = bounds.removeFromRight(columnWidth);
+    auto peakArea = bounds;
+    
+    auto labelHeight = 20;
+    auto comboBoxHeight = 24;
+    
+    lowCutArea.removeFromTop(labelHeight);
+    lowCutSlopeBox.setBounds(lowCutArea.removeFromBottom(comboBoxHeight).reduced(10, 0));
+    lowCutArea.removeFromBottom(labelHeight + 5);
+    lowCutFreqSlider.setBounds(lowCutArea);
+    
+    highCutArea.removeFromTop(labelHeight);
+    highCutSlopeBox.setBounds(highCutArea.removeFromBottom(comboBoxHeight).reduced(10, 0));
+    highCutArea.removeFromBottom(labelHeight + 5);
+    highCutFreqSlider.setBounds(highCutArea);
+    
+    auto peakRowHeight = peakArea.getHeight() / 3;
+    
+    for (auto* slider : { &peakFreqSlider, &peakGainSlider, &peakQSlider })
+    {
+        auto row = peakArea.removeFromTop(peakRowHeight);
+        row.removeFromTop(labelHeight);
+        slider->setBounds(row);
+    }
+}
+
+void SimpleEQAudioProcessorEditor::timerCallback()
+{
+    auto snapshot = audioProcessor.getLoadSnapshot();
+    
+    auto percent = [](double load) { return juce::String(load * 100.0, 1) + "%"; };
+    
+    loadLabel.setText("DSP load  avg " + percent(snapshot.averageLoad)
+                      + "   p99 " + percent(snapshot.p99Load)
+                      + "   max " + percent(snapshot.maxLoad)
+                      + " (" + juce::String(snapshot.maxBlockMicroseconds, 1) + " us)"
+                      + "   overruns " + juce::String(snapshot.numOverruns),
+                      juce::dontSendNotification);
 }
@@ -10,11 +10,14 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "SpectrumDisplay.h"
+#include "ParameterPages.h"
 
 //==============================================================================
 /**
 */
-class SimpleEQAudioProcessorEditor  : public juce::AudioProcessorEditor
+class SimpleEQAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                      private juce::Timer
 {
 public:
     SimpleEQAudioProcessorEditor (SimpleEQAudioProcessor&);
@@ -25,9 +28,40 @@ public:
     void resized() override;
 
 private:
+    // Refreshes the DSP load readout
+    void timerCallback() override;
+    
+    void addSlider(juce::Slider& slider, const std::string& parameterID, const std::string& labelText);
+    void addComboBox(juce::ComboBox& comboBox, const std::string& parameterID, const std::string& labelText);
+    
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     SimpleEQAudioProcessor& audioProcessor;
+    
+    using SliderAttachment = juce::AudioProcessorValueTreeState::SliderAttachment;
+    using ComboBoxAttachment = juce::AudioProcessorValueTreeState::ComboBoxAttachment;
+    
+    // One control per parameter, grouped by band
+    juce::Slider lowCutFreqSlider;
+    juce::ComboBox lowCutSlopeBox;
+    
+    juce::Slider peakFreqSlider, peakGainSlider, peakQSlider;
+    
+    juce::Slider highCutFreqSlider;
+    juce::ComboBox highCutSlopeBox;
+    
+    juce::OwnedArray<juce::Label> controlLabels;
+    juce::OwnedArray<SliderAttachment> sliderAttachments;
+    juce::OwnedArray<ComboBoxAttachment> comboBoxAttachments;
+    
+    // Shows how much of the audio callback this instance is using
+    juce::Label loadLabel;
+    
+    // The input and output spectra. The analyzer runs while this exists.
+    SpectrumDisplay spectrumDisplay;
+    
+    // Everything else, a page per group of parameters
+    juce::TabbedComponent parameterTabs { juce::TabbedButtonBar::TabsAtTop };
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SimpleEQAudioProcessorEditor)
 };
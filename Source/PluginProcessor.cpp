@@ -8,6 +8,7 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "PluginState.h"
 
 //==============================================================================
 SimpleEQAudioProcessor::SimpleEQAudioProcessor()
@@ -16,16 +17,21 @@ SimpleEQAudioProcessor::SimpleEQAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
                        )
 #endif
 {
+    for (auto* parameterID : { &OVERSAMPLING, &LINEAR_PHASE, &KERNEL_SIZE })
+        ap_tree_state.addParameterListener(*parameterID, this);
 }
 
 SimpleEQAudioProcessor::~SimpleEQAudioProcessor()
 {
+    for (auto* parameterID : { &OVERSAMPLING, &LINEAR_PHASE, &KERNEL_SIZE })
+        ap_tree_state.removeParameterListener(*parameterID, this);
 }
 
 //==============================================================================
@@ -63,27 +69,44 @@ bool SimpleEQAudioProcessor::isMidiEffect() const
 
 double SimpleEQAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // A linear phase kernel rings for its whole length
+    if (linearPhase && getSampleRate() > 0.0)
+        return linearPhaseEngine.getKernelSize() / getSampleRate();
+    
+    // Worked out from the current designs, see calculateTailSamples
+    return tailLengthSeconds;
 }
 
 int SimpleEQAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    // The factory presets
+    return presetBank.getNumPresets();
 }
 
 int SimpleEQAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram;
 }
 
 void SimpleEQAudioProcessor::setCurrentProgram (int index)
 {
+    if (! juce::isPositiveAndBelow(index, presetBank.getNumPresets()))
+        return;
+    
+    currentProgram = index;
+    
+    // Tell the audio thread before touching the parameters, so it crossfades
+    // to the preset's ready-made coefficients instead of ramping through
+    // whatever the parameter changes would design
+    pendingPreset = index;
+    
+    const CoefficientEngine::ScopedBatch batch(coefficientEngine);
+    setChainSettings(ap_tree_state, presetBank.getSettings(index));
 }
 
 const juce::String SimpleEQAudioProcessor::getProgramName (int index)
 {
-    return {};
+    return presetBank.getName(index);
 }
 
 void SimpleEQAudioProcessor::changeProgramName (int index, const juce::String& newName)
@@ -96,57 +119,427 @@ void SimpleEQAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlo
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
     
+    // One MonoChain for every channel in the current layout. The sidechain
+    // only feeds the peak band's detector, so it isn't counted.
+    auto numChannels = getMainBusNumInputChannels();
+    
+    // The host picks the precision before preparing us
+    usingDoublePrecision = isUsingDoublePrecision();
+    activeFilterTopology = getFilterTopology();
+    linearPhase = isLinearPhase();
+    
+    // When oversampling, everything from here on runs at the higher rate on
+    // the longer blocks, apart from the load meter and the analyzer, which
+    // see the host's blocks
+    prepareOversampler(numChannels, samplesPerBlock);
+    
+    auto hostSampleRate = sampleRate;
+    auto hostBlockSize = samplesPerBlock;
+    sampleRate *= oversamplingFactor;
+    samplesPerBlock *= oversamplingFactor;
+    processingSampleRate = sampleRate;
+    
     // Set up the processing spec to be used by each processing chain.
     juce::dsp::ProcessSpec spec;
     spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = 1;  // We process left and right channels separately, so 1 channel per spec
+    spec.numChannels = 1;  // Each MonoChain processes a single channel, so 1 channel per spec
     spec.sampleRate = sampleRate;
     
-    leftChain.prepare(spec);
-    rightChain.prepare(spec);
+    for (auto& slot : filterSlots)
+    {
+        slot.monoChains.clear();
+        
+        for (int channel = 0; channel < numChannels; ++channel)
+            prepareChain(*slot.monoChains.add(new MonoChain()), spec);
+        
+        // The SIMD engine and the band array handle every channel themselves
+        auto multiChannelSpec = spec;
+        multiChannelSpec.numChannels = (juce::uint32) numChannels;
+        
+       #if JUCE_USE_SIMD
+        slot.simdEngine.prepare(multiChannelSpec);
+       #endif
+        slot.cascadeEngine.prepare(multiChannelSpec);
+        slot.bandArray.prepare(multiChannelSpec);
+        
+        // The side channel is a single channel
+        slot.sideBandArray.prepare(spec);
+        
+        if (usingDoublePrecision)
+        {
+            slot.doubleBandArray.prepare(multiChannelSpec);
+            slot.doubleSideBandArray.prepare(spec);
+        }
+    }
+    
+    setSlotsTopology(activeFilterTopology);
+    
+    // Design the coefficients for the new sample rate and apply them right
+    // away so the first block is processed with the correct settings
+    coefficientEngine.prepare(sampleRate, cacheFillMode);
+    parameterSmoother.prepare(sampleRate);
+    loadMeter.prepare(hostSampleRate);
+    spectrumAnalyzer.prepare(hostSampleRate);
+    dynamicPeak.prepare(hostSampleRate, sampleRate, hostBlockSize);
+    stageElider.prepare(sampleRate, numChannels, samplesPerBlock, usingDoublePrecision);
+    
+    // Every preset gets its coefficients designed now, so switching to one
+    // later needs no design work at all
+    presetBank.prepare(coefficientEngine);
+    presetFadeLength = juce::jmax(1, juce::roundToInt(sampleRate * 0.01));
     
-    applyCoefficients(sampleRate);
+    // Only the precision in use gets a real buffer
+    auto fadeBufferChannels = juce::jmax(1, numChannels);
+    auto fadeBufferSamples = juce::jmax(1, samplesPerBlock);
+    presetFadeBuffer.setSize(fadeBufferChannels, usingDoublePrecision ? 1 : fadeBufferSamples);
+    doublePresetFadeBuffer.setSize(fadeBufferChannels, usingDoublePrecision ? fadeBufferSamples : 1);
+    presetFadeSamplesRemaining = 0;
+    
+    // The parameters already hold any preset picked before now
+    pendingPreset = -1;
+    
+    if (auto* chainCoefficients = coefficientEngine.pullLatest())
+    {
+        latestCoefficients = *chainCoefficients;
+        parameterSmoother.reset(latestCoefficients.settings);
+        applyCoefficients(latestCoefficients);
+        usingSmoothedCoefficients = false;
+        tailLengthSeconds = latestCoefficients.tailSamples / sampleRate;
+    }
+    
+    // Everything starts from silence
+    numSilentSamples = 0;
+    filtersAsleep = false;
+    
+    // Start with just the bands that are doing something, no fades needed
+    stageElider.setEnabled(stageElisionEnabled);
+    stageElider.reset(latestCoefficients.settings);
+    updateStageBypass();
+    
+    // The filters above are still set up in linear phase mode, but they
+    // don't run. Oversampling is off, so this is the host's rate.
+    if (linearPhase)
+    {
+        spec.numChannels = (juce::uint32) numChannels;
+        linearPhaseEngine.prepare(spec, getLinearPhaseKernelSize());
+        setLatencySamples(linearPhaseEngine.getLatencySamples());
+    }
+    else
+    {
+        linearPhaseEngine.release();
+    }
+    
+    isPrepared = true;
+}
+
+void SimpleEQAudioProcessor::prepareOversampler(int numChannels, int samplesPerBlock)
+{
+    oversamplingFactor = linearPhase ? 1 : getOversamplingFactor();
+    oversampler.reset();
+    doubleOversampler.reset();
+    
+    if (oversamplingFactor == 1 || numChannels == 0)
+    {
+        oversamplingFactor = 1;
+        setLatencySamples(0);
+        return;
+    }
+    
+    // Polyphase IIR half-band stages, one per doubling, at their steepest.
+    // They're far cheaper than the linear phase FIR ones and add only a few
+    // samples of latency, rounded up to a whole sample so it can be
+    // reported exactly.
+    auto order = (size_t) (oversamplingFactor == 4 ? 2 : 1);
+    float latency = 0.f;
+    
+    if (usingDoublePrecision)
+    {
+        doubleOversampler = std::make_unique<juce::dsp::Oversampling<double>>((size_t) numChannels, order,
+                                                                              juce::dsp::Oversampling<double>::filterHalfBandPolyphaseIIR,
+                                                                              true, true);
+        doubleOversampler->initProcessing((size_t) samplesPerBlock);
+        latency = (float) doubleOversampler->getLatencyInSamples();
+    }
+    else
+    {
+        oversampler = std::make_unique<juce::dsp::Oversampling<float>>((size_t) numChannels, order,
+                                                                       juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR,
+                                                                       true, true);
+        oversampler->initProcessing((size_t) samplesPerBlock);
+        latency = oversampler->getLatencyInSamples();
+    }
+    
+    setLatencySamples(juce::roundToInt(latency));
+}
+
+void SimpleEQAudioProcessor::setLinearPhase(bool shouldBeLinear, int kernelSize)
+{
+    // The size first, so a prepare for the switch picks up the new size
+    if (auto* parameter = ap_tree_state.getParameter(KERNEL_SIZE))
+        parameter->setValueNotifyingHost(parameter->convertTo0to1((float) LinearPhaseEngine::getChoiceForKernelSize(kernelSize)));
+    
+    if (auto* parameter = ap_tree_state.getParameter(LINEAR_PHASE))
+        parameter->setValueNotifyingHost(shouldBeLinear ? 1.f : 0.f);
+}
+
+bool SimpleEQAudioProcessor::isLinearPhase() const noexcept
+{
+    return linearPhaseSwitch->load() > 0.5f;
+}
+
+int SimpleEQAudioProcessor::getLinearPhaseKernelSize() const noexcept
+{
+    return LinearPhaseEngine::getKernelSizeForChoice(juce::roundToInt(kernelSizeChoice->load()));
+}
+
+void SimpleEQAudioProcessor::setOversamplingFactor(int newFactor)
+{
+    // Only 2x and 4x are offered, as choices 1 and 2
+    if (auto* parameter = ap_tree_state.getParameter(OVERSAMPLING))
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(newFactor >= 4 ? 2.f : (newFactor >= 2 ? 1.f : 0.f)));
 }
 
-void SimpleEQAudioProcessor::applyCoefficients(double sampleRate)
+int SimpleEQAudioProcessor::getOversamplingFactor() const noexcept
 {
-    auto chainSettings = getChainSettings(ap_tree_state);
-    auto peakCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, chainSettings.peakFreq, chainSettings.peakQ, juce::Decibels::decibelsToGain(chainSettings.peakGain));
+    return 1 << juce::jlimit(0, 2, juce::roundToInt(oversamplingChoice->load()));
+}
+
+void SimpleEQAudioProcessor::parameterChanged(const juce::String&, float)
+{
+    // This can be called from any thread, the audio thread included
+    triggerAsyncUpdate();
+}
+
+void SimpleEQAudioProcessor::handleAsyncUpdate()
+{
+    if (! isPrepared || ! needsPrepareForProcessingOptions())
+        return;
+    
+    suspendProcessing(true);
+    prepareToPlay(getSampleRate(), getBlockSize());
+    suspendProcessing(false);
+}
+
+bool SimpleEQAudioProcessor::needsPrepareForProcessingOptions() const noexcept
+{
+    // Linear phase mode doesn't oversample, whatever the setting, and the
+    // kernel size only matters in linear phase mode
+    if (isLinearPhase() != linearPhase)
+        return true;
+    
+    if (linearPhase)
+        return getLinearPhaseKernelSize() != linearPhaseEngine.getKernelSize();
+    
+    return getOversamplingFactor() != oversamplingFactor;
+}
+
+template <typename SampleType>
+juce::dsp::AudioBlock<SampleType> SimpleEQAudioProcessor::upsample(const juce::dsp::AudioBlock<SampleType>& block)
+{
+    if (auto* resampler = getOversampler(SampleType()))
+        return resampler->processSamplesUp(block);
+    
+    return block;
+}
+
+template <typename SampleType>
+void SimpleEQAudioProcessor::downsample(juce::dsp::AudioBlock<SampleType>& block)
+{
+    if (auto* resampler = getOversampler(SampleType()))
+        resampler->processSamplesDown(block);
+}
+
+void SimpleEQAudioProcessor::prepareChain(MonoChain& chain, const juce::dsp::ProcessSpec& spec)
+{
+    // Give every filter its own second order coefficients object before
+    // preparing. From then on the audio thread only overwrites the values
+    // inside these objects, so it never has to allocate new ones, and the
+    // filter state is already sized for a biquad.
+    auto makeBiquad = [] { return new juce::dsp::IIR::Coefficients<float>(1.f, 0.f, 0.f, 1.f, 0.f, 0.f); };
+    
+    chain.get<ChainPositions::LowCut>().get<Slope_12>().coefficients = makeBiquad();
+    chain.get<ChainPositions::LowCut>().get<Slope_24>().coefficients = makeBiquad();
+    chain.get<ChainPositions::LowCut>().get<Slope_36>().coefficients = makeBiquad();
+    chain.get<ChainPositions::LowCut>().get<Slope_48>().coefficients = makeBiquad();
+    
+    chain.get<ChainPositions::Peak>().coefficients = makeBiquad();
+    
+    chain.get<ChainPositions::HighCut>().get<Slope_12>().coefficients = makeBiquad();
+    chain.get<ChainPositions::HighCut>().get<Slope_24>().coefficients = makeBiquad();
+    chain.get<ChainPositions::HighCut>().get<Slope_36>().coefficients = makeBiquad();
+    chain.get<ChainPositions::HighCut>().get<Slope_48>().coefficients = makeBiquad();
+    
+    chain.prepare(spec);
+}
+
+// Copies a designed biquad into a filter's existing coefficients object.
+// No allocation happens here; see prepareChain.
+static void setFilterCoefficients(juce::dsp::IIR::Filter<float>& filter, const BiquadCoefficients& coefficients)
+{
+    auto& destination = filter.coefficients->coefficients;
+    jassert(destination.size() == (int) coefficients.size());
+    std::copy(coefficients.begin(), coefficients.end(), destination.getRawDataPointer());
+}
+
+void SimpleEQAudioProcessor::applyCoefficients(const ChainCoefficients& chainCoefficients)
+{
+    const auto& chainSettings = chainCoefficients.settings;
+    auto& slot = getActiveSlot();
+    
+    // The side channel's three bands aren't in the engine's designs, so
+    // they're designed here, the way the double path does all its bands
+    if (chainSettings.midSide)
+    {
+        if (usingDoublePrecision)
+            slot.doubleSideBandArray.setChainSettings(getSideChannelSettings(chainSettings));
+        else
+            slot.sideBandArray.setChainSettings(getSideChannelSettings(chainSettings));
+    }
+    
+    // In double everything runs in the double band array, which designs its
+    // own coefficients from the settings so they're double all the way
+    // through. The designs are closed form, so this doesn't allocate.
+    if (usingDoublePrecision)
+    {
+        slot.doubleBandArray.setChainSettings(chainSettings);
+        return;
+    }
+    
+    // Every channel shares the same coefficients
+    for (auto* chain : slot.monoChains)
+    {
+        // Apply the peak band coefficients
+        setFilterCoefficients(chain->get<ChainPositions::Peak>(), chainCoefficients.peak);
+        
+        // Apply the low and high cuts
+        applyCutFilter(chain->get<ChainPositions::LowCut>(), chainCoefficients.lowCut, chainSettings.lowCutSlope);
+        applyCutFilter(chain->get<ChainPositions::HighCut>(), chainCoefficients.highCut, chainSettings.highCutSlope);
+    }
+    
+   #if JUCE_USE_SIMD
+    slot.simdEngine.setCoefficients(chainCoefficients);
+   #endif
+    slot.cascadeEngine.setCoefficients(chainCoefficients);
+    
+    // The state variable filter can't use biquad coefficients, so the band
+    // array designs its own
+    if (activeFilterTopology == FilterTopology::stateVariable)
+        slot.bandArray.setChainSettings(chainSettings);
+    else
+        slot.bandArray.setChainCoefficients(chainCoefficients);
+}
+
+void SimpleEQAudioProcessor::applyDynamicPeak(const SimpleEQSettings& chainSettings, int chunk)
+{
+    auto& slot = getActiveSlot();
+    auto gainDecibels = dynamicPeak.getGainDecibels(chunk, chainSettings);
+    
+    if (usingDoublePrecision)
+    {
+        slot.doubleBandArray.setPeak(dynamicPeak.makeCoefficients<double>(chainSettings, gainDecibels),
+                                     { true, BandType::peak, chainSettings.peakFreq, gainDecibels, chainSettings.peakQ });
+        return;
+    }
     
-    // Apply the peak band coefficients to both channels
-    leftChain.get<ChainPositions::Peak>().coefficients = *peakCoefficients;
-    rightChain.get<ChainPositions::Peak>().coefficients = *peakCoefficients;
+    // Only the engine that's running the peak gets the new design. The
+    // others are brought up to date by the next applyCoefficients, which
+    // always comes before they run again.
+    auto coefficients = dynamicPeak.makeCoefficients<float>(chainSettings, gainDecibels);
+    
+    if (slot.processingMidSide || isUsingBandArray())
+    {
+        slot.bandArray.setPeak(coefficients, { true, BandType::peak, chainSettings.peakFreq, gainDecibels, chainSettings.peakQ });
+        return;
+    }
+    
+   #if JUCE_USE_SIMD
+    if (activeFilterEngine == FilterEngine::simd)
+    {
+        slot.simdEngine.setPeakCoefficients(coefficients);
+        return;
+    }
+   #endif
+    
+    if (activeFilterEngine == FilterEngine::cascade)
+    {
+        slot.cascadeEngine.setPeakCoefficients(coefficients);
+        return;
+    }
+    
+    for (auto* chain : slot.monoChains)
+        setFilterCoefficients(chain->get<ChainPositions::Peak>(), coefficients);
+}
+
+void SimpleEQAudioProcessor::setParameterSmoothing(bool shouldSmooth, int updateIntervalSamples) noexcept
+{
+    smoothingInterval = juce::jlimit(8, 64, updateIntervalSamples);
+    smoothingEnabled = shouldSmooth;
+}
 
-    // Apply the low cut to both channels. First calculate the order
-    // based on the selected slope. Then get the coefficients and apply them.
-    int lowCutOrder = (chainSettings.lowCutSlope + 1) * 2;
-    auto lowCutCoefficients = juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq, sampleRate, lowCutOrder);
-    auto& leftLowCut = leftChain.get<ChainPositions::LowCut>();
-    auto& rightLowCut = rightChain.get<ChainPositions::LowCut>();
+void SimpleEQAudioProcessor::setFilterTopology(FilterTopology newTopology)
+{
+    if (auto* parameter = ap_tree_state.getParameter(FILTER_TOPOLOGY))
+        parameter->setValueNotifyingHost(parameter->convertTo0to1((float) static_cast<int>(newTopology)));
+}
+
+FilterTopology SimpleEQAudioProcessor::getFilterTopology() const noexcept
+{
+    return juce::roundToInt(filterTopology->load()) == 1 ? FilterTopology::stateVariable
+                                                          : FilterTopology::transposedDirectForm;
+}
 
-    // Apply the low cut to both channels
-    applyCutFilter(leftLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
-    applyCutFilter(rightLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
+ProcessingSettings SimpleEQAudioProcessor::loadProcessingSettings() const noexcept
+{
+    ProcessingSettings settings;
+    settings.filterTopology = getFilterTopology();
+    settings.oversamplingFactor = getOversamplingFactor();
+    settings.linearPhase = isLinearPhase();
+    settings.linearPhaseKernelSize = getLinearPhaseKernelSize();
+    return settings;
+}
+
+void SimpleEQAudioProcessor::setStageElision(bool shouldElide) noexcept
+{
+    stageElisionEnabled = shouldElide;
+}
+
+const ResponseCurve& SimpleEQAudioProcessor::getResponseCurve()
+{
+    // Drawn at the rate the filters run at, so oversampling shows, or the
+    // rate the linear phase kernel is designed at. Before prepareToPlay
+    // there's no rate yet, so draw it as if at 44.1 kHz.
+    auto sampleRate = processingSampleRate > 0.0 ? processingSampleRate.load() : 44100.0;
+    
+    if (linearPhase)
+        sampleRate *= LinearPhaseEngine::evaluationOversampling;
+    
+    if (sampleRate != responseCurve.getSampleRate())
+        responseCurve.prepare(sampleRate);
     
-    // Apply the high cut to both channels. First calculate the order
-    // based on the selected slope. Then get the coefficients and apply them.
-    int highCutOrder = (chainSettings.highCutSlope + 1) * 2;
-    auto highCutCoefficients = juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq, sampleRate, highCutOrder);
-    auto& leftHighCut = leftChain.get<ChainPositions::HighCut>();
-    auto& rightHighCut = rightChain.get<ChainPositions::HighCut>();
+    responseCurve.setSkipNeutralBands(stageElisionEnabled);
+    responseCurve.update(chainParameters.load());
+    return responseCurve;
+}
 
-    // Apply the high cut to both channels
-    applyCutFilter(leftHighCut, highCutCoefficients, chainSettings.highCutSlope);
-    applyCutFilter(rightHighCut, highCutCoefficients, chainSettings.highCutSlope);
+void SimpleEQAudioProcessor::setFilterEngine(FilterEngine newEngine) noexcept
+{
+   #if ! JUCE_USE_SIMD
+    // Without SIMD support the SIMD engine isn't there, so fall back to the
+    // MonoChain path
+    if (newEngine == FilterEngine::simd)
+        newEngine = FilterEngine::monoChains;
+   #endif
+    
+    filterEngine = newEngine;
 }
 
-void SimpleEQAudioProcessor::applyCutFilter(CutFilter& cutFilter, juce::ReferenceCountedArray<juce::dsp::FilterDesign<float>::IIRCoefficients> coefficients, Slope slope)
+void SimpleEQAudioProcessor::applyCutFilter(CutFilter& cutFilter, const std::array<BiquadCoefficients, 4>& coefficients, Slope slope)
 {
     
     // The first filter is always enabled since a 12 db/oct slope
     // is the lowest option
     cutFilter.setBypassed<Slope_12>(false);
-    cutFilter.get<Slope_12>().coefficients = *coefficients[Slope_12];
+    setFilterCoefficients(cutFilter.get<Slope_12>(), coefficients[Slope_12]);
     
     // Bypass the remaining cut filters to start. We'll re-enable
     // them as needed if a higher slope is selected
@@ -160,21 +553,21 @@ void SimpleEQAudioProcessor::applyCutFilter(CutFilter& cutFilter, juce::Referenc
             // do nothing. See comment above.
             break;
         case Slope_24:
-            cutFilter.get<Slope_24>().coefficients = *coefficients[Slope_24];
+            setFilterCoefficients(cutFilter.get<Slope_24>(), coefficients[Slope_24]);
             cutFilter.setBypassed<Slope_24>(false);
             break;
         case Slope_36:
-            cutFilter.get<Slope_24>().coefficients = *coefficients[Slope_24];
+            setFilterCoefficients(cutFilter.get<Slope_24>(), coefficients[Slope_24]);
             cutFilter.setBypassed<Slope_24>(false);
-            cutFilter.get<Slope_36>().coefficients = *coefficients[Slope_36];
+            setFilterCoefficients(cutFilter.get<Slope_36>(), coefficients[Slope_36]);
             cutFilter.setBypassed<Slope_36>(false);
             break;
         case Slope_48:
-            cutFilter.get<Slope_24>().coefficients = *coefficients[Slope_24];
+            setFilterCoefficients(cutFilter.get<Slope_24>(), coefficients[Slope_24]);
             cutFilter.setBypassed<Slope_24>(false);
-            cutFilter.get<Slope_36>().coefficients = *coefficients[Slope_36];
+            setFilterCoefficients(cutFilter.get<Slope_36>(), coefficients[Slope_36]);
             cutFilter.setBypassed<Slope_36>(false);
-            cutFilter.get<Slope_48>().coefficients = *coefficients[Slope_48];
+            setFilterCoefficients(cutFilter.get<Slope_48>(), coefficients[Slope_48]);
             cutFilter.setBypassed<Slope_48>(false);
             break;
     }
@@ -184,6 +577,13 @@ void SimpleEQAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    isPrepared = false;
+    
+    // Leave a record of how this instance did in the host's log
+    auto loadSnapshot = loadMeter.getSnapshot();
+    
+    if (loadSnapshot.numBlocks > 0)
+        juce::Logger::writeToLog("SimpleEQ: " + loadSnapshot.toString());
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -193,12 +593,11 @@ bool SimpleEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Every channel gets the same EQ, so any layout works, from mono up to
+    // immersive and ambisonic buses. We just need at least one channel. The
+    // sidechain is summed to mono for the peak band's detector, so it can
+    // have any layout, or be off.
+    if (layouts.getMainOutputChannelSet().isDisabled())
         return false;
 
     // This checks if the input layout matches the output layout
@@ -212,11 +611,33 @@ bool SimpleEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
 }
 #endif
 
-void SimpleEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+bool SimpleEQAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+void SimpleEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    jassert(! usingDoublePrecision);
+    processSamples(buffer);
+}
+
+void SimpleEQAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    jassert(usingDoublePrecision);
+    processSamples(buffer);
+}
+
+template <typename SampleType>
+void SimpleEQAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer)
 {
     juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
+    LoadMeter::ScopedBlock blockTimer(loadMeter, buffer.getNumSamples());
+    
+    // Just the main buses. Any sidechain channels come after these in the
+    // buffer, and are only read by the peak band's detector.
+    auto totalNumInputChannels  = getMainBusNumInputChannels();
+    auto totalNumOutputChannels = getMainBusNumOutputChannels();
 
     // In case we have more outputs than inputs, this code clears any output
     // channels that didn't contain input data, (because these aren't
@@ -227,21 +648,627 @@ void SimpleEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juc
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
     
-    // Apply the coefficients to each channel before processing the audio
-    applyCoefficients(getSampleRate());
+    // Pick up any coefficients the engine has designed since the last block.
+    // This is just an atomic swap and a copy, so nothing here allocates or
+    // locks. With smoothing on, the new settings become the ramp targets.
+    blockTimer.beginCoefficients();
+    
+    auto shouldSmooth = smoothingEnabled.load();
+    bool hasNewCoefficients = false;
+    
+    // A new topology needs the bands set again from scratch, and may move
+    // the float path to or from the band array, so start from clean state.
+    // The old preset's slot is cleared along with the rest, so cut any
+    // preset fade short.
+    auto requestedTopology = getFilterTopology();
+    
+    if (requestedTopology != activeFilterTopology)
+    {
+        setSlotsTopology(requestedTopology);
+        resetSlot(getActiveSlot());
+        presetFadeSamplesRemaining = 0;
+        hasNewCoefficients = true;
+    }
+    
+    if (auto* chainCoefficients = coefficientEngine.pullLatest())
+    {
+        // A set where only the dynamics' settings changed has the same
+        // designs the filters are already running, so there's nothing to
+        // apply or ramp. Unless they've just been switched on or off, which
+        // moves the peak between its own design and the detector's.
+        auto changedGroups = ChainParameters::getChangedGroups(latestCoefficients.versions, chainCoefficients->versions);
+        auto onlyDynamicsChanged = changedGroups == (1 << DynamicGroup)
+                                    && chainCoefficients->settings.dynamic.enabled == latestCoefficients.settings.dynamic.enabled;
+        
+        latestCoefficients = *chainCoefficients;
+        tailLengthSeconds = latestCoefficients.tailSamples / processingSampleRate;
+        
+        // The smoother only ramps the cuts and peak. The extra bands switch
+        // straight to their new designs, whether or not a ramp is running.
+        smoothedCoefficients.settings.extraBands = latestCoefficients.settings.extraBands;
+        smoothedCoefficients.extraBands = latestCoefficients.extraBands;
+        
+        // Nor does it ramp the side channel
+        smoothedCoefficients.settings.midSide = latestCoefficients.settings.midSide;
+        smoothedCoefficients.settings.side = latestCoefficients.settings.side;
+        
+        // Or the peak band's dynamics, which follow the detector instead
+        smoothedCoefficients.settings.dynamic = latestCoefficients.settings.dynamic;
+        
+        if (! onlyDynamicsChanged)
+        {
+            hasNewCoefficients = true;
+            
+            if (shouldSmooth)
+                parameterSmoother.setTargets(latestCoefficients.settings);
+            else
+                parameterSmoother.reset(latestCoefficients.settings);
+        }
+    }
+    
+    // A preset change overrides whatever the parameters were doing. Its
+    // coefficients are already designed and get applied right here.
+    auto presetIndex = pendingPreset.exchange(-1);
+    
+    if (presetIndex >= 0 && presetBank.isPrepared())
+    {
+        startPresetFade(presetIndex);
+        hasNewCoefficients = false;
+    }
+    
+    // Mid and side filter state means nothing to the stereo filters and
+    // the other way round, so switching mode starts from clean state, like
+    // a topology change does. Only the active slot switches. During a
+    // preset fade the old slot keeps running in the mode it had, so a
+    // preset that changes mode still fades.
+    auto shouldProcessMidSide = latestCoefficients.settings.midSide && totalNumInputChannels == 2;
+    
+    if (shouldProcessMidSide != getActiveSlot().processingMidSide)
+    {
+        getActiveSlot().processingMidSide = shouldProcessMidSide;
+        resetSlot(getActiveSlot());
+    }
+    
+    auto isSmoothing = shouldSmooth && parameterSmoother.isSmoothing();
+    
+    // When there's no ramp running, the filters use the engine's exact
+    // designs. This also puts them back once a ramp has finished.
+    if (! isSmoothing && (hasNewCoefficients || usingSmoothedCoefficients))
+    {
+        applyCoefficients(latestCoefficients);
+        usingSmoothedCoefficients = false;
+    }
+    
+    stageElider.setEnabled(stageElisionEnabled);
+    
+    blockTimer.endCoefficients();
+
+    // If the engine has been switched, clear the state of the one we're
+    // switching to so it doesn't start from whatever it had last time. The
+    // old preset's slot would need the same, so cut any preset fade short.
+    auto requestedEngine = filterEngine.load();
+    
+    if (requestedEngine != activeFilterEngine)
+    {
+        resetSlot(getActiveSlot());
+        presetFadeSamplesRemaining = 0;
+        activeFilterEngine = requestedEngine;
+    }
+
+    juce::dsp::AudioBlock<SampleType> block(buffer);
+    auto inputBlock = block.getSubsetChannelBlock(0, (size_t) juce::jmin(totalNumInputChannels, (int) block.getNumChannels()));
+    
+    // This does nothing unless the editor is showing the analyzer
+    spectrumAnalyzer.pushInput(inputBlock);
+    
+    // In linear phase mode the convolution does all the filtering. The
+    // kernel has its own designer, so nothing above is needed for it.
+    if (linearPhase)
+    {
+        linearPhaseEngine.process(inputBlock);
+        spectrumAnalyzer.pushOutput(inputBlock);
+        return;
+    }
+    
+    // The peak band's dynamics listen to the input, or the sidechain if
+    // that's picked and connected, before anything is filtered. The block is
+    // split into chunks of one smoothing interval at the filters' rate, and
+    // each one gets its own peak gain. This runs even if the block turns out
+    // to be silent, so the envelope keeps falling.
+    const auto& dynamicSettings = latestCoefficients.settings.dynamic;
+    auto isDynamic = dynamicSettings.enabled;
+    auto hostInterval = juce::jmax(1, smoothingInterval.load() / oversamplingFactor);
+    
+    if (isDynamic)
+    {
+        auto detectorBlock = inputBlock;
+        
+        if (dynamicSettings.useSidechain && getBusCount(true) > 1)
+        {
+            auto numSidechainChannels = (size_t) getChannelCountOfBus(true, 1);
+            auto firstSidechainChannel = (size_t) getChannelIndexInProcessBlockBuffer(true, 1, 0);
+            
+            if (numSidechainChannels > 0 && firstSidechainChannel + numSidechainChannels <= block.getNumChannels())
+                detectorBlock = block.getSubsetChannelBlock(firstSidechainChannel, numSidechainChannels);
+        }
+        
+        dynamicPeak.analyse(detectorBlock, latestCoefficients.settings, hostInterval);
+    }
+    
+    // Once the input has been silent for longer than the filters' tail,
+    // they've nothing left to say, so leave the block as it is
+    if (canSkipSilentBlock(inputBlock, isSmoothing))
+    {
+        presetFadeSamplesRemaining = 0;
+        spectrumAnalyzer.pushOutput(inputBlock);
+        return;
+    }
+    
+    // From here to downsample the filters work on the oversampled block,
+    // which is just the input block when oversampling is off
+    auto processingBlock = upsample(inputBlock);
+    
+    // During a preset change, keep the input for the old preset's filters
+    auto presetFadeBlock = copyInputForPresetFade(processingBlock);
+    
+    if (! isSmoothing && ! isDynamic)
+    {
+        processFilters(processingBlock, latestCoefficients.settings);
+        reportElidedBiquads(blockTimer, latestCoefficients.settings);
+    }
+    else
+    {
+        // While smoothing, split the block up and redesign the coefficients
+        // for each piece. The peak band's dynamics change just the peak's
+        // design, once per piece, whether or not a ramp is running. A piece
+        // is a whole number of host samples, so it lines up with the
+        // detector's chunks.
+        const auto& chainSettings = isSmoothing ? smoothedCoefficients.settings : latestCoefficients.settings;
+        auto numSamples = processingBlock.getNumSamples();
+        auto interval = (size_t) (hostInterval * oversamplingFactor);
+        int chunk = 0;
+        
+        for (size_t start = 0; start < numSamples; start += interval, ++chunk)
+        {
+            auto length = juce::jmin(interval, numSamples - start);
+            
+            blockTimer.beginCoefficients();
+            
+            if (isSmoothing)
+            {
+                parameterSmoother.designAndAdvance((int) length, smoothedCoefficients);
+                applyCoefficients(smoothedCoefficients);
+            }
+            
+            if (isDynamic)
+                applyDynamicPeak(chainSettings, chunk);
+            
+            blockTimer.endCoefficients();
+            
+            processFilters(processingBlock.getSubBlock(start, length), chainSettings);
+        }
+        
+        if (isSmoothing)
+            usingSmoothedCoefficients = true;
+        
+        reportElidedBiquads(blockTimer, chainSettings);
+    }
+    
+    if (presetFadeBlock.getNumSamples() > 0)
+        finishPresetFade(processingBlock, presetFadeBlock);
+    
+    downsample(inputBlock);
+    spectrumAnalyzer.pushOutput(inputBlock);
+}
+
+void SimpleEQAudioProcessor::startPresetFade(int presetIndex)
+{
+    latestCoefficients = presetBank.getCoefficients(presetIndex);
+    parameterSmoother.reset(latestCoefficients.settings);
+    usingSmoothedCoefficients = false;
+    tailLengthSeconds = latestCoefficients.tailSamples / processingSampleRate;
+    
+    // The old preset's filters carry on in the slot they're in while they
+    // fade out. The new preset starts from clean state in the other one.
+    activeSlot = 1 - activeSlot;
+    resetSlot(getActiveSlot());
+    applyCoefficients(latestCoefficients);
+    
+    stageElider.reset(latestCoefficients.settings);
+    updateStageBypass();
+    
+    presetFadeSamplesRemaining = presetFadeLength;
+}
+
+template <typename SampleType>
+juce::dsp::AudioBlock<SampleType> SimpleEQAudioProcessor::copyInputForPresetFade(const juce::dsp::AudioBlock<SampleType>& inputBlock)
+{
+    if (presetFadeSamplesRemaining <= 0)
+        return {};
+    
+    auto& fadeBuffer = getPresetFadeBuffer(SampleType());
+    
+    // The buffer is sized in prepareToPlay, so this only fails if the host
+    // sends a bigger block than it promised
+    if (inputBlock.getNumChannels() > (size_t) fadeBuffer.getNumChannels()
+         || inputBlock.getNumSamples() > (size_t) fadeBuffer.getNumSamples())
+    {
+        jassertfalse;
+        presetFadeSamplesRemaining = 0;
+        return {};
+    }
+    
+    auto presetFadeBlock = juce::dsp::AudioBlock<SampleType>(fadeBuffer)
+                               .getSubsetChannelBlock(0, inputBlock.getNumChannels())
+                               .getSubBlock(0, inputBlock.getNumSamples());
+    
+    presetFadeBlock.copyFrom(inputBlock);
+    return presetFadeBlock;
+}
+
+template <typename SampleType>
+void SimpleEQAudioProcessor::finishPresetFade(const juce::dsp::AudioBlock<SampleType>& block, const juce::dsp::AudioBlock<SampleType>& presetFadeBlock)
+{
+    // Run the old preset on its copy of the input, in whichever mode it was
+    // running, then fade from it to the new preset's output. The elider
+    // only follows the new preset, so the old one runs its bands as they
+    // were left.
+    auto& oldSlot = filterSlots[(size_t) (1 - activeSlot)];
+    
+    if (oldSlot.processingMidSide)
+        oldSlot.getBandArray(SampleType()).processMidSide(oldSlot.getSideBandArray(SampleType()), presetFadeBlock);
+    else
+        processRunningStages(oldSlot, presetFadeBlock);
+    
+    auto numSamples = (int) block.getNumSamples();
+    auto gainPerSample = SampleType(1) / (SampleType) presetFadeLength;
+    auto startPosition = presetFadeLength - presetFadeSamplesRemaining;
+    
+    for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+    {
+        auto* newOutput = block.getChannelPointer(channel);
+        auto* oldOutput = presetFadeBlock.getChannelPointer(channel);
+        
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto gain = juce::jmin(SampleType(1), (SampleType) (startPosition + i + 1) * gainPerSample);
+            newOutput[i] = oldOutput[i] + gain * (newOutput[i] - oldOutput[i]);
+        }
+    }
+    
+    presetFadeSamplesRemaining = juce::jmax(0, presetFadeSamplesRemaining - numSamples);
+}
+
+// Input quieter than this counts as silence. It's the same level the tail
+// length is measured down to.
+static const float silenceThreshold = juce::Decibels::decibelsToGain((float) tailDecibels);
+
+template <typename SampleType>
+bool SimpleEQAudioProcessor::canSkipSilentBlock(const juce::dsp::AudioBlock<SampleType>& block, bool isSmoothing)
+{
+    // Counted at the rate the filters run at, which is what the tail is
+    // measured in
+    auto numSamples = (juce::int64) block.getNumSamples() * oversamplingFactor;
+    auto range = block.findMinAndMax();
+    auto isSilent = range.getStart() > -silenceThreshold && range.getEnd() < silenceThreshold;
+    
+    numSilentSamples = isSilent ? numSilentSamples + numSamples : 0;
+    
+    // Only skip once the silence before this block covers the whole tail.
+    // A ramp has to keep running so the smoother ends up in the right place.
+    auto shouldSleep = isSilent && ! isSmoothing
+                        && numSilentSamples - numSamples >= latestCoefficients.tailSamples;
+    
+    // Whatever the filters had left when they went to sleep was below the
+    // noise floor, so start them again from clean state
+    if (filtersAsleep && ! shouldSleep)
+    {
+        resetSlot(getActiveSlot());
+        
+        if (auto* resampler = getOversampler(SampleType()))
+            resampler->reset();
+    }
+    
+    filtersAsleep = shouldSleep;
+    return filtersAsleep;
+}
+
+void SimpleEQAudioProcessor::reportElidedBiquads(LoadMeter::ScopedBlock& blockTimer, const SimpleEQSettings& chainSettings) const noexcept
+{
+    int numBiquads = 0;
+    int numElided = stageElider.getNumElidedBiquads(chainSettings);
+    
+    for (int stage = 0; stage < NumChainStages; ++stage)
+        numBiquads += StageElider::getNumBiquads(static_cast<ChainStage>(stage), chainSettings);
+    
+    // Extra bands that are switched on but flat are skipped too. Ones that
+    // are off don't count either way.
+    for (const auto& band : chainSettings.extraBands)
+    {
+        if (band.enabled)
+        {
+            ++numBiquads;
+            
+            if (! BandArray::isActive(band))
+                ++numElided;
+        }
+    }
+    
+    blockTimer.setBiquadCounts(numElided, numBiquads);
+}
+
+template <typename SampleType>
+void SimpleEQAudioProcessor::processFilters(const juce::dsp::AudioBlock<SampleType>& block, const SimpleEQSettings& chainSettings)
+{
+    // Work out which bands are worth running with these settings. Any band
+    // that's coming back in starts from silence and fades in.
+    if (auto startedStages = stageElider.update(chainSettings))
+        resetStages(startedStages);
+    
+    updateStageBypass();
+    
+    if (getActiveSlot().processingMidSide)
+    {
+        processMidSide(getActiveSlot(), block);
+        return;
+    }
+    
+    if (! stageElider.isFading())
+    {
+        processRunningStages(getActiveSlot(), block);
+        return;
+    }
+    
+    // While a band is fading in or out, run the bands one at a time so the
+    // elider can crossfade each one against its own input
+    stageElider.processStages(block, [this](const juce::dsp::AudioBlock<SampleType>& stageBlock, ChainStage stage)
+    {
+        processStage(stageBlock, stage);
+    });
+    
+    processExtraBands(getActiveSlot(), block);
+}
+
+template <typename SampleType>
+void SimpleEQAudioProcessor::processMidSide(FilterSlot& slot, const juce::dsp::AudioBlock<SampleType>& block)
+{
+    auto& midBands = slot.getBandArray(SampleType());
+    auto& sideBands = slot.getSideBandArray(SampleType());
+    
+    // Normally the matrix is folded into the band arrays' loops, so this
+    // costs no more passes over the block than stereo does
+    if (! stageElider.isFading())
+    {
+        midBands.processMidSide(sideBands, block);
+        return;
+    }
+    
+    // The elider only looks after the mid channel's bands. While one of
+    // them fades, encode in place, crossfade the mid bands one at a time
+    // and decode again. The side channel's bands always run.
+    auto* left = block.getChannelPointer(0);
+    auto* right = block.getChannelPointer(1);
+    auto numSamples = block.getNumSamples();
+    
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        auto mid = (left[i] + right[i]) * SampleType(0.5);
+        right[i] = (left[i] - right[i]) * SampleType(0.5);
+        left[i] = mid;
+    }
+    
+    auto midBlock = block.getSingleChannelBlock(0);
+    
+    stageElider.processStages(midBlock, [&midBands](const juce::dsp::AudioBlock<SampleType>& stageBlock, ChainStage stage)
+    {
+        midBands.processBands(stageBlock, stage, stage + 1);
+    });
+    
+    midBands.processBands(midBlock, BandArray::getExtraBandIndex(0), BandArray::maxBands);
+    sideBands.process(block.getSingleChannelBlock(1));
+    
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        auto mid = left[i];
+        left[i] = mid + right[i];
+        right[i] = mid - right[i];
+    }
+}
+
+void SimpleEQAudioProcessor::processRunningStages(FilterSlot& slot, const juce::dsp::AudioBlock<float>& block)
+{
+    if (isUsingBandArray())
+    {
+        // Every band in one pass down the packed arrays
+        slot.bandArray.process(block);
+        return;
+    }
+    
+   #if JUCE_USE_SIMD
+    if (activeFilterEngine == FilterEngine::simd)
+    {
+        // Filter all the channels together
+        slot.simdEngine.process(block);
+        processExtraBands(slot, block);
+        return;
+    }
+   #endif
+    
+    if (activeFilterEngine == FilterEngine::cascade)
+    {
+        // The cuts and peak in a single pass over each channel
+        slot.cascadeEngine.process(block);
+        processExtraBands(slot, block);
+        return;
+    }
+
+    // Otherwise run each channel through its own chain. Bands that aren't
+    // running are bypassed in the chain.
+    auto numChannels = juce::jmin((int) block.getNumChannels(), slot.monoChains.size());
+    
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto channelBlock = block.getSingleChannelBlock((size_t) channel);
+        juce::dsp::ProcessContextReplacing<float> context(channelBlock);
+        slot.monoChains.getUnchecked(channel)->process(context);
+    }
+    
+    processExtraBands(slot, block);
+}
+
+void SimpleEQAudioProcessor::processRunningStages(FilterSlot& slot, const juce::dsp::AudioBlock<double>& block)
+{
+    slot.doubleBandArray.process(block);
+}
+
+void SimpleEQAudioProcessor::processExtraBands(FilterSlot& slot, const juce::dsp::AudioBlock<float>& block)
+{
+    // Costs nothing when none of them are active
+    slot.bandArray.processBands(block, BandArray::getExtraBandIndex(0), BandArray::maxBands);
+}
+
+void SimpleEQAudioProcessor::processExtraBands(FilterSlot& slot, const juce::dsp::AudioBlock<double>& block)
+{
+    slot.doubleBandArray.processBands(block, DoubleBandArray::getExtraBandIndex(0), DoubleBandArray::maxBands);
+}
+
+void SimpleEQAudioProcessor::processStage(const juce::dsp::AudioBlock<float>& block, ChainStage stage)
+{
+    auto& slot = getActiveSlot();
+    
+    if (isUsingBandArray())
+    {
+        slot.bandArray.processBands(block, stage, stage + 1);
+        return;
+    }
+    
+   #if JUCE_USE_SIMD
+    if (activeFilterEngine == FilterEngine::simd)
+    {
+        slot.simdEngine.processStage(block, stage);
+        return;
+    }
+   #endif
+    
+    if (activeFilterEngine == FilterEngine::cascade)
+    {
+        slot.cascadeEngine.processStage(block, stage);
+        return;
+    }
+    
+    auto numChannels = juce::jmin((int) block.getNumChannels(), slot.monoChains.size());
+    
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto channelBlock = block.getSingleChannelBlock((size_t) channel);
+        juce::dsp::ProcessContextReplacing<float> context(channelBlock);
+        auto& chain = *slot.monoChains.getUnchecked(channel);
+        
+        // Processing a band directly skips the chain's bypass flag for it
+        switch (stage)
+        {
+            case LowCutStage:   chain.get<ChainPositions::LowCut>().process(context); break;
+            case PeakStage:     chain.get<ChainPositions::Peak>().process(context); break;
+            case HighCutStage:  chain.get<ChainPositions::HighCut>().process(context); break;
+            case NumChainStages: break;
+        }
+    }
+}
+
+void SimpleEQAudioProcessor::processStage(const juce::dsp::AudioBlock<double>& block, ChainStage stage)
+{
+    getActiveSlot().doubleBandArray.processBands(block, stage, stage + 1);
+}
+
+void SimpleEQAudioProcessor::resetSlot(FilterSlot& slot)
+{
+    for (auto* chain : slot.monoChains)
+        chain->reset();
+    
+   #if JUCE_USE_SIMD
+    slot.simdEngine.reset();
+   #endif
+    
+    slot.cascadeEngine.reset();
+    slot.bandArray.reset();
+    slot.doubleBandArray.reset();
+    slot.sideBandArray.reset();
+    slot.doubleSideBandArray.reset();
+}
 
-    // Extract the right and left channels
-    juce::dsp::AudioBlock<float> block(buffer);
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
+void SimpleEQAudioProcessor::resetStages(int stages)
+{
+    auto& slot = getActiveSlot();
+    auto shouldReset = [stages](ChainStage stage) { return (stages & (1 << stage)) != 0; };
     
-    // Set up the contexts for each channel
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+    for (auto* chain : slot.monoChains)
+    {
+        if (shouldReset(LowCutStage))
+            chain->get<ChainPositions::LowCut>().reset();
+        
+        if (shouldReset(PeakStage))
+            chain->get<ChainPositions::Peak>().reset();
+        
+        if (shouldReset(HighCutStage))
+            chain->get<ChainPositions::HighCut>().reset();
+    }
     
-    // Process the audio
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
+   #if JUCE_USE_SIMD
+    for (int stage = 0; stage < NumChainStages; ++stage)
+        if (shouldReset(static_cast<ChainStage>(stage)))
+            slot.simdEngine.resetStage(static_cast<ChainStage>(stage));
+   #endif
+    
+    for (int stage = 0; stage < NumChainStages; ++stage)
+    {
+        if (shouldReset(static_cast<ChainStage>(stage)))
+        {
+            slot.cascadeEngine.resetStage(static_cast<ChainStage>(stage));
+            slot.bandArray.resetBand(stage);
+            slot.doubleBandArray.resetBand(stage);
+        }
+    }
+}
+
+void SimpleEQAudioProcessor::updateStageBypass()
+{
+    auto& slot = getActiveSlot();
+    
+    // Bypassed bands cost nothing in either engine
+    for (auto* chain : slot.monoChains)
+    {
+        chain->setBypassed<ChainPositions::LowCut>(! stageElider.isRunning(LowCutStage));
+        chain->setBypassed<ChainPositions::Peak>(! stageElider.isRunning(PeakStage));
+        chain->setBypassed<ChainPositions::HighCut>(! stageElider.isRunning(HighCutStage));
+    }
+    
+   #if JUCE_USE_SIMD
+    for (int stage = 0; stage < NumChainStages; ++stage)
+        slot.simdEngine.setStageRunning(static_cast<ChainStage>(stage), stageElider.isRunning(static_cast<ChainStage>(stage)));
+   #endif
+    
+    for (int stage = 0; stage < NumChainStages; ++stage)
+    {
+        auto isRunning = stageElider.isRunning(static_cast<ChainStage>(stage));
+        slot.cascadeEngine.setStageRunning(static_cast<ChainStage>(stage), isRunning);
+        slot.bandArray.setBandRunning(stage, isRunning);
+        slot.doubleBandArray.setBandRunning(stage, isRunning);
+    }
+}
+
+void SimpleEQAudioProcessor::setSlotsTopology(FilterTopology newTopology)
+{
+    // This clears the band arrays' state. Apply the coefficients again
+    // afterwards.
+    activeFilterTopology = newTopology;
+    
+    for (auto& slot : filterSlots)
+    {
+        slot.bandArray.setTopology(newTopology);
+        slot.doubleBandArray.setTopology(newTopology);
+        slot.sideBandArray.setTopology(newTopology);
+        slot.doubleSideBandArray.setTopology(newTopology);
+    }
 }
 
 //==============================================================================
@@ -252,39 +1279,133 @@ bool SimpleEQAudioProcessor::hasEditor() const
 
 juce::AudioProcessorEditor* SimpleEQAudioProcessor::createEditor()
 {
-//    return new SimpleEQAudioProcessorEditor (*this);
-    return new juce::GenericAudioProcessorEditor(*this);
+    return new SimpleEQAudioProcessorEditor (*this);
 }
 
 //==============================================================================
 void SimpleEQAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    // Saved in the compact binary format, see PluginState
+    PluginState::writeBinary(chainParameters.load(), loadProcessingSettings(), currentProgram, destData);
+}
+
+void SimpleEQAudioProcessor::getStateInformationAsXml(juce::MemoryBlock& destData)
+{
+    PluginState::writeXml(ap_tree_state, destData);
 }
 
 void SimpleEQAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    // Reads either format. The parameters all change together, so hold off
+    // designing until they're done.
+    const CoefficientEngine::ScopedBatch batch(coefficientEngine);
+    int program = currentProgram;
+    
+    if (PluginState::read(data, sizeInBytes, ap_tree_state, program))
+        currentProgram = juce::jlimit(0, presetBank.getNumPresets() - 1, program);
 }
 
 SimpleEQSettings getChainSettings(juce::AudioProcessorValueTreeState& ap_tree_state)
 {
-    SimpleEQSettings settings;
+    // Looks every parameter up by ID. Anything that reads the settings more
+    // than once should keep a ChainParameters instead.
+    return ChainParameters::Values(ap_tree_state).load();
+}
+
+void setChainSettings(juce::AudioProcessorValueTreeState& ap_tree_state, const SimpleEQSettings& settings)
+{
+    auto setParameter = [&ap_tree_state](const std::string& parameterID, float value)
+    {
+        if (auto* parameter = ap_tree_state.getParameter(parameterID))
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    };
     
-    settings.lowCutFreq = ap_tree_state.getRawParameterValue(LOW_CUT_FREQ)->load();
-    settings.lowCutSlope = static_cast<Slope>(ap_tree_state.getRawParameterValue(LOW_CUT_SLOPE)->load());
-    settings.highCutFreq = ap_tree_state.getRawParameterValue(HIGH_CUT_FREQ)->load();
-    settings.highCutSlope = static_cast<Slope>(ap_tree_state.getRawParameterValue(HIGH_CUT_SLOPE)->load());
-    settings.peakFreq = ap_tree_state.getRawParameterValue(PEAK_FREQ)->load();
-    settings.peakGain = ap_tree_state.getRawParameterValue(PEAK_GAIN)->load();
-    settings.peakQ = ap_tree_state.getRawParameterValue(PEAK_Q)->load();
+    setParameter(LOW_CUT_FREQ, settings.lowCutFreq);
+    setParameter(LOW_CUT_SLOPE, (float) settings.lowCutSlope);
+    setParameter(HIGH_CUT_FREQ, settings.highCutFreq);
+    setParameter(HIGH_CUT_SLOPE, (float) settings.highCutSlope);
+    setParameter(PEAK_FREQ, settings.peakFreq);
+    setParameter(PEAK_GAIN, settings.peakGain);
+    setParameter(PEAK_Q, settings.peakQ);
     
+    for (int index = 0; index < numExtraBands; ++index)
+    {
+        const auto& band = settings.extraBands[(size_t) index];
+        
+        setParameter(getExtraBandParameterID(index, BAND_ON), band.enabled ? 1.f : 0.f);
+        setParameter(getExtraBandParameterID(index, BAND_TYPE), (float) static_cast<int>(band.type));
+        setParameter(getExtraBandParameterID(index, BAND_FREQ), band.frequency);
+        setParameter(getExtraBandParameterID(index, BAND_GAIN), band.gain);
+        setParameter(getExtraBandParameterID(index, BAND_Q), band.Q);
+    }
+    
+    setParameter(MID_SIDE, settings.midSide ? 1.f : 0.f);
+    setParameter(SIDE_LOW_CUT_FREQ, settings.side.lowCutFreq);
+    setParameter(SIDE_LOW_CUT_SLOPE, (float) settings.side.lowCutSlope);
+    setParameter(SIDE_HIGH_CUT_FREQ, settings.side.highCutFreq);
+    setParameter(SIDE_HIGH_CUT_SLOPE, (float) settings.side.highCutSlope);
+    setParameter(SIDE_PEAK_FREQ, settings.side.peakFreq);
+    setParameter(SIDE_PEAK_GAIN, settings.side.peakGain);
+    setParameter(SIDE_PEAK_Q, settings.side.peakQ);
+    
+    setParameter(DYNAMIC_ON, settings.dynamic.enabled ? 1.f : 0.f);
+    setParameter(DYNAMIC_THRESHOLD, settings.dynamic.threshold);
+    setParameter(DYNAMIC_RATIO, settings.dynamic.ratio);
+    setParameter(DYNAMIC_ATTACK, settings.dynamic.attackMs);
+    setParameter(DYNAMIC_RELEASE, settings.dynamic.releaseMs);
+    setParameter(DYNAMIC_SIDECHAIN, settings.dynamic.useSidechain ? 1.f : 0.f);
+}
+
+ProcessingSettings getProcessingSettings(juce::AudioProcessorValueTreeState& ap_tree_state)
+{
+    auto getIndex = [&ap_tree_state](const std::string& parameterID)
+    {
+        auto* value = ap_tree_state.getRawParameterValue(parameterID);
+        return value != nullptr ? juce::roundToInt(value->load()) : 0;
+    };
+    
+    ProcessingSettings settings;
+    settings.filterTopology = getIndex(FILTER_TOPOLOGY) == 1 ? FilterTopology::stateVariable
+                                                             : FilterTopology::transposedDirectForm;
+    settings.oversamplingFactor = 1 << juce::jlimit(0, 2, getIndex(OVERSAMPLING));
+    settings.linearPhase = getIndex(LINEAR_PHASE) == 1;
+    settings.linearPhaseKernelSize = LinearPhaseEngine::getKernelSizeForChoice(getIndex(KERNEL_SIZE));
     return settings;
 }
 
+void setProcessingSettings(juce::AudioProcessorValueTreeState& ap_tree_state, const ProcessingSettings& settings)
+{
+    auto setParameter = [&ap_tree_state](const std::string& parameterID, float value)
+    {
+        if (auto* parameter = ap_tree_state.getParameter(parameterID))
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    };
+    
+    setParameter(FILTER_TOPOLOGY, (float) static_cast<int>(settings.filterTopology));
+    setParameter(OVERSAMPLING, settings.oversamplingFactor >= 4 ? 2.f : (settings.oversamplingFactor >= 2 ? 1.f : 0.f));
+    setParameter(KERNEL_SIZE, (float) LinearPhaseEngine::getChoiceForKernelSize(settings.linearPhaseKernelSize));
+    setParameter(LINEAR_PHASE, settings.linearPhase ? 1.f : 0.f);
+}
+
+// The processing options change how the filters run rather than what they
+// do, and some of them need prepareToPlay to run again, so hosts aren't
+// offered them for automation
+class ProcessingChoiceParameter  : public juce::AudioParameterChoice
+{
+public:
+    using juce::AudioParameterChoice::AudioParameterChoice;
+    
+    bool isAutomatable() const override { return false; }
+};
+
+class ProcessingBoolParameter  : public juce::AudioParameterBool
+{
+public:
+    using juce::AudioParameterBool::AudioParameterBool;
+    
+    bool isAutomatable() const override { return false; }
+};
+
 juce::AudioProcessorValueTreeState::ParameterLayout SimpleEQAudioProcessor::createParameterLayout()
 {
     juce::AudioProcessorValueTreeState::ParameterLayout layout;
@@ -337,6 +1458,138 @@ juce::AudioProcessorValueTreeState::ParameterLayout SimpleEQAudioProcessor::crea
                                                            juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 0.25),
                                                            1.f));
     
+    // Extra bands. They start off, spread out evenly across the spectrum so
+    // switching one on doesn't land it on top of another.
+    juce::StringArray band_types;
+    band_types.add("Peak");
+    band_types.add("Low Shelf");
+    band_types.add("High Shelf");
+    band_types.add("Notch");
+    
+    for (int index = 0; index < numExtraBands; ++index)
+    {
+        auto defaultFrequency = 20.f * std::pow(1000.f, (float) (index + 1) / (float) (numExtraBands + 1));
+        
+        layout.add(std::make_unique<juce::AudioParameterBool>(
+                                                              getExtraBandParameterID(index, BAND_ON),
+                                                              getExtraBandParameterLabel(index, BAND_ON_LABEL),
+                                                              false));
+        layout.add(std::make_unique<juce::AudioParameterChoice>(
+                                                                getExtraBandParameterID(index, BAND_TYPE),
+                                                                getExtraBandParameterLabel(index, BAND_TYPE_LABEL),
+                                                                band_types,
+                                                                0));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+                                                               getExtraBandParameterID(index, BAND_FREQ),
+                                                               getExtraBandParameterLabel(index, BAND_FREQ_LABEL),
+                                                               juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f),
+                                                               std::round(defaultFrequency)));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+                                                               getExtraBandParameterID(index, BAND_GAIN),
+                                                               getExtraBandParameterLabel(index, BAND_GAIN_LABEL),
+                                                               juce::NormalisableRange<float>(-24.f, 24.f, 0.1f, 0.25),
+                                                               0.f));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+                                                               getExtraBandParameterID(index, BAND_Q),
+                                                               getExtraBandParameterLabel(index, BAND_Q_LABEL),
+                                                               juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 0.25),
+                                                               1.f));
+    }
+    
+    // Mid/Side mode, and the side channel's bands. They have the same ranges
+    // and defaults as the main ones, which become the mid channel's.
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+                                                          MID_SIDE,
+                                                          MID_SIDE_LABEL,
+                                                          false));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+                                                           SIDE_LOW_CUT_FREQ,
+                                                           SIDE_LOW_CUT_FREQ_LABEL,
+                                                           juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 1.f),
+                                                           20.f));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+                                                            SIDE_LOW_CUT_SLOPE,
+                                                            SIDE_LOW_CUT_SLOPE_LABEL,
+                                                            cut_slopes,
+                                                            0));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+                                                           SIDE_HIGH_CUT_FREQ,
+                                                           SIDE_HIGH_CUT_FREQ_LABEL,
+                                                           juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 1.f),
+                                                           20000.f));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+                                                            SIDE_HIGH_CUT_SLOPE,
+                                                            SIDE_HIGH_CUT_SLOPE_LABEL,
+                                                            cut_slopes,
+                                                            0));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+                                                           SIDE_PEAK_FREQ,
+                                                           SIDE_PEAK_FREQ_LABEL,
+                                                           juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.5f),
+                                                           750.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+                                                           SIDE_PEAK_GAIN,
+                                                           SIDE_PEAK_GAIN_LABEL,
+                                                           juce::NormalisableRange<float>(-24.f, 24.f, 0.1f, 0.25),
+                                                           0.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+                                                           SIDE_PEAK_Q,
+                                                           SIDE_PEAK_Q_LABEL,
+                                                           juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 0.25),
+                                                           1.f));
+    
+    // The peak band's dynamics. Off by default, which leaves the peak as a
+    // static band.
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+                                                          DYNAMIC_ON,
+                                                          DYNAMIC_ON_LABEL,
+                                                          false));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+                                                           DYNAMIC_THRESHOLD,
+                                                           DYNAMIC_THRESHOLD_LABEL,
+                                                           juce::NormalisableRange<float>(-60.f, 0.f, 0.1f, 1.f),
+                                                           -20.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+                                                           DYNAMIC_RATIO,
+                                                           DYNAMIC_RATIO_LABEL,
+                                                           juce::NormalisableRange<float>(1.f, 20.f, 0.1f, 0.5f),
+                                                           2.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+                                                           DYNAMIC_ATTACK,
+                                                           DYNAMIC_ATTACK_LABEL,
+                                                           juce::NormalisableRange<float>(0.1f, 200.f, 0.1f, 0.3f),
+                                                           10.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+                                                           DYNAMIC_RELEASE,
+                                                           DYNAMIC_RELEASE_LABEL,
+                                                           juce::NormalisableRange<float>(5.f, 2000.f, 1.f, 0.3f),
+                                                           100.f));
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+                                                          DYNAMIC_SIDECHAIN,
+                                                          DYNAMIC_SIDECHAIN_LABEL,
+                                                          false));
+    
+    // Processing options
+    layout.add(std::make_unique<ProcessingChoiceParameter>(
+                                                           FILTER_TOPOLOGY,
+                                                           FILTER_TOPOLOGY_LABEL,
+                                                           juce::StringArray { "Direct Form", "State Variable" },
+                                                           0));
+    layout.add(std::make_unique<ProcessingChoiceParameter>(
+                                                           OVERSAMPLING,
+                                                           OVERSAMPLING_LABEL,
+                                                           juce::StringArray { "Off", "2x", "4x" },
+                                                           0));
+    layout.add(std::make_unique<ProcessingBoolParameter>(
+                                                         LINEAR_PHASE,
+                                                         LINEAR_PHASE_LABEL,
+                                                         false));
+    layout.add(std::make_unique<ProcessingChoiceParameter>(
+                                                           KERNEL_SIZE,
+                                                           KERNEL_SIZE_LABEL,
+                                                           LinearPhaseEngine::getKernelSizeChoices(),
+                                                           LinearPhaseEngine::getChoiceForKernelSize(LinearPhaseEngine::defaultKernelSize)));
+    
     return layout;
 }
 
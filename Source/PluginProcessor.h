@@ -9,54 +9,20 @@
 #pragma once
 
 #include <JuceHeader.h>
-
-enum Slope
-{
-    Slope_12,
-    Slope_24,
-    Slope_36,
-    Slope_48
-};
-
-struct SimpleEQSettings
-{
-    // Low cut settings
-    float lowCutFreq { 0 };
-    Slope lowCutSlope { Slope_12 };
-    
-    // Peak band settings
-    float peakFreq { 0 };
-    float peakGain { 0 };
-    float peakQ { 1.f };
-    
-    // High cut settings
-    float highCutFreq { 0 };
-    Slope highCutSlope { Slope_12 };
-};
-
-SimpleEQSettings getChainSettings(juce::AudioProcessorValueTreeState& ap_tree_state);
-
-// Parameter ID's
-const std::string LOW_CUT_FREQ = "LOW_CUT_FREQ";
-const std::string LOW_CUT_SLOPE = "LOW_CUT_SLOPE";
-
-const std::string PEAK_FREQ = "PEAK_FREQ";
-const std::string PEAK_GAIN = "PEAK_GAIN";
-const std::string PEAK_Q = "PEAK_Q";
-
-const std::string HIGH_CUT_FREQ = "HIGH_CUT_FREQ";
-const std::string HIGH_CUT_SLOPE = "HIGH_CUT_SLOPE";
-
-//Parameter Labels
-const std::string LOW_CUT_FREQ_LABEL = "Low Cut Frequency";
-const std::string LOW_CUT_SLOPE_LABEL = "Low Cut Slope";
-
-const std::string PEAK_FREQ_LABEL = "Peak Frequency";
-const std::string PEAK_GAIN_LABEL = "Peak Gain";
-const std::string PEAK_Q_LABEL = "Peak Q";
-
-const std::string HIGH_CUT_FREQ_LABEL = "High Cut Frequency";
-const std::string HIGH_CUT_SLOPE_LABEL = "High Cut Slope";
+#include "SimpleEQSettings.h"
+#include "CoefficientEngine.h"
+#include "SimdBiquadEngine.h"
+#include "CascadeEngine.h"
+#include "BandArray.h"
+#include "ParameterSmoother.h"
+#include "LoadMeter.h"
+#include "StageElider.h"
+#include "PresetBank.h"
+#include "SpectrumAnalyzer.h"
+#include "ResponseCurve.h"
+#include "LinearPhaseEngine.h"
+#include "DynamicPeak.h"
+#include "MatchEq.h"
 
 //==============================================================================
 /**
@@ -65,6 +31,8 @@ class SimpleEQAudioProcessor  : public juce::AudioProcessor
                             #if JucePlugin_Enable_ARA
                              , public juce::AudioProcessorARAExtension
                             #endif
+                             , private juce::AudioProcessorValueTreeState::Listener
+                             , private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -83,6 +51,11 @@ public:
     // Called by host with blocks of audio to be processed
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
     
+    // The double version runs every band through a DoubleBandArray, with the
+    // coefficients designed in double too. The float path is untouched.
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
+    
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -107,9 +80,120 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
     
+    // The XML format that setStateInformation also reads. getStateInformation
+    // saves the smaller and faster binary format.
+    void getStateInformationAsXml(juce::MemoryBlock& destData);
+    
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     
     juce::AudioProcessorValueTreeState ap_tree_state {*this, nullptr, "Parameters", createParameterLayout()};
+    
+    // Hit rate and memory footprint of the cut filter cache. The cache is
+    // shared by every instance in the process, so so are these numbers.
+    CoefficientCache::Statistics getCoefficientCacheStatistics() const { return coefficientEngine.getCacheStatistics(); }
+    
+    // Lazy by default. With precompute, the cut filter table for each rate
+    // this instance runs at is designed in full in the background, which
+    // suits offline renders that go through lots of cut settings. Takes
+    // effect at the next prepareToPlay.
+    void setCoefficientCacheFillMode(CoefficientCache::FillMode newMode) noexcept { cacheFillMode = newMode; }
+    CoefficientCache::FillMode getCoefficientCacheFillMode() const noexcept { return cacheFillMode; }
+    
+    // The ways processBlock can run the filters. They produce the same
+    // output; the SIMD engine filters the channels together in SIMD lanes
+    // instead of running a MonoChain per channel, so its cost grows with the
+    // number of lane groups rather than the number of channels. The band
+    // array runs every band, the cuts and peak included, from flat arrays
+    // with the inactive bands packed out. The cascade engine runs the cuts
+    // and peak in one pass over each channel rather than one per biquad,
+    // which pays off on large blocks. Whichever engine runs the cuts and
+    // peak, the extra bands always go through the band array. Safe to call
+    // while playing.
+    //
+    // This is a switch for development and benchmarking, for the renderer's
+    // --engine option and the benchmark's engine comparisons. As they all
+    // sound the same it isn't a parameter: it isn't saved with the state or
+    // shown in the editor, and every instance starts on the default.
+    enum class FilterEngine
+    {
+        monoChains,
+        simd,
+        bandArray,
+        cascade
+    };
+    
+    void setFilterEngine(FilterEngine newEngine) noexcept;
+    FilterEngine getFilterEngine() const noexcept { return filterEngine; }
+    
+    // How the bands' second order sections are built, see FilterTopology.
+    // Only the band array has the state variable filter, so while it's
+    // selected the float path runs the band array whichever engine is
+    // picked. Switching clears the filter state. Safe to call while playing.
+    // This sets the FILTER_TOPOLOGY parameter, so it's saved with the state.
+    void setFilterTopology(FilterTopology newTopology);
+    FilterTopology getFilterTopology() const noexcept;
+    
+    // Runs the filters at 2x or 4x the host's sample rate (1 turns it off),
+    // with the coefficients designed at that rate, so the high cut and peak
+    // keep their analog shapes near the top of the audio band instead of
+    // being squeezed by the bilinear transform. Costs CPU and adds the
+    // resampling filters' latency, which is reported to the host. This sets
+    // the OVERSAMPLING parameter, so it's saved with the state. A prepared
+    // processor is prepared again on the message thread to pick it up;
+    // otherwise it takes effect at the next prepareToPlay.
+    void setOversamplingFactor(int newFactor);
+    int getOversamplingFactor() const noexcept;
+    
+    // Replaces the filters with one long FIR with the same magnitude
+    // response and no phase shift at all, for mastering. It delays the
+    // signal by half the kernel, which is reported to the host, and costs
+    // more CPU. Longer kernels resolve the low end better. The kernel is
+    // redesigned in the background when a parameter changes and crossfaded
+    // in. In stereo, Mid/Side runs as separate mid and side kernels.
+    // Oversampling and the peak band's dynamics aren't used in this mode.
+    // This sets the LINEAR_PHASE and KERNEL_SIZE parameters, which are
+    // saved with the state, and is applied the same way as oversampling.
+    void setLinearPhase(bool shouldBeLinear, int kernelSize = LinearPhaseEngine::defaultKernelSize);
+    bool isLinearPhase() const noexcept;
+    int getLinearPhaseKernelSize() const noexcept;
+    
+    // When smoothing is on, parameter changes ramp over a short time instead
+    // of jumping, and the coefficients are redesigned every
+    // updateIntervalSamples (clamped to 8-64) while a ramp is running. The
+    // peak band's dynamics update the peak at the same interval.
+    void setParameterSmoothing(bool shouldSmooth, int updateIntervalSamples = 32) noexcept;
+    bool isParameterSmoothingEnabled() const noexcept { return smoothingEnabled; }
+    
+    // When elision is on, bands that are parked where they can't be heard
+    // (the static peak at 0 dB, see StageElider) aren't processed at all,
+    // and fade back in when they're moved. On by default; turning
+    // it off is mostly useful for measuring what it saves.
+    void setStageElision(bool shouldElide) noexcept;
+    
+    // Designs the coefficients for any parameter changes now, on the
+    // calling thread, so the next processBlock is sure to pick them up.
+    // Normally the design thread does this within a few milliseconds. For
+    // benchmarks and tests, not the audio thread.
+    void publishParameterChanges() { coefficientEngine.publishChanges(); }
+    bool isStageElisionEnabled() const noexcept { return stageElisionEnabled; }
+    
+    // How much of the audio callback's budget this instance is using. Can
+    // be read from any thread while audio is running.
+    LoadMeter& getLoadMeter() noexcept { return loadMeter; }
+    LoadMeter::Snapshot getLoadSnapshot() const { return loadMeter.getSnapshot(); }
+    
+    // Spectra of the input and output. Only runs while something has
+    // switched it on, which the editor does while it's open.
+    SpectrumAnalyzer& getSpectrumAnalyzer() noexcept { return spectrumAnalyzer; }
+    
+    // The EQ's magnitude response for the current parameters, brought up to
+    // date first. Only the bands that changed since the last call are
+    // recomputed. Message thread only.
+    const ResponseCurve& getResponseCurve();
+    
+    // Fits the bands to the difference between a reference file and a
+    // track, in the background, and writes the fit into the parameters
+    MatchEq& getMatchEq() noexcept { return matchEq; }
 
 private:
     
@@ -135,12 +219,193 @@ private:
         HighCut,
     };
     
-    // Processing chains for both of the stereo channels (left and right)
-    MonoChain leftChain, rightChain;
+    // Everything that holds filter state: one processing chain per channel
+    // for the MonoChain engine, sized to the channel layout in prepareToPlay,
+    // the SIMD engine, the cascade engine and the band array, plus the double band array that
+    // does all the double precision processing. In Mid/Side mode the band
+    // array runs the mid channel and the side band array the side channel,
+    // whichever engine is picked. There are two slots so a preset change
+    // can run the old preset alongside the new one while they crossfade,
+    // each in the mode it was set up for.
+    struct FilterSlot
+    {
+        juce::OwnedArray<MonoChain> monoChains;
+       #if JUCE_USE_SIMD
+        SimdBiquadEngine simdEngine;
+       #endif
+        CascadeEngine cascadeEngine;
+        BandArray bandArray;
+        DoubleBandArray doubleBandArray;
+        BandArray sideBandArray;
+        DoubleBandArray doubleSideBandArray;
+        
+        // Whether this slot's filters are running in Mid/Side, which needs
+        // the parameter on and a stereo layout
+        bool processingMidSide = false;
+        
+        BandArray& getBandArray(float) noexcept               { return bandArray; }
+        DoubleBandArray& getBandArray(double) noexcept        { return doubleBandArray; }
+        BandArray& getSideBandArray(float) noexcept           { return sideBandArray; }
+        DoubleBandArray& getSideBandArray(double) noexcept    { return doubleSideBandArray; }
+    };
+    
+    std::array<FilterSlot, 2> filterSlots;
+    int activeSlot = 0;
+    
+    FilterSlot& getActiveSlot() noexcept { return filterSlots[(size_t) activeSlot]; }
+    
+    // Every parameter's value, looked up once, and a version for each group
+    // of them that goes up when one changes
+    ChainParameters chainParameters { ap_tree_state };
+    
+    // Designs the coefficients on a background thread whenever a parameter
+    // changes. The audio thread only ever copies finished sets out of it.
+    CoefficientEngine coefficientEngine { chainParameters };
+    
+    // The newest set from the coefficient engine, kept so we can go back
+    // to it once a smoothing ramp has finished
+    ChainCoefficients latestCoefficients;
+    
+    // Ramps the settings on the audio thread and designs the in-between
+    // coefficients into smoothedCoefficients
+    ParameterSmoother parameterSmoother;
+    ChainCoefficients smoothedCoefficients;
+    bool usingSmoothedCoefficients = false;
+    
+    std::atomic<bool> smoothingEnabled { true };
+    std::atomic<int> smoothingInterval { 32 };
+    
+    LoadMeter loadMeter;
+    SpectrumAnalyzer spectrumAnalyzer;
+    
+    // Only touched on the message thread, by getResponseCurve
+    ResponseCurve responseCurve;
+    
+    // The resamplers around the filters when oversampling, one for each
+    // precision. Only the one for the precision in use is created.
+    int oversamplingFactor = 1;
+    std::unique_ptr<juce::dsp::Oversampling<float>> oversampler;
+    std::unique_ptr<juce::dsp::Oversampling<double>> doubleOversampler;
+    
+    juce::dsp::Oversampling<float>* getOversampler(float) noexcept     { return oversampler.get(); }
+    juce::dsp::Oversampling<double>* getOversampler(double) noexcept   { return doubleOversampler.get(); }
+    
+    // The rate the filters run at, which is the host's rate times the
+    // oversampling factor
+    std::atomic<double> processingSampleRate { 0.0 };
+    
+    // The peak band's dynamics. The detector runs on each block before it's
+    // filtered, and the peak gets a new design every smoothing interval.
+    DynamicPeak dynamicPeak;
+    
+    // Runs instead of the filters in linear phase mode
+    LinearPhaseEngine linearPhaseEngine { chainParameters };
+    std::atomic<float>* linearPhaseSwitch = ap_tree_state.getRawParameterValue(LINEAR_PHASE);
+    std::atomic<float>* kernelSizeChoice = ap_tree_state.getRawParameterValue(KERNEL_SIZE);
+    std::atomic<bool> linearPhase { false };
+    
+    // Only ever works on files, never on the audio thread
+    MatchEq matchEq { ap_tree_state };
+    
+    // The current designs' tail, for the host
+    std::atomic<double> tailLengthSeconds { 0.0 };
+    
+    // How long the input has been silent for, and whether that's been long
+    // enough for the filters to stop
+    juce::int64 numSilentSamples = 0;
+    bool filtersAsleep = false;
+    
+    // Decides which bands to skip and fades them in and out
+    StageElider stageElider;
+    std::atomic<bool> stageElisionEnabled { true };
+    
+    std::atomic<CoefficientCache::FillMode> cacheFillMode { CoefficientCache::FillMode::lazy };
+    
+    // The factory presets. pendingPreset is set by setCurrentProgram and
+    // picked up by the audio thread, which then fades from the old preset
+    // to the new one over presetFadeLength samples.
+    PresetBank presetBank;
+    std::atomic<int> currentProgram { 0 };
+    std::atomic<int> pendingPreset { -1 };
+    int presetFadeLength = 1;
+    int presetFadeSamplesRemaining = 0;
+    juce::AudioBuffer<float> presetFadeBuffer;
+    juce::AudioBuffer<double> doublePresetFadeBuffer;
+    
+    juce::AudioBuffer<float>& getPresetFadeBuffer(float) noexcept     { return presetFadeBuffer; }
+    juce::AudioBuffer<double>& getPresetFadeBuffer(double) noexcept   { return doublePresetFadeBuffer; }
+    
+    // Set in prepareToPlay from the precision the host asked for
+    bool usingDoublePrecision = false;
+    
+   #if JUCE_USE_SIMD
+    std::atomic<FilterEngine> filterEngine { FilterEngine::simd };
+    FilterEngine activeFilterEngine { FilterEngine::simd };
+   #else
+    std::atomic<FilterEngine> filterEngine { FilterEngine::monoChains };
+    FilterEngine activeFilterEngine { FilterEngine::monoChains };
+   #endif
+    
+    // The processing options' parameters, looked up once. Each holds the
+    // choice's index.
+    std::atomic<float>* filterTopology = ap_tree_state.getRawParameterValue(FILTER_TOPOLOGY);
+    FilterTopology activeFilterTopology { FilterTopology::transposedDirectForm };
+    std::atomic<float>* oversamplingChoice = ap_tree_state.getRawParameterValue(OVERSAMPLING);
+    
+    // The processing options that only prepareToPlay can apply. When one
+    // changes on a prepared processor, it's prepared again from
+    // handleAsyncUpdate, with processing suspended, so the host gets the
+    // new latency the usual way.
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+    void handleAsyncUpdate() override;
+    bool needsPrepareForProcessingOptions() const noexcept;
+    
+    // Set by prepareToPlay and cleared by releaseResources
+    std::atomic<bool> isPrepared { false };
+    
+    // The processing options from the parameters above, for saving
+    ProcessingSettings loadProcessingSettings() const noexcept;
+    
+    // Whether the float path runs the cuts and peak in the band array
+    bool isUsingBandArray() const noexcept
+    {
+        return activeFilterEngine == FilterEngine::bandArray || activeFilterTopology == FilterTopology::stateVariable;
+    }
     
     // Helper methods
-    void applyCoefficients(double sampleRate);
-    void applyCutFilter(CutFilter& cutFilter, juce::ReferenceCountedArray<juce::dsp::FilterDesign<float>::IIRCoefficients> coefficients, Slope slope);
+    void prepareChain(MonoChain& chain, const juce::dsp::ProcessSpec& spec);
+    void applyCoefficients(const ChainCoefficients& chainCoefficients);
+    void applyDynamicPeak(const SimpleEQSettings& chainSettings, int chunk);
+    void applyCutFilter(CutFilter& cutFilter, const std::array<BiquadCoefficients, 4>& coefficients, Slope slope);
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer);
+    template <typename SampleType>
+    void processFilters(const juce::dsp::AudioBlock<SampleType>& block, const SimpleEQSettings& chainSettings);
+    void processRunningStages(FilterSlot& slot, const juce::dsp::AudioBlock<float>& block);
+    void processRunningStages(FilterSlot& slot, const juce::dsp::AudioBlock<double>& block);
+    void processStage(const juce::dsp::AudioBlock<float>& block, ChainStage stage);
+    void processStage(const juce::dsp::AudioBlock<double>& block, ChainStage stage);
+    void processExtraBands(FilterSlot& slot, const juce::dsp::AudioBlock<float>& block);
+    void processExtraBands(FilterSlot& slot, const juce::dsp::AudioBlock<double>& block);
+    template <typename SampleType>
+    void processMidSide(FilterSlot& slot, const juce::dsp::AudioBlock<SampleType>& block);
+    void resetSlot(FilterSlot& slot);
+    void resetStages(int stages);
+    void updateStageBypass();
+    void setSlotsTopology(FilterTopology newTopology);
+    void startPresetFade(int presetIndex);
+    void prepareOversampler(int numChannels, int samplesPerBlock);
+    template <typename SampleType>
+    juce::dsp::AudioBlock<SampleType> upsample(const juce::dsp::AudioBlock<SampleType>& block);
+    template <typename SampleType>
+    void downsample(juce::dsp::AudioBlock<SampleType>& block);
+    template <typename SampleType>
+    juce::dsp::AudioBlock<SampleType> copyInputForPresetFade(const juce::dsp::AudioBlock<SampleType>& inputBlock);
+    template <typename SampleType>
+    void finishPresetFade(const juce::dsp::AudioBlock<SampleType>& block, const juce::dsp::AudioBlock<SampleType>& presetFadeBlock);
+    template <typename SampleType>
+    bool canSkipSilentBlock(const juce::dsp::AudioBlock<SampleType>& block, bool isSmoothing);
+    void reportElidedBiquads(LoadMeter::ScopedBlock& blockTimer, const SimpleEQSettings& chainSettings) const noexcept;
     
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SimpleEQAudioProcessor)
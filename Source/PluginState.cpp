@@ -0,0 +1,225 @@
+/*
+  ==============================================================================
+
+    This file contains the formats the plugin saves its state in: a compact
+    versioned binary one, and the parameters' ValueTree as XML to fall back
+    on.
+
+  ==============================================================================
+*/
+
+#include "PluginState.h"
+
+namespace
+{
+    // "SEQS" when read as little-endian bytes
+    constexpr int magicNumber = 0x53514553;
+    constexpr int headerSize = 4 * (int) sizeof(juce::int32);
+    constexpr int numValuesPerBand = 5;
+    constexpr int firstSideValue = 7 + numExtraBands * numValuesPerBand;
+    constexpr int firstDynamicValue = firstSideValue + 8;
+    constexpr int firstProcessingValue = firstDynamicValue + 6;
+    constexpr int numValues = firstProcessingValue + 4;
+
+    using Values = std::array<float, numValues>;
+
+    // The settings in the order they're stored
+    void getValues(const SimpleEQSettings& settings, const ProcessingSettings& processingSettings, Values& values)
+    {
+        values[0] = settings.lowCutFreq;
+        values[1] = (float) settings.lowCutSlope;
+        values[2] = settings.peakFreq;
+        values[3] = settings.peakGain;
+        values[4] = settings.peakQ;
+        values[5] = settings.highCutFreq;
+        values[6] = (float) settings.highCutSlope;
+
+        for (size_t band = 0; band < (size_t) numExtraBands; ++band)
+        {
+            const auto& bandSettings = settings.extraBands[band];
+            auto* bandValues = values.data() + 7 + band * numValuesPerBand;
+
+            bandValues[0] = bandSettings.enabled ? 1.f : 0.f;
+            bandValues[1] = (float) static_cast<int>(bandSettings.type);
+            bandValues[2] = bandSettings.frequency;
+            bandValues[3] = bandSettings.gain;
+            bandValues[4] = bandSettings.Q;
+        }
+
+        auto* sideValues = values.data() + firstSideValue;
+
+        sideValues[0] = settings.midSide ? 1.f : 0.f;
+        sideValues[1] = settings.side.lowCutFreq;
+        sideValues[2] = (float) settings.side.lowCutSlope;
+        sideValues[3] = settings.side.peakFreq;
+        sideValues[4] = settings.side.peakGain;
+        sideValues[5] = settings.side.peakQ;
+        sideValues[6] = settings.side.highCutFreq;
+        sideValues[7] = (float) settings.side.highCutSlope;
+
+        auto* dynamicValues = values.data() + firstDynamicValue;
+
+        dynamicValues[0] = settings.dynamic.enabled ? 1.f : 0.f;
+        dynamicValues[1] = settings.dynamic.threshold;
+        dynamicValues[2] = settings.dynamic.ratio;
+        dynamicValues[3] = settings.dynamic.attackMs;
+        dynamicValues[4] = settings.dynamic.releaseMs;
+        dynamicValues[5] = settings.dynamic.useSidechain ? 1.f : 0.f;
+
+        auto* processingValues = values.data() + firstProcessingValue;
+
+        processingValues[0] = (float) static_cast<int>(processingSettings.filterTopology);
+        processingValues[1] = (float) processingSettings.oversamplingFactor;
+        processingValues[2] = processingSettings.linearPhase ? 1.f : 0.f;
+        processingValues[3] = (float) processingSettings.linearPhaseKernelSize;
+    }
+
+    Slope toSlope(float value)
+    {
+        return static_cast<Slope>(juce::jlimit((int) Slope_12, (int) Slope_48, juce::roundToInt(value)));
+    }
+
+    void setValues(const Values& values, SimpleEQSettings& settings, ProcessingSettings& processingSettings)
+    {
+        settings.lowCutFreq = values[0];
+        settings.lowCutSlope = toSlope(values[1]);
+        settings.peakFreq = values[2];
+        settings.peakGain = values[3];
+        settings.peakQ = values[4];
+        settings.highCutFreq = values[5];
+        settings.highCutSlope = toSlope(values[6]);
+
+        for (size_t band = 0; band < (size_t) numExtraBands; ++band)
+        {
+            auto& bandSettings = settings.extraBands[band];
+            const auto* bandValues = values.data() + 7 + band * numValuesPerBand;
+
+            bandSettings.enabled = bandValues[0] > 0.5f;
+            bandSettings.type = static_cast<BandType>(juce::jlimit((int) BandType::peak, (int) BandType::notch, juce::roundToInt(bandValues[1])));
+            bandSettings.frequency = bandValues[2];
+            bandSettings.gain = bandValues[3];
+            bandSettings.Q = bandValues[4];
+        }
+
+        const auto* sideValues = values.data() + firstSideValue;
+
+        settings.midSide = sideValues[0] > 0.5f;
+        settings.side.lowCutFreq = sideValues[1];
+        settings.side.lowCutSlope = toSlope(sideValues[2]);
+        settings.side.peakFreq = sideValues[3];
+        settings.side.peakGain = sideValues[4];
+        settings.side.peakQ = sideValues[5];
+        settings.side.highCutFreq = sideValues[6];
+        settings.side.highCutSlope = toSlope(sideValues[7]);
+
+        const auto* dynamicValues = values.data() + firstDynamicValue;
+
+        settings.dynamic.enabled = dynamicValues[0] > 0.5f;
+        settings.dynamic.threshold = dynamicValues[1];
+        settings.dynamic.ratio = dynamicValues[2];
+        settings.dynamic.attackMs = dynamicValues[3];
+        settings.dynamic.releaseMs = dynamicValues[4];
+        settings.dynamic.useSidechain = dynamicValues[5] > 0.5f;
+
+        const auto* processingValues = values.data() + firstProcessingValue;
+
+        processingSettings.filterTopology = processingValues[0] > 0.5f ? FilterTopology::stateVariable
+                                                                       : FilterTopology::transposedDirectForm;
+        processingSettings.oversamplingFactor = processingValues[1] > 3.f ? 4 : (processingValues[1] > 1.5f ? 2 : 1);
+        processingSettings.linearPhase = processingValues[2] > 0.5f;
+        processingSettings.linearPhaseKernelSize = juce::roundToInt(processingValues[3]);
+    }
+
+    bool readBinary(const void* data, int sizeInBytes, juce::AudioProcessorValueTreeState& ap_tree_state, int& program)
+    {
+        if (sizeInBytes < headerSize)
+            return false;
+
+        juce::MemoryInputStream input(data, (size_t) sizeInBytes, false);
+
+        if (input.readInt() != magicNumber)
+            return false;
+
+        auto version = input.readInt();
+        auto storedProgram = input.readInt();
+        auto numStoredValues = input.readInt();
+
+        if (version < 1 || numStoredValues < 0 || numStoredValues > (sizeInBytes - headerSize) / (int) sizeof(float))
+            return false;
+
+        // Anything missing from an older state keeps its current value
+        auto settings = getChainSettings(ap_tree_state);
+        auto processingSettings = getProcessingSettings(ap_tree_state);
+
+        Values values;
+        getValues(settings, processingSettings, values);
+
+        for (int i = 0; i < juce::jmin(numStoredValues, numValues); ++i)
+            values[(size_t) i] = input.readFloat();
+
+        setValues(values, settings, processingSettings);
+        setChainSettings(ap_tree_state, settings);
+        setProcessingSettings(ap_tree_state, processingSettings);
+        program = storedProgram;
+        return true;
+    }
+
+    std::unique_ptr<juce::XmlElement> readXml(const void* data, int sizeInBytes)
+    {
+        if (auto xml = juce::AudioProcessor::getXmlFromBinary(data, sizeInBytes))
+            return xml;
+
+        // A state saved out as a text file
+        auto text = juce::String::fromUTF8(static_cast<const char*>(data), sizeInBytes);
+
+        if (text.trimStart().startsWithChar('<'))
+            return juce::parseXML(text);
+
+        return {};
+    }
+}
+
+namespace PluginState
+{
+    void writeBinary(const SimpleEQSettings& settings, const ProcessingSettings& processingSettings,
+                     int program, juce::MemoryBlock& destData)
+    {
+        destData.setSize((size_t) (headerSize + numValues * (int) sizeof(float)));
+
+        juce::MemoryOutputStream output(destData, false);
+
+        output.writeInt(magicNumber);
+        output.writeInt(currentVersion);
+        output.writeInt(program);
+        output.writeInt(numValues);
+
+        Values values;
+        getValues(settings, processingSettings, values);
+
+        for (auto value : values)
+            output.writeFloat(value);
+    }
+
+    void writeXml(juce::AudioProcessorValueTreeState& ap_tree_state, juce::MemoryBlock& destData)
+    {
+        if (auto xml = ap_tree_state.copyState().createXml())
+            juce::AudioProcessor::copyXmlToBinary(*xml, destData);
+    }
+
+    bool read(const void* data, int sizeInBytes, juce::AudioProcessorValueTreeState& ap_tree_state, int& program)
+    {
+        if (data == nullptr || sizeInBytes <= 0)
+            return false;
+
+        if (readBinary(data, sizeInBytes, ap_tree_state, program))
+            return true;
+
+        auto xml = readXml(data, sizeInBytes);
+
+        if (xml == nullptr || ! xml->hasTagName(ap_tree_state.state.getType()))
+            return false;
+
+        ap_tree_state.replaceState(juce::ValueTree::fromXml(*xml));
+        return true;
+    }
+}
@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    This file contains the formats the plugin saves its state in: a compact
+    versioned binary one, and the parameters' ValueTree as XML to fall back
+    on.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SimpleEQSettings.h"
+
+//==============================================================================
+/**
+    The binary format is a 16 byte header followed by the parameter values,
+    all little-endian:
+
+      int32  magic number ('SEQS')
+      int32  format version
+      int32  selected program
+      int32  number of values that follow
+      float  values, in the order of SimpleEQSettings, then
+             ProcessingSettings
+
+    Version 1 had the seven values for the cuts and peak, 44 bytes in all.
+    Version 2 adds five values for each extra band (on, type, frequency,
+    gain and Q), which comes to 464 bytes. Version 3 adds the Mid/Side
+    switch and the side channel's seven values, in the same order as the
+    main ones, for 496 bytes. Version 4 adds the peak band's dynamics (on,
+    threshold, ratio, attack, release and sidechain), for 520 bytes. Version
+    5 adds the filter topology, the first of the processing options, for
+    524 bytes. Version 6 adds the oversampling factor, for 528 bytes, and
+    version 7 the linear phase switch and kernel size, for 536. Later
+    versions only ever add values to the end, so an older build can still
+    read the ones it knows, and a newer build reading an older state leaves
+    any missing parameters where they are.
+
+    Hosts snapshot state often, and with lots of instances, so writing it is
+    just a handful of stores with no ValueTree or XML involved.
+*/
+namespace PluginState
+{
+    constexpr int currentVersion = 7;
+
+    void writeBinary(const SimpleEQSettings& settings, const ProcessingSettings& processingSettings,
+                     int program, juce::MemoryBlock& destData);
+
+    // The parameters' ValueTree as XML, wrapped by AudioProcessor::copyXmlToBinary
+    void writeXml(juce::AudioProcessorValueTreeState& ap_tree_state, juce::MemoryBlock& destData);
+
+    // Reads a binary state, an XML state from writeXml, or a plain XML text
+    // file saved from the parameters' ValueTree, and applies it to the
+    // parameters. program is only changed if the state has one. Returns
+    // false, changing nothing, if the data isn't any of these.
+    bool read(const void* data, int sizeInBytes, juce::AudioProcessorValueTreeState& ap_tree_state, int& program);
+}
@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    This file contains the preset bank. It holds the factory presets along
+    with their coefficients, designed ahead of time so switching presets
+    never has to design anything on the audio thread.
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+
+namespace
+{
+    struct FactoryPreset
+    {
+        const char* name;
+        float lowCutFreq;
+        Slope lowCutSlope;
+        float peakFreq, peakGain, peakQ;
+        float highCutFreq;
+        Slope highCutSlope;
+    };
+
+    // The first one matches the parameter defaults
+    const FactoryPreset factoryPresets[] {
+        { "Default",        20.f,  Slope_12, 750.f,  0.f,  1.f,   20000.f, Slope_12 },
+        { "Rumble Filter",  80.f,  Slope_24, 750.f,  0.f,  1.f,   20000.f, Slope_12 },
+        { "Vocal Presence", 100.f, Slope_24, 3000.f, 4.f,  0.8f,  18000.f, Slope_12 },
+        { "Bass Boost",     20.f,  Slope_12, 80.f,   6.f,  0.7f,  20000.f, Slope_12 },
+        { "Mud Cut",        40.f,  Slope_12, 300.f,  -4.f, 1.4f,  20000.f, Slope_12 },
+        { "Dark",           20.f,  Slope_12, 750.f,  0.f,  1.f,   6000.f,  Slope_24 },
+        { "Telephone",      400.f, Slope_48, 1500.f, 3.f,  1.f,   3400.f,  Slope_48 }
+    };
+}
+
+PresetBank::PresetBank()
+{
+    for (auto& factoryPreset : factoryPresets)
+    {
+        Preset preset { factoryPreset.name, {} };
+        auto& settings = preset.coefficients.settings;
+
+        settings.lowCutFreq = factoryPreset.lowCutFreq;
+        settings.lowCutSlope = factoryPreset.lowCutSlope;
+        settings.peakFreq = factoryPreset.peakFreq;
+        settings.peakGain = factoryPreset.peakGain;
+        settings.peakQ = factoryPreset.peakQ;
+        settings.highCutFreq = factoryPreset.highCutFreq;
+        settings.highCutSlope = factoryPreset.highCutSlope;
+
+        presets.push_back(preset);
+    }
+}
+
+juce::String PresetBank::getName(int index) const
+{
+    if (juce::isPositiveAndBelow(index, getNumPresets()))
+        return presets[(size_t) index].name;
+
+    return {};
+}
+
+const SimpleEQSettings& PresetBank::getSettings(int index) const noexcept
+{
+    return getCoefficients(index).settings;
+}
+
+void PresetBank::prepare(CoefficientEngine& coefficientEngine)
+{
+    for (auto& preset : presets)
+        coefficientEngine.design(preset.coefficients);
+
+    prepared = true;
+}
+
+const ChainCoefficients& PresetBank::getCoefficients(int index) const noexcept
+{
+    jassert(juce::isPositiveAndBelow(index, getNumPresets()));
+    return presets[(size_t) juce::jlimit(0, getNumPresets() - 1, index)].coefficients;
+}
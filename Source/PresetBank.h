@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+    This file contains the preset bank. It holds the factory presets along
+    with their coefficients, designed ahead of time so switching presets
+    never has to design anything on the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CoefficientEngine.h"
+
+//==============================================================================
+/**
+    The factory presets, which the processor offers to the host as its
+    programs.
+
+    prepare() designs every preset's coefficients for the sample rate. After
+    that the audio thread can switch to any preset by reading its set
+    straight out of the bank.
+*/
+class PresetBank
+{
+public:
+    PresetBank();
+
+    int getNumPresets() const noexcept                                { return (int) presets.size(); }
+    juce::String getName(int index) const;
+    const SimpleEQSettings& getSettings(int index) const noexcept;
+
+    // Designs every preset for the engine's current sample rate. Call from
+    // prepareToPlay, after the engine has been prepared.
+    void prepare(CoefficientEngine& coefficientEngine);
+    bool isPrepared() const noexcept                                  { return prepared; }
+
+    // Safe on the audio thread once the bank has been prepared
+    const ChainCoefficients& getCoefficients(int index) const noexcept;
+
+private:
+    struct Preset
+    {
+        const char* name;
+        ChainCoefficients coefficients;
+    };
+
+    std::vector<Preset> presets;
+    bool prepared = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PresetBank)
+};
@@ -0,0 +1,253 @@
+/*
+  ==============================================================================
+
+    This file contains the response curve. It works out the EQ's combined
+    magnitude response at a set of frequencies, for drawing or analysis,
+    redoing only the bands whose settings have changed.
+
+  ==============================================================================
+*/
+
+#include "ResponseCurve.h"
+#include "StageElider.h"
+#include "BandArray.h"
+
+ResponseCurve::ResponseCurve(int points, float minimum, float maximum)
+    : numPoints(juce::jmax(2, points)),
+      minFrequency(minimum),
+      maxFrequency(maximum)
+{
+    for (auto& stage : stages)
+    {
+        stage.numerator.resize((size_t) numPoints, 1.f);
+        stage.denominator.resize((size_t) numPoints, 1.f);
+    }
+
+    frequencies.resize((size_t) numPoints);
+    cosOmega.resize((size_t) numPoints);
+    cosTwoOmega.resize((size_t) numPoints);
+    scratch.resize((size_t) numPoints);
+    numerator.resize((size_t) numPoints);
+    denominator.resize((size_t) numPoints);
+    magnitudesDecibels.resize((size_t) numPoints, 0.f);
+
+    for (int i = 0; i < numPoints; ++i)
+        frequencies[(size_t) i] = minFrequency * std::pow(maxFrequency / minFrequency, (float) i / (float) (numPoints - 1));
+}
+
+void ResponseCurve::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+
+    for (size_t i = 0; i < (size_t) numPoints; ++i)
+    {
+        auto omega = juce::MathConstants<double>::twoPi * frequencies[i] / sampleRate;
+        cosOmega[i] = (float) std::cos(omega);
+        cosTwoOmega[i] = (float) std::cos(2.0 * omega);
+    }
+
+    for (auto& stage : stages)
+        stage.isValid = false;
+}
+
+void ResponseCurve::setSkipNeutralBands(bool shouldSkip) noexcept
+{
+    if (shouldSkip == skipNeutralBands)
+        return;
+
+    skipNeutralBands = shouldSkip;
+
+    for (auto& stage : stages)
+        stage.isValid = false;
+}
+
+int ResponseCurve::update(const SimpleEQSettings& settings) noexcept
+{
+    jassert(sampleRate > 0.0);
+
+    int updatedStages = 0;
+
+    for (int i = 0; i < numStages; ++i)
+    {
+        auto stage = static_cast<ChainStage>(i);
+
+        if (hasChanged(stage, settings))
+        {
+            computeStage(stage, settings);
+            updatedStages |= 1 << i;
+        }
+    }
+
+    if (updatedStages != 0)
+        combine();
+
+    return updatedStages;
+}
+
+void ResponseCurve::updateAll(const SimpleEQSettings& settings) noexcept
+{
+    jassert(sampleRate > 0.0);
+
+    for (int i = 0; i < numStages; ++i)
+        computeStage(static_cast<ChainStage>(i), settings);
+
+    combine();
+}
+
+bool ResponseCurve::hasChanged(ChainStage stage, const SimpleEQSettings& settings) const noexcept
+{
+    const auto& cached = stages[(size_t) stage];
+
+    if (! cached.isValid)
+        return true;
+
+    const auto& old = cached.settings;
+
+    switch (stage)
+    {
+        case LowCutStage:   return settings.lowCutFreq != old.lowCutFreq || settings.lowCutSlope != old.lowCutSlope;
+        case PeakStage:     return settings.peakFreq != old.peakFreq || settings.peakGain != old.peakGain || settings.peakQ != old.peakQ;
+        case HighCutStage:  return settings.highCutFreq != old.highCutFreq || settings.highCutSlope != old.highCutSlope;
+        case NumChainStages:
+            for (size_t band = 0; band < (size_t) numExtraBands; ++band)
+            {
+                const auto& newBand = settings.extraBands[band];
+                const auto& oldBand = old.extraBands[band];
+
+                if (newBand.enabled != oldBand.enabled || newBand.type != oldBand.type || newBand.frequency != oldBand.frequency
+                     || newBand.gain != oldBand.gain || newBand.Q != oldBand.Q)
+                    return true;
+            }
+            break;
+    }
+
+    return false;
+}
+
+void ResponseCurve::computeStage(ChainStage stageIndex, const SimpleEQSettings& settings) noexcept
+{
+    auto& stage = stages[(size_t) stageIndex];
+
+    juce::FloatVectorOperations::fill(stage.numerator.data(), 1.f, numPoints);
+    juce::FloatVectorOperations::fill(stage.denominator.data(), 1.f, numPoints);
+
+    stage.settings = settings;
+    stage.isValid = true;
+
+    if (skipNeutralBands && StageElider::isNeutral(stageIndex, settings))
+        return;
+
+    std::array<BiquadCoefficients, 4> cutCoefficients;
+
+    switch (stageIndex)
+    {
+        case LowCutStage:
+            makeCutCoefficients(CutType::lowCut, sampleRate, settings.lowCutFreq, settings.lowCutSlope, cutCoefficients);
+
+            for (int i = 0; i <= settings.lowCutSlope; ++i)
+                multiplyByBiquad(stage, cutCoefficients[(size_t) i]);
+            break;
+
+        case PeakStage:
+            multiplyByBiquad(stage, makePeakCoefficients(sampleRate, settings.peakFreq, settings.peakQ,
+                                                         juce::Decibels::decibelsToGain(settings.peakGain)));
+            break;
+
+        case HighCutStage:
+            makeCutCoefficients(CutType::highCut, sampleRate, settings.highCutFreq, settings.highCutSlope, cutCoefficients);
+
+            for (int i = 0; i <= settings.highCutSlope; ++i)
+                multiplyByBiquad(stage, cutCoefficients[(size_t) i]);
+            break;
+
+        case NumChainStages:
+            // The extra bands that are off or flat aren't run by any engine
+            for (const auto& band : settings.extraBands)
+                if (BandArray::isActive(band))
+                    multiplyByBiquad(stage, makeBandCoefficients(sampleRate, band));
+            break;
+    }
+}
+
+void ResponseCurve::multiplyByBiquad(Stage& stage, const BiquadCoefficients& c) noexcept
+{
+    // For H(z) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2), on the
+    // unit circle both halves of |H|^2 come out as x0 + x1 cos(w) + x2 cos(2w)
+    auto b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+
+    auto multiplyByPolynomial = [this](float* destination, float x0, float x1, float x2)
+    {
+        auto* temp = scratch.data();
+
+        juce::FloatVectorOperations::copyWithMultiply(temp, cosOmega.data(), x1, numPoints);
+        juce::FloatVectorOperations::addWithMultiply(temp, cosTwoOmega.data(), x2, numPoints);
+        juce::FloatVectorOperations::add(temp, x0, numPoints);
+        juce::FloatVectorOperations::multiply(destination, temp, numPoints);
+    };
+
+    multiplyByPolynomial(stage.numerator.data(), b0 * b0 + b1 * b1 + b2 * b2, 2.f * (b0 * b1 + b1 * b2), 2.f * b0 * b2);
+    multiplyByPolynomial(stage.denominator.data(), 1.f + a1 * a1 + a2 * a2, 2.f * (a1 + a1 * a2), 2.f * a2);
+}
+
+void ResponseCurve::combine() noexcept
+{
+    juce::FloatVectorOperations::multiply(numerator.data(), stages[0].numerator.data(), stages[1].numerator.data(), numPoints);
+    juce::FloatVectorOperations::multiply(denominator.data(), stages[0].denominator.data(), stages[1].denominator.data(), numPoints);
+
+    for (size_t i = 2; i < stages.size(); ++i)
+    {
+        juce::FloatVectorOperations::multiply(numerator.data(), stages[i].numerator.data(), numPoints);
+        juce::FloatVectorOperations::multiply(denominator.data(), stages[i].denominator.data(), numPoints);
+    }
+
+    // |H|^2 in dB is 10 log10, rather than the 20 log10 for |H|
+    for (size_t i = 0; i < (size_t) numPoints; ++i)
+    {
+        auto power = numerator[i] / denominator[i];
+        magnitudesDecibels[i] = power > 0.f ? juce::jmax(minDecibels, 10.f * std::log10(power)) : minDecibels;
+    }
+
+    ++version;
+}
+
+int ResponseCurve::getBiquads(const SimpleEQSettings& settings, double sampleRate, DoubleBiquads& biquads) noexcept
+{
+    int numBiquads = 0;
+    std::array<BasicBiquadCoefficients<double>, 4> cut;
+
+    if (! StageElider::isNeutral(LowCutStage, settings))
+    {
+        makeCutCoefficients(CutType::lowCut, sampleRate, (double) settings.lowCutFreq, settings.lowCutSlope, cut);
+
+        for (int i = 0; i <= settings.lowCutSlope; ++i)
+            biquads[(size_t) numBiquads++] = cut[(size_t) i];
+    }
+
+    if (! StageElider::isNeutral(PeakStage, settings))
+        biquads[(size_t) numBiquads++] = makePeakCoefficients(sampleRate, (double) settings.peakFreq, (double) settings.peakQ,
+                                                              juce::Decibels::decibelsToGain((double) settings.peakGain));
+
+    if (! StageElider::isNeutral(HighCutStage, settings))
+    {
+        makeCutCoefficients(CutType::highCut, sampleRate, (double) settings.highCutFreq, settings.highCutSlope, cut);
+
+        for (int i = 0; i <= settings.highCutSlope; ++i)
+            biquads[(size_t) numBiquads++] = cut[(size_t) i];
+    }
+
+    for (const auto& band : settings.extraBands)
+        if (BandArray::isActive(band))
+            biquads[(size_t) numBiquads++] = makeBandCoefficients<double>(sampleRate, band);
+
+    return numBiquads;
+}
+
+double ResponseCurve::getMagnitudeSquared(const BasicBiquadCoefficients<double>& c, double cosOmega, double cosTwoOmega) noexcept
+{
+    auto b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+
+    auto numerator = b0 * b0 + b1 * b1 + b2 * b2 + 2.0 * (b0 * b1 + b1 * b2) * cosOmega + 2.0 * b0 * b2 * cosTwoOmega;
+    auto denominator = 1.0 + a1 * a1 + a2 * a2 + 2.0 * (a1 + a1 * a2) * cosOmega + 2.0 * a2 * cosTwoOmega;
+
+    return numerator / denominator;
+}
@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+    This file contains the response curve. It works out the EQ's combined
+    magnitude response at a set of frequencies, for drawing or analysis,
+    redoing only the bands whose settings have changed.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "BiquadCoefficients.h"
+
+//==============================================================================
+/**
+    The response is evaluated at numPoints frequencies spaced evenly on a log
+    scale. Each band keeps its own response, as the numerator and
+    denominator of |H|^2 multiplied over its biquads, so when a parameter
+    changes only that band is recomputed. The bands are then multiplied
+    together and converted to dB.
+
+    The per-point work is multiplies and adds over whole arrays, which goes
+    through juce::FloatVectorOperations and so runs on SIMD registers. Only
+    the final conversion to dB is done a point at a time.
+
+    Uses the same allocation-free designs as the audio thread, so what's
+    drawn matches what's heard. Neutral bands count as flat by default, the
+    same as when the processor elides them. Not thread-safe: give each
+    thread that wants a curve its own.
+*/
+class ResponseCurve
+{
+public:
+    explicit ResponseCurve(int numPoints = 512,
+                           float minFrequency = 20.f,
+                           float maxFrequency = 20000.f);
+
+    // Builds the frequency tables for the sample rate. Allocates, and marks
+    // every band as needing an update.
+    void prepare(double sampleRate);
+    double getSampleRate() const noexcept               { return sampleRate; }
+
+    // Recomputes the bands whose settings differ from the last update, and
+    // the combined curve if any did. Returns a bit (1 << stage) for each band
+    // that was recomputed, so 0 means nothing changed. The extra bands are
+    // kept together as one more stage, bit (1 << NumChainStages).
+    int update(const SimpleEQSettings& settings) noexcept;
+
+    // Recomputes every band whether it changed or not
+    void updateAll(const SimpleEQSettings& settings) noexcept;
+
+    // Whether bands at their neutral settings (see StageElider) are drawn as
+    // flat or with their actual design. Match this to the processor's stage
+    // elision setting.
+    void setSkipNeutralBands(bool shouldSkip) noexcept;
+
+    int getNumPoints() const noexcept                   { return numPoints; }
+    const float* getFrequencies() const noexcept        { return frequencies.data(); }
+
+    // The combined response, in dB, one value per frequency
+    const float* getMagnitudesDecibels() const noexcept { return magnitudesDecibels.data(); }
+
+    // Goes up every time the combined curve changes
+    juce::uint32 getVersion() const noexcept            { return version; }
+
+    // The floor for the dB values, so deep stopbands don't reach -inf
+    static constexpr float minDecibels = -200.f;
+
+    // The float curve loses the bottom of a cut's stopband to rounding, well
+    // below the cut frequency. These work in double, for when that matters.
+
+    // The cuts at their steepest, the peak, and every extra band
+    static constexpr int maxBiquads = 4 + 1 + 4 + numExtraBands;
+    using DoubleBiquads = std::array<BasicBiquadCoefficients<double>, maxBiquads>;
+
+    // The biquads the IIR path would run for these settings, designed in
+    // double at sampleRate, with neutral bands left out. Returns how many.
+    static int getBiquads(const SimpleEQSettings& settings, double sampleRate, DoubleBiquads& biquads) noexcept;
+
+    // |H|^2 of one biquad on the unit circle, expanded the same way as the
+    // float curve
+    static double getMagnitudeSquared(const BasicBiquadCoefficients<double>& coefficients,
+                                      double cosOmega, double cosTwoOmega) noexcept;
+
+private:
+    struct Stage
+    {
+        std::vector<float> numerator, denominator;
+        SimpleEQSettings settings;
+        bool isValid = false;
+    };
+
+    bool hasChanged(ChainStage stage, const SimpleEQSettings& settings) const noexcept;
+    void computeStage(ChainStage stage, const SimpleEQSettings& settings) noexcept;
+    void multiplyByBiquad(Stage& stage, const BiquadCoefficients& coefficients) noexcept;
+    void combine() noexcept;
+
+    const int numPoints;
+    const float minFrequency, maxFrequency;
+    double sampleRate = 0.0;
+    bool skipNeutralBands = true;
+
+    std::vector<float> frequencies;
+
+    // cos(w) and cos(2w) for each frequency, which is all |H|^2 needs
+    std::vector<float> cosOmega, cosTwoOmega;
+
+    // The cuts and peak, then all the extra bands together
+    static constexpr int numStages = NumChainStages + 1;
+    std::array<Stage, numStages> stages;
+    std::vector<float> scratch, numerator, denominator, magnitudesDecibels;
+    juce::uint32 version = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ResponseCurve)
+};
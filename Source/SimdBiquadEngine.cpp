@@ -0,0 +1,208 @@
+/*
+  ==============================================================================
+
+    This file contains the SIMD filter engine. It runs the same low cut,
+    peak and high cut biquads as MonoChain, but processes several channels
+    at once, one channel per SIMD lane.
+
+  ==============================================================================
+*/
+
+#include "SimdBiquadEngine.h"
+
+#if JUCE_USE_SIMD
+
+namespace
+{
+    // Allocates room for numRegisters SIMD registers and returns a pointer
+    // into the block that's correctly aligned for them
+    SimdBiquadEngine::Register* allocateRegisters(juce::HeapBlock<char>& memory, size_t numRegisters)
+    {
+        using Register = SimdBiquadEngine::Register;
+
+        memory.calloc(numRegisters * sizeof(Register) + Register::SIMDRegisterSize);
+        auto* aligned = Register::getNextSIMDAlignedPtr(reinterpret_cast<float*>(memory.get()));
+        return reinterpret_cast<Register*>(aligned);
+    }
+}
+
+void SimdBiquadEngine::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    numChannels = spec.numChannels;
+    numGroups = (numChannels + numLanes - 1) / numLanes;
+    maximumBlockSize = spec.maximumBlockSize;
+
+    state = allocateRegisters(stateMemory, numGroups * numPositions * 2);
+    interleaved = allocateRegisters(interleavedMemory, maximumBlockSize);
+
+    coefficients.fill(passThroughCoefficients);
+    numLowCutBiquads = 0;
+    numHighCutBiquads = 0;
+    updateActivePositions();
+
+    reset();
+}
+
+void SimdBiquadEngine::reset() noexcept
+{
+    for (size_t i = 0; i < numGroups * numPositions * 2; ++i)
+        state[i] = Register::expand(0.f);
+}
+
+void SimdBiquadEngine::setCoefficients(const ChainCoefficients& chainCoefficients) noexcept
+{
+    const auto& settings = chainCoefficients.settings;
+
+    // A slope of n uses the first (n + 1) stages of the cut filter
+    numLowCutBiquads = settings.lowCutSlope + 1;
+    numHighCutBiquads = settings.highCutSlope + 1;
+
+    for (int stage = 0; stage < numLowCutBiquads; ++stage)
+        coefficients[(size_t) (lowCutPosition + stage)] = chainCoefficients.lowCut[(size_t) stage];
+
+    coefficients[peakPosition] = chainCoefficients.peak;
+
+    for (int stage = 0; stage < numHighCutBiquads; ++stage)
+        coefficients[(size_t) (highCutPosition + stage)] = chainCoefficients.highCut[(size_t) stage];
+
+    updateActivePositions();
+}
+
+void SimdBiquadEngine::setStageRunning(ChainStage stage, bool shouldRun) noexcept
+{
+    if (stageRunning[(size_t) stage] == shouldRun)
+        return;
+
+    stageRunning[(size_t) stage] = shouldRun;
+    updateActivePositions();
+}
+
+void SimdBiquadEngine::updateActivePositions() noexcept
+{
+    const std::array<int, NumChainStages> firstPositions { lowCutPosition, peakPosition, highCutPosition };
+    const std::array<int, NumChainStages> numBiquads { numLowCutBiquads, 1, numHighCutBiquads };
+
+    numActivePositions = 0;
+
+    for (size_t stage = 0; stage < (size_t) NumChainStages; ++stage)
+    {
+        stageStarts[stage] = numActivePositions;
+
+        if (stageRunning[stage])
+            for (int i = 0; i < numBiquads[stage]; ++i)
+                activePositions[(size_t) numActivePositions++] = firstPositions[stage] + i;
+    }
+
+    stageStarts[NumChainStages] = numActivePositions;
+}
+
+void SimdBiquadEngine::resetStage(ChainStage stage) noexcept
+{
+    // Clear every position the band owns, including the ones the current
+    // slope doesn't use
+    auto firstPosition = stage == LowCutStage ? lowCutPosition : stage == PeakStage ? peakPosition : highCutPosition;
+    auto lastPosition = stage == LowCutStage ? peakPosition : stage == PeakStage ? highCutPosition : numPositions;
+
+    for (size_t group = 0; group < numGroups; ++group)
+        for (auto position = firstPosition; position < lastPosition; ++position)
+            for (size_t i = 0; i < 2; ++i)
+                state[(group * numPositions + (size_t) position) * 2 + i] = Register::expand(0.f);
+}
+
+void SimdBiquadEngine::process(const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    processPositions(block, 0, numActivePositions);
+}
+
+void SimdBiquadEngine::processStage(const juce::dsp::AudioBlock<float>& block, ChainStage stage) noexcept
+{
+    processPositions(block, stageStarts[(size_t) stage], stageStarts[(size_t) stage + 1]);
+}
+
+void SimdBiquadEngine::processPositions(const juce::dsp::AudioBlock<float>& block, int firstActive, int lastActive) noexcept
+{
+    jassert(block.getNumChannels() <= numChannels);
+    jassert(block.getNumSamples() <= maximumBlockSize);
+
+    // Nothing to do if every band has been taken out
+    if (firstActive == lastActive)
+        return;
+
+    auto numBlockGroups = (block.getNumChannels() + numLanes - 1) / numLanes;
+
+    for (size_t group = 0; group < numBlockGroups; ++group)
+        processGroup(block, group, firstActive, lastActive);
+}
+
+void SimdBiquadEngine::processGroup(const juce::dsp::AudioBlock<float>& block, size_t group, int firstActive, int lastActive) noexcept
+{
+    auto numSamples = block.getNumSamples();
+    auto firstChannel = group * numLanes;
+    auto* lanes = reinterpret_cast<float*>(interleaved);
+
+    // Interleave the group's channels so each register holds one sample from
+    // every channel. Lanes past the last channel are fed silence.
+    for (size_t lane = 0; lane < numLanes; ++lane)
+    {
+        auto channel = firstChannel + lane;
+
+        if (channel < block.getNumChannels())
+        {
+            auto* source = block.getChannelPointer(channel);
+
+            for (size_t i = 0; i < numSamples; ++i)
+                lanes[i * numLanes + lane] = source[i];
+        }
+        else
+        {
+            for (size_t i = 0; i < numSamples; ++i)
+                lanes[i * numLanes + lane] = 0.f;
+        }
+    }
+
+    // Run each active biquad over the interleaved samples. The state lives in
+    // local registers for the length of the block.
+    for (int i = firstActive; i < lastActive; ++i)
+    {
+        auto position = (size_t) activePositions[(size_t) i];
+        const auto& c = coefficients[position];
+
+        auto b0 = Register::expand(c[0]);
+        auto b1 = Register::expand(c[1]);
+        auto b2 = Register::expand(c[2]);
+        auto a1 = Register::expand(c[3]);
+        auto a2 = Register::expand(c[4]);
+
+        auto* positionState = state + (group * numPositions + position) * 2;
+        auto s1 = positionState[0];
+        auto s2 = positionState[1];
+
+        for (size_t n = 0; n < numSamples; ++n)
+        {
+            auto input = interleaved[n];
+            auto output = (b0 * input) + s1;
+            s1 = (b1 * input) - (a1 * output) + s2;
+            s2 = (b2 * input) - (a2 * output);
+            interleaved[n] = output;
+        }
+
+        positionState[0] = s1;
+        positionState[1] = s2;
+    }
+
+    // Write the filtered samples back out to their channels
+    for (size_t lane = 0; lane < numLanes; ++lane)
+    {
+        auto channel = firstChannel + lane;
+
+        if (channel >= block.getNumChannels())
+            break;
+
+        auto* destination = block.getChannelPointer(channel);
+
+        for (size_t i = 0; i < numSamples; ++i)
+            destination[i] = lanes[i * numLanes + lane];
+    }
+}
+
+#endif
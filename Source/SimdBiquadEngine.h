@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    This file contains the SIMD filter engine. It runs the same low cut,
+    peak and high cut biquads as MonoChain, but processes several channels
+    at once, one channel per SIMD lane.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CoefficientEngine.h"
+
+#if JUCE_USE_SIMD
+
+//==============================================================================
+/**
+    Every channel shares the same coefficients, so channels are packed into
+    the lanes of a juce::dsp::SIMDRegister and the biquad recurrence runs on
+    all of them at once. Channels are processed in groups of
+    SIMDRegister<float>::SIMDNumElements (4 with SSE or NEON).
+
+    The biquads use the same transposed direct form II as
+    juce::dsp::IIR::Filter, so the output matches the MonoChain path.
+*/
+class SimdBiquadEngine
+{
+public:
+    using Register = juce::dsp::SIMDRegister<float>;
+
+    static constexpr size_t numLanes = Register::SIMDNumElements;
+
+    SimdBiquadEngine() = default;
+
+    // Allocates the filter state and the interleaving buffer. Call this from
+    // prepareToPlay; nothing after this allocates.
+    void prepare(const juce::dsp::ProcessSpec& spec);
+
+    // Clears the filter state
+    void reset() noexcept;
+
+    // Copies in a new set of coefficients and works out which stages are
+    // active for the selected slopes
+    void setCoefficients(const ChainCoefficients& chainCoefficients) noexcept;
+
+    // Replaces just the peak's coefficients, for the peak band's dynamics
+    void setPeakCoefficients(const BiquadCoefficients& peak) noexcept    { coefficients[peakPosition] = peak; }
+
+    // Takes a whole band out of the chain, or puts it back. A band that's
+    // out keeps its state but isn't processed at all.
+    void setStageRunning(ChainStage stage, bool shouldRun) noexcept;
+
+    // Clears the filter state of one band
+    void resetStage(ChainStage stage) noexcept;
+
+    // Filters every channel of the block in place
+    void process(const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    // Filters every channel of the block in place with just one band
+    void processStage(const juce::dsp::AudioBlock<float>& block, ChainStage stage) noexcept;
+
+private:
+    // Positions of the nine biquads in the chain. Each one keeps its own
+    // state even while it's inactive, so changing the slope doesn't move
+    // state between stages.
+    static constexpr int numPositions = 9;
+    static constexpr int lowCutPosition = 0;
+    static constexpr int peakPosition = 4;
+    static constexpr int highCutPosition = 5;
+
+    void updateActivePositions() noexcept;
+    void processPositions(const juce::dsp::AudioBlock<float>& block, int firstActive, int lastActive) noexcept;
+    void processGroup(const juce::dsp::AudioBlock<float>& block, size_t group, int firstActive, int lastActive) noexcept;
+
+    std::array<BiquadCoefficients, numPositions> coefficients;
+    int numLowCutBiquads = 0;
+    int numHighCutBiquads = 0;
+    std::array<bool, NumChainStages> stageRunning { true, true, true };
+
+    // The positions to run, in chain order, and where each band's run of
+    // them starts and ends
+    std::array<int, numPositions> activePositions;
+    int numActivePositions = 0;
+    std::array<int, NumChainStages + 1> stageStarts {};
+
+    size_t numChannels = 0;
+    size_t numGroups = 0;
+    size_t maximumBlockSize = 0;
+
+    // Two state registers per position per channel group
+    juce::HeapBlock<char> stateMemory;
+    Register* state = nullptr;
+
+    // One register per sample holding a sample from each channel in the group
+    juce::HeapBlock<char> interleavedMemory;
+    Register* interleaved = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SimdBiquadEngine)
+};
+
+#endif
@@ -0,0 +1,258 @@
+/*
+  ==============================================================================
+
+    This file contains the settings and parameter ID's shared between the
+    processor and the helper classes that design and run the filters.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+enum Slope
+{
+    Slope_12,
+    Slope_24,
+    Slope_36,
+    Slope_48
+};
+
+// The three bands, in the order the audio runs through them
+enum ChainStage
+{
+    LowCutStage,
+    PeakStage,
+    HighCutStage,
+    NumChainStages
+};
+
+// The kinds of filter the extra bands can be
+enum class BandType
+{
+    peak,
+    lowShelf,
+    highShelf,
+    notch
+};
+
+// Settings for one of the extra bands. Gain is ignored by notches.
+struct BandSettings
+{
+    bool enabled { false };
+    BandType type { BandType::peak };
+    float frequency { 1000.f };
+    float gain { 0 };
+    float Q { 1.f };
+};
+
+// How many bands there are on top of low cut, peak and high cut, which
+// makes 24 in all
+constexpr int numExtraBands = 21;
+
+// The side channel's bands in Mid/Side mode. The defaults match the
+// parameters', so a side channel nobody has touched does nothing.
+struct SideSettings
+{
+    float lowCutFreq { 20.f };
+    Slope lowCutSlope { Slope_12 };
+    
+    float peakFreq { 750.f };
+    float peakGain { 0 };
+    float peakQ { 1.f };
+    
+    float highCutFreq { 20000.f };
+    Slope highCutSlope { Slope_12 };
+};
+
+// The peak band's dynamics. When they're on, the band's gain drops below
+// the peak gain setting by however much the level in the band goes over
+// the threshold, scaled by the ratio the way a compressor's is.
+struct DynamicSettings
+{
+    bool enabled { false };
+    float threshold { -20.f };
+    float ratio { 2.f };
+    float attackMs { 10.f };
+    float releaseMs { 100.f };
+    
+    // Listens to the sidechain input rather than the main one, if the host
+    // has connected it
+    bool useSidechain { false };
+};
+
+struct SimpleEQSettings
+{
+    // Low cut settings
+    float lowCutFreq { 0 };
+    Slope lowCutSlope { Slope_12 };
+    
+    // Peak band settings
+    float peakFreq { 0 };
+    float peakGain { 0 };
+    float peakQ { 1.f };
+    
+    // High cut settings
+    float highCutFreq { 0 };
+    Slope highCutSlope { Slope_12 };
+    
+    // Extra bands, run after the high cut in this order
+    std::array<BandSettings, numExtraBands> extraBands;
+    
+    // In Mid/Side mode a stereo signal is filtered as mid (L + R) / 2 and
+    // side (L - R) / 2. Everything above is the mid channel's, and the
+    // side channel has its own cuts and peak.
+    bool midSide { false };
+    SideSettings side;
+    
+    DynamicSettings dynamic;
+};
+
+// How each second order section is built. The transposed direct form II is
+// what juce::dsp::IIR::Filter uses. The state variable filter (Andrew
+// Simper's trapezoidal SVF) is set up from tan(pi f / fs) and 1 / Q rather
+// than from polynomial coefficients, so it stays accurate where a biquad's
+// poles crowd up against z = 1, e.g. a steep low cut at 20 Hz and 192 kHz.
+enum class FilterTopology
+{
+    transposedDirectForm,
+    stateVariable
+};
+
+// How the filters are run, rather than what they do. These are saved with
+// the state like everything else, but presets leave them alone and hosts
+// can't automate them.
+struct ProcessingSettings
+{
+    FilterTopology filterTopology { FilterTopology::transposedDirectForm };
+    
+    // 1, 2 or 4
+    int oversamplingFactor { 1 };
+    
+    // The kernel size defaults to LinearPhaseEngine::defaultKernelSize
+    bool linearPhase { false };
+    int linearPhaseKernelSize { 8192 };
+};
+
+// The side channel's bands as a full set of settings, with no extra bands
+inline SimpleEQSettings getSideChannelSettings(const SimpleEQSettings& settings)
+{
+    SimpleEQSettings sideSettings;
+    
+    sideSettings.lowCutFreq = settings.side.lowCutFreq;
+    sideSettings.lowCutSlope = settings.side.lowCutSlope;
+    sideSettings.peakFreq = settings.side.peakFreq;
+    sideSettings.peakGain = settings.side.peakGain;
+    sideSettings.peakQ = settings.side.peakQ;
+    sideSettings.highCutFreq = settings.side.highCutFreq;
+    sideSettings.highCutSlope = settings.side.highCutSlope;
+    
+    return sideSettings;
+}
+
+// Reads every parameter, looking each one up by ID. For anything that reads
+// them often, ChainParameters looks them up just once.
+SimpleEQSettings getChainSettings(juce::AudioProcessorValueTreeState& ap_tree_state);
+
+// Sets every parameter to match the settings, letting the host know
+void setChainSettings(juce::AudioProcessorValueTreeState& ap_tree_state, const SimpleEQSettings& settings);
+
+// The same for the processing options
+ProcessingSettings getProcessingSettings(juce::AudioProcessorValueTreeState& ap_tree_state);
+void setProcessingSettings(juce::AudioProcessorValueTreeState& ap_tree_state, const ProcessingSettings& settings);
+
+// Parameter ID's
+const std::string LOW_CUT_FREQ = "LOW_CUT_FREQ";
+const std::string LOW_CUT_SLOPE = "LOW_CUT_SLOPE";
+
+const std::string PEAK_FREQ = "PEAK_FREQ";
+const std::string PEAK_GAIN = "PEAK_GAIN";
+const std::string PEAK_Q = "PEAK_Q";
+
+const std::string HIGH_CUT_FREQ = "HIGH_CUT_FREQ";
+const std::string HIGH_CUT_SLOPE = "HIGH_CUT_SLOPE";
+
+// The extra bands' parameter ID's are the band number (from 1) followed by
+// one of these, e.g. "BAND1_FREQ"
+const std::string BAND_ON = "_ON";
+const std::string BAND_TYPE = "_TYPE";
+const std::string BAND_FREQ = "_FREQ";
+const std::string BAND_GAIN = "_GAIN";
+const std::string BAND_Q = "_Q";
+
+inline std::string getExtraBandParameterID(int bandIndex, const std::string& suffix)
+{
+    return "BAND" + std::to_string(bandIndex + 1) + suffix;
+}
+
+const std::string MID_SIDE = "MID_SIDE";
+
+const std::string SIDE_LOW_CUT_FREQ = "SIDE_LOW_CUT_FREQ";
+const std::string SIDE_LOW_CUT_SLOPE = "SIDE_LOW_CUT_SLOPE";
+
+const std::string SIDE_PEAK_FREQ = "SIDE_PEAK_FREQ";
+const std::string SIDE_PEAK_GAIN = "SIDE_PEAK_GAIN";
+const std::string SIDE_PEAK_Q = "SIDE_PEAK_Q";
+
+const std::string SIDE_HIGH_CUT_FREQ = "SIDE_HIGH_CUT_FREQ";
+const std::string SIDE_HIGH_CUT_SLOPE = "SIDE_HIGH_CUT_SLOPE";
+
+const std::string DYNAMIC_ON = "DYNAMIC_ON";
+const std::string DYNAMIC_THRESHOLD = "DYNAMIC_THRESHOLD";
+const std::string DYNAMIC_RATIO = "DYNAMIC_RATIO";
+const std::string DYNAMIC_ATTACK = "DYNAMIC_ATTACK";
+const std::string DYNAMIC_RELEASE = "DYNAMIC_RELEASE";
+const std::string DYNAMIC_SIDECHAIN = "DYNAMIC_SIDECHAIN";
+
+const std::string FILTER_TOPOLOGY = "FILTER_TOPOLOGY";
+const std::string OVERSAMPLING = "OVERSAMPLING";
+const std::string LINEAR_PHASE = "LINEAR_PHASE";
+const std::string KERNEL_SIZE = "KERNEL_SIZE";
+
+//Parameter Labels
+const std::string LOW_CUT_FREQ_LABEL = "Low Cut Frequency";
+const std::string LOW_CUT_SLOPE_LABEL = "Low Cut Slope";
+
+const std::string PEAK_FREQ_LABEL = "Peak Frequency";
+const std::string PEAK_GAIN_LABEL = "Peak Gain";
+const std::string PEAK_Q_LABEL = "Peak Q";
+
+const std::string HIGH_CUT_FREQ_LABEL = "High Cut Frequency";
+const std::string HIGH_CUT_SLOPE_LABEL = "High Cut Slope";
+
+const std::string BAND_ON_LABEL = "On";
+const std::string BAND_TYPE_LABEL = "Type";
+const std::string BAND_FREQ_LABEL = "Frequency";
+const std::string BAND_GAIN_LABEL = "Gain";
+const std::string BAND_Q_LABEL = "Q";
+
+const std::string MID_SIDE_LABEL = "Mid/Side";
+
+const std::string SIDE_LOW_CUT_FREQ_LABEL = "Side Low Cut Frequency";
+const std::string SIDE_LOW_CUT_SLOPE_LABEL = "Side Low Cut Slope";
+
+const std::string SIDE_PEAK_FREQ_LABEL = "Side Peak Frequency";
+const std::string SIDE_PEAK_GAIN_LABEL = "Side Peak Gain";
+const std::string SIDE_PEAK_Q_LABEL = "Side Peak Q";
+
+const std::string SIDE_HIGH_CUT_FREQ_LABEL = "Side High Cut Frequency";
+const std::string SIDE_HIGH_CUT_SLOPE_LABEL = "Side High Cut Slope";
+
+const std::string DYNAMIC_ON_LABEL = "Peak Dynamics";
+const std::string DYNAMIC_THRESHOLD_LABEL = "Peak Threshold";
+const std::string DYNAMIC_RATIO_LABEL = "Peak Ratio";
+const std::string DYNAMIC_ATTACK_LABEL = "Peak Attack";
+const std::string DYNAMIC_RELEASE_LABEL = "Peak Release";
+const std::string DYNAMIC_SIDECHAIN_LABEL = "Peak Sidechain";
+
+const std::string FILTER_TOPOLOGY_LABEL = "Filter Topology";
+const std::string OVERSAMPLING_LABEL = "Oversampling";
+const std::string LINEAR_PHASE_LABEL = "Linear Phase";
+const std::string KERNEL_SIZE_LABEL = "Kernel Size";
+
+// e.g. "Band 1 Frequency"
+inline std::string getExtraBandParameterLabel(int bandIndex, const std::string& label)
+{
+    return "Band " + std::to_string(bandIndex + 1) + " " + label;
+}
@@ -0,0 +1,251 @@
+/*
+  ==============================================================================
+
+    This file contains the spectrum analyzer. The audio thread hands it the
+    signal before and after the EQ, and a background thread turns that into
+    log-frequency spectra for the editor to draw.
+
+  ==============================================================================
+*/
+
+#include "SpectrumAnalyzer.h"
+
+namespace
+{
+    // How fast a band's level falls back when the signal drops, per FFT
+    constexpr float releaseDecibelsPerHop = 1.5f;
+
+    // Position on the log frequency scale, in bands, to frequency
+    float getFrequencyAt(float bin) noexcept
+    {
+        auto proportion = bin / (float) (SpectrumAnalyzer::numBins - 1);
+        return SpectrumAnalyzer::minFrequency * std::pow(SpectrumAnalyzer::maxFrequency / SpectrumAnalyzer::minFrequency, proportion);
+    }
+
+    // Writes the average of every channel in the block, starting at
+    // sampleOffset, into destination
+    void mixDown(const juce::dsp::AudioBlock<const float>& block, int sampleOffset, float* destination, int numSamples) noexcept
+    {
+        if (numSamples <= 0)
+            return;
+
+        auto numChannels = block.getNumChannels();
+        auto gain = 1.f / (float) numChannels;
+
+        juce::FloatVectorOperations::copyWithMultiply(destination, block.getChannelPointer(0) + sampleOffset, gain, numSamples);
+
+        for (size_t channel = 1; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::addWithMultiply(destination, block.getChannelPointer(channel) + sampleOffset, gain, numSamples);
+    }
+
+    // The analysis is all in float, so double input is narrowed as it's
+    // mixed down
+    void mixDown(const juce::dsp::AudioBlock<const double>& block, int sampleOffset, float* destination, int numSamples) noexcept
+    {
+        if (numSamples <= 0)
+            return;
+
+        auto numChannels = block.getNumChannels();
+        auto gain = 1.0 / (double) numChannels;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            double sum = 0.0;
+
+            for (size_t channel = 0; channel < numChannels; ++channel)
+                sum += block.getChannelPointer(channel)[sampleOffset + i];
+
+            destination[i] = (float) (sum * gain);
+        }
+    }
+}
+
+SpectrumAnalyzer::Channel::Channel()
+    : fifoBuffer((size_t) fifoSize, 0.f),
+      frame((size_t) fftSize, 0.f)
+{
+    levels.fill(minDecibels);
+}
+
+//==============================================================================
+SpectrumAnalyzer::SpectrumAnalyzer()
+    : fftData((size_t) fftSize * 2, 0.f)
+{
+    latestSpectrum.input.fill(minDecibels);
+    latestSpectrum.output.fill(minDecibels);
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+    // Waits for the analysis thread if it's in the middle of a slice
+    analysisThread->removeTimeSliceClient(this);
+}
+
+void SpectrumAnalyzer::prepare(double sampleRate)
+{
+    currentSampleRate = sampleRate;
+    needsFlush = true;
+}
+
+void SpectrumAnalyzer::setActive(bool shouldBeActive)
+{
+    if (shouldBeActive == isActive())
+        return;
+
+    if (shouldBeActive)
+    {
+        // Whatever is left in the FIFOs from last time is stale
+        needsFlush = true;
+        active = true;
+        analysisThread->addTimeSliceClient(this);
+    }
+    else
+    {
+        active = false;
+        analysisThread->removeTimeSliceClient(this);
+    }
+}
+
+bool SpectrumAnalyzer::getLatestSpectrum(Spectrum& destination, juce::uint32& lastVersion) const
+{
+    const juce::ScopedLock sl(spectrumLock);
+
+    if (version == lastVersion)
+        return false;
+
+    destination = latestSpectrum;
+    lastVersion = version;
+    return true;
+}
+
+float SpectrumAnalyzer::getBinFrequency(int bin) noexcept
+{
+    return getFrequencyAt((float) bin);
+}
+
+//==============================================================================
+template <typename SampleType>
+void SpectrumAnalyzer::push(Channel& channel, const juce::dsp::AudioBlock<const SampleType>& block) noexcept
+{
+    if (! isActive() || block.getNumChannels() == 0)
+        return;
+
+    // If the analysis has fallen behind and the FIFO is full, whatever
+    // doesn't fit is dropped
+    int start1, size1, start2, size2;
+    channel.fifo.prepareToWrite((int) block.getNumSamples(), start1, size1, start2, size2);
+
+    mixDown(block, 0, channel.fifoBuffer.data() + start1, size1);
+    mixDown(block, size1, channel.fifoBuffer.data() + start2, size2);
+
+    channel.fifo.finishedWrite(size1 + size2);
+}
+
+template void SpectrumAnalyzer::push(Channel&, const juce::dsp::AudioBlock<const float>&) noexcept;
+template void SpectrumAnalyzer::push(Channel&, const juce::dsp::AudioBlock<const double>&) noexcept;
+
+int SpectrumAnalyzer::useTimeSlice()
+{
+    auto sampleRate = currentSampleRate.load();
+
+    // Nothing to analyse until the processor has been prepared
+    if (sampleRate <= 0.0)
+        return 50;
+
+    if (sampleRate != analysedSampleRate)
+        updateBinRanges(sampleRate);
+
+    if (needsFlush.exchange(false))
+    {
+        for (auto* channel : { &inputChannel, &outputChannel })
+        {
+            channel->fifo.finishedRead(channel->fifo.getNumReady());
+            std::fill(channel->frame.begin(), channel->frame.end(), 0.f);
+            channel->levels.fill(minDecibels);
+        }
+    }
+
+    // Analyse both, rather than stopping at the first one that has news
+    auto inputUpdated = analyse(inputChannel);
+    auto outputUpdated = analyse(outputChannel);
+
+    if (inputUpdated || outputUpdated)
+    {
+        const juce::ScopedLock sl(spectrumLock);
+        latestSpectrum.input = inputChannel.levels;
+        latestSpectrum.output = outputChannel.levels;
+        ++version;
+    }
+
+    // Roughly one hop at 48 kHz
+    return 10;
+}
+
+bool SpectrumAnalyzer::analyse(Channel& channel)
+{
+    // If the thread has fallen well behind, skip ahead rather than working
+    // through every old frame
+    auto numReady = channel.fifo.getNumReady();
+
+    if (numReady > fftSize)
+        channel.fifo.finishedRead(((numReady - fftSize) / hopSize) * hopSize);
+
+    bool updated = false;
+
+    while (channel.fifo.getNumReady() >= hopSize)
+    {
+        // Slide the frame along and add the newest hop on the end
+        std::move(channel.frame.begin() + hopSize, channel.frame.end(), channel.frame.begin());
+
+        int start1, size1, start2, size2;
+        channel.fifo.prepareToRead(hopSize, start1, size1, start2, size2);
+
+        auto* destination = channel.frame.data() + (fftSize - hopSize);
+        std::copy_n(channel.fifoBuffer.data() + start1, size1, destination);
+        std::copy_n(channel.fifoBuffer.data() + start2, size2, destination + size1);
+
+        channel.fifo.finishedRead(size1 + size2);
+
+        std::copy(channel.frame.begin(), channel.frame.end(), fftData.begin());
+        std::fill(fftData.begin() + fftSize, fftData.end(), 0.f);
+
+        window.multiplyWithWindowingTable(fftData.data(), (size_t) fftSize);
+        fft.performFrequencyOnlyForwardTransform(fftData.data());
+
+        for (size_t bin = 0; bin < (size_t) numBins; ++bin)
+        {
+            auto magnitude = *std::max_element(fftData.begin() + firstFftBin[bin], fftData.begin() + lastFftBin[bin] + 1);
+            auto level = juce::Decibels::gainToDecibels(magnitude * magnitudeScale, minDecibels);
+
+            channel.levels[bin] = juce::jmax(level, channel.levels[bin] - releaseDecibelsPerHop);
+        }
+
+        updated = true;
+    }
+
+    return updated;
+}
+
+void SpectrumAnalyzer::updateBinRanges(double sampleRate)
+{
+    auto binsPerHz = (float) fftSize / (float) sampleRate;
+    auto lastUsableBin = fftSize / 2;
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        // The band runs halfway to its neighbours on the log scale
+        auto first = (int) std::ceil(getFrequencyAt((float) bin - 0.5f) * binsPerHz);
+        auto last = (int) std::floor(getFrequencyAt((float) bin + 0.5f) * binsPerHz);
+
+        if (last < first)
+            first = last = juce::roundToInt(getFrequencyAt((float) bin) * binsPerHz);
+
+        firstFftBin[(size_t) bin] = juce::jlimit(1, lastUsableBin, first);
+        lastFftBin[(size_t) bin] = juce::jlimit(firstFftBin[(size_t) bin], lastUsableBin, last);
+    }
+
+    // A full scale sine reads 0 dB. The FFT's peak for it is fftSize / 2
+    // times the Hann window's average of 0.5.
+    magnitudeScale = 4.f / (float) fftSize;
+    analysedSampleRate = sampleRate;
+}
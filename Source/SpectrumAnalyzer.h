@@ -0,0 +1,131 @@
+/*
+  ==============================================================================
+
+    This file contains the spectrum analyzer. The audio thread hands it the
+    signal before and after the EQ, and a background thread turns that into
+    log-frequency spectra for the editor to draw.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    The analyzer only runs while something is watching. Until setActive(true)
+    the audio thread's push calls return straight away and no analysis
+    happens at all.
+
+    While it's active, the audio thread mixes each block down to mono and
+    writes it into a single-producer single-consumer FIFO (one for the
+    input, one for the output). That's all it does: no locks, no
+    allocation, and if the FIFO is full the samples are dropped rather than
+    waiting. A background thread shared by every instance reads the FIFOs,
+    runs Hann-windowed FFTs with 75% overlap, and gathers the FFT bins into
+    numBins bands spaced evenly on a log scale from 20 Hz to 20 kHz. Each
+    band shows its loudest FFT bin, and falls back slowly so the display
+    doesn't flicker.
+*/
+class SpectrumAnalyzer  : private juce::TimeSliceClient
+{
+public:
+    static constexpr int numBins = 256;
+    static constexpr float minFrequency = 20.f;
+    static constexpr float maxFrequency = 20000.f;
+
+    // Levels are in dB, clipped to this floor
+    static constexpr float minDecibels = -100.f;
+
+    struct Spectrum
+    {
+        std::array<float, numBins> input;
+        std::array<float, numBins> output;
+    };
+
+    SpectrumAnalyzer();
+    ~SpectrumAnalyzer() override;
+
+    // Call from prepareToPlay
+    void prepare(double sampleRate);
+
+    // Starts and stops the analysis. Call from the message thread, e.g. when
+    // the editor opens and closes.
+    void setActive(bool shouldBeActive);
+    bool isActive() const noexcept                      { return active.load(std::memory_order_relaxed); }
+
+    // Called from the audio thread. Wait-free.
+    void pushInput(const juce::dsp::AudioBlock<const float>& block) noexcept    { push(inputChannel, block); }
+    void pushOutput(const juce::dsp::AudioBlock<const float>& block) noexcept   { push(outputChannel, block); }
+    void pushInput(const juce::dsp::AudioBlock<const double>& block) noexcept   { push(inputChannel, block); }
+    void pushOutput(const juce::dsp::AudioBlock<const double>& block) noexcept  { push(outputChannel, block); }
+
+    // Copies out the newest spectra if they've changed since lastVersion,
+    // and updates lastVersion. Call from the message thread.
+    bool getLatestSpectrum(Spectrum& destination, juce::uint32& lastVersion) const;
+
+    // The centre frequency of a band
+    static float getBinFrequency(int bin) noexcept;
+
+private:
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = fftSize / 4;
+    static constexpr int fifoSize = 1 << 15;
+
+    // The shared thread the analysis runs on
+    struct AnalysisThread  : public juce::TimeSliceThread
+    {
+        AnalysisThread() : juce::TimeSliceThread("SimpleEQ Spectrum Analyzer") { startThread(); }
+        ~AnalysisThread() override { stopThread(1000); }
+    };
+
+    // One of the two signals being analysed
+    struct Channel
+    {
+        Channel();
+
+        juce::AbstractFifo fifo { fifoSize };
+        std::vector<float> fifoBuffer;
+
+        // The last fftSize samples read out of the FIFO
+        std::vector<float> frame;
+
+        std::array<float, numBins> levels;
+    };
+
+    template <typename SampleType>
+    void push(Channel& channel, const juce::dsp::AudioBlock<const SampleType>& block) noexcept;
+
+    int useTimeSlice() override;
+    bool analyse(Channel& channel);
+    void updateBinRanges(double sampleRate);
+
+    Channel inputChannel, outputChannel;
+
+    std::atomic<bool> active { false };
+    std::atomic<bool> needsFlush { false };
+    std::atomic<double> currentSampleRate { 0.0 };
+
+    // Only touched on the analysis thread
+    juce::dsp::FFT fft { fftOrder };
+    juce::dsp::WindowingFunction<float> window { (size_t) fftSize, juce::dsp::WindowingFunction<float>::hann, false };
+    std::vector<float> fftData;
+    double analysedSampleRate = 0.0;
+
+    // The range of FFT bins gathered into each band. Bands narrower than an
+    // FFT bin read a single bin, so there are no holes at the low end.
+    std::array<int, numBins> firstFftBin {}, lastFftBin {};
+    float magnitudeScale = 1.f;
+
+    // The newest spectra, handed from the analysis thread to the message
+    // thread. The audio thread never touches these.
+    juce::CriticalSection spectrumLock;
+    Spectrum latestSpectrum;
+    juce::uint32 version = 0;
+
+    juce::SharedResourcePointer<AnalysisThread> analysisThread;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumAnalyzer)
+};
@@ -0,0 +1,181 @@
+/*
+  ==============================================================================
+
+    This file contains the spectrum display, the editor component that draws
+    the analyzer's input and output spectra and the EQ's response curve.
+
+  ==============================================================================
+*/
+
+#include "SpectrumDisplay.h"
+
+namespace
+{
+    // The level range shown, top to bottom
+    constexpr float maxDisplayDecibels = 0.f;
+    constexpr float minDisplayDecibels = -90.f;
+
+    // The response curve has its own scale, with 0 dB across the middle
+    constexpr float responseRangeDecibels = 24.f;
+
+    // Never more than one point per this many pixels
+    constexpr float pixelsPerPoint = 2.f;
+}
+
+SpectrumDisplay::SpectrumDisplay(SimpleEQAudioProcessor& processor)
+    : audioProcessor(processor),
+      spectrumAnalyzer(processor.getSpectrumAnalyzer())
+{
+    spectrum.input.fill(SpectrumAnalyzer::minDecibels);
+    spectrum.output.fill(SpectrumAnalyzer::minDecibels);
+
+    setOpaque(true);
+
+    spectrumAnalyzer.setActive(true);
+    startTimerHz(frameRate);
+}
+
+SpectrumDisplay::~SpectrumDisplay()
+{
+    // Nothing is watching any more, so the analysis can stop
+    spectrumAnalyzer.setActive(false);
+}
+
+float SpectrumDisplay::getXForFrequency(float frequency) const noexcept
+{
+    auto proportion = std::log(frequency / SpectrumAnalyzer::minFrequency)
+                    / std::log(SpectrumAnalyzer::maxFrequency / SpectrumAnalyzer::minFrequency);
+
+    return proportion * (float) getWidth();
+}
+
+float SpectrumDisplay::getYForDecibels(float decibels) const noexcept
+{
+    return juce::jmap(decibels, minDisplayDecibels, maxDisplayDecibels, (float) getHeight(), 0.f);
+}
+
+float SpectrumDisplay::getYForResponseDecibels(float decibels) const noexcept
+{
+    return juce::jmap(decibels, -responseRangeDecibels, responseRangeDecibels, (float) getHeight(), 0.f);
+}
+
+void SpectrumDisplay::timerCallback()
+{
+    auto needsRepaint = false;
+
+    if (spectrumAnalyzer.getLatestSpectrum(spectrum, spectrumVersion))
+    {
+        updatePaths();
+        needsRepaint = true;
+    }
+
+    // Cheap when nothing's moved: the curve compares the settings band by
+    // band and leaves its version alone
+    if (audioProcessor.getResponseCurve().getVersion() != responseVersion)
+    {
+        updateResponsePath();
+        needsRepaint = true;
+    }
+
+    if (needsRepaint)
+        repaint();
+}
+
+void SpectrumDisplay::resized()
+{
+    updatePaths();
+    updateResponsePath();
+}
+
+void SpectrumDisplay::updateResponsePath()
+{
+    const auto& curve = audioProcessor.getResponseCurve();
+    responseVersion = curve.getVersion();
+
+    auto numPoints = curve.getNumPoints();
+    auto maxPoints = juce::jmax(2, (int) ((float) getWidth() / pixelsPerPoint));
+    auto step = juce::jmax(1, (numPoints + maxPoints - 1) / maxPoints);
+    auto bottom = (float) getHeight();
+
+    const auto* frequencies = curve.getFrequencies();
+    const auto* decibels = curve.getMagnitudesDecibels();
+
+    responsePath.clear();
+    responsePath.preallocateSpace(3 * (numPoints / step + 2));
+
+    auto pointAt = [&](int i)
+    {
+        return juce::Point<float>(getXForFrequency(frequencies[i]),
+                                  juce::jlimit(0.f, bottom, getYForResponseDecibels(decibels[i])));
+    };
+
+    responsePath.startNewSubPath(pointAt(0));
+
+    for (int i = step; i < numPoints; i += step)
+        responsePath.lineTo(pointAt(i));
+
+    // Always finish on the last point so the curve reaches the right edge
+    if ((numPoints - 1) % step != 0)
+        responsePath.lineTo(pointAt(numPoints - 1));
+}
+
+void SpectrumDisplay::updatePaths()
+{
+    // Skip bands when there are more of them than room to draw them
+    auto maxPoints = juce::jmax(2, (int) ((float) getWidth() / pixelsPerPoint));
+    auto step = juce::jmax(1, (SpectrumAnalyzer::numBins + maxPoints - 1) / maxPoints);
+    auto bottom = (float) getHeight();
+
+    auto makePath = [this, step, bottom](juce::Path& path, const std::array<float, SpectrumAnalyzer::numBins>& levels, bool closed)
+    {
+        path.clear();
+        path.preallocateSpace(3 * (SpectrumAnalyzer::numBins / step + 4));
+
+        auto firstX = getXForFrequency(SpectrumAnalyzer::getBinFrequency(0));
+
+        if (closed)
+            path.startNewSubPath(firstX, bottom);
+
+        for (int bin = 0; bin < SpectrumAnalyzer::numBins; bin += step)
+        {
+            auto point = juce::Point<float>(getXForFrequency(SpectrumAnalyzer::getBinFrequency(bin)),
+                                            juce::jlimit(0.f, bottom, getYForDecibels(levels[(size_t) bin])));
+
+            if (bin == 0 && ! closed)
+                path.startNewSubPath(point);
+            else
+                path.lineTo(point);
+        }
+
+        if (closed)
+        {
+            path.lineTo((float) getWidth(), bottom);
+            path.closeSubPath();
+        }
+    };
+
+    makePath(inputPath, spectrum.input, true);
+    makePath(outputPath, spectrum.output, false);
+}
+
+void SpectrumDisplay::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::black);
+
+    // Decade lines at 100 Hz, 1 kHz and 10 kHz
+    g.setColour(juce::Colours::white.withAlpha(0.15f));
+
+    for (auto frequency : { 100.f, 1000.f, 10000.f })
+        g.drawVerticalLine(juce::roundToInt(getXForFrequency(frequency)), 0.f, (float) getHeight());
+
+    // The input filled in behind, the output drawn over it as a line
+    g.setColour(juce::Colours::grey.withAlpha(0.4f));
+    g.fillPath(inputPath);
+
+    g.setColour(juce::Colours::orange);
+    g.strokePath(outputPath, juce::PathStrokeType(1.5f));
+
+    // The response curve on top, on its own +/- 24 dB scale
+    g.setColour(juce::Colours::white);
+    g.strokePath(responsePath, juce::PathStrokeType(2.f));
+}
@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    This file contains the spectrum display, the editor component that draws
+    the analyzer's input and output spectra and the EQ's response curve.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+//==============================================================================
+/**
+    Switches the analyzer on for as long as it exists, and draws the newest
+    spectra at up to frameRate frames per second.
+
+    The paths are only rebuilt when the analyzer or the response curve has
+    something new or the component changes size, and they never have more
+    points than there's room for, so painting is just filling and stroking
+    three cached paths.
+*/
+class SpectrumDisplay  : public juce::Component,
+                         private juce::Timer
+{
+public:
+    static constexpr int frameRate = 30;
+
+    explicit SpectrumDisplay(SimpleEQAudioProcessor& processor);
+    ~SpectrumDisplay() override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+private:
+    void timerCallback() override;
+    void updatePaths();
+    void updateResponsePath();
+
+    float getXForFrequency(float frequency) const noexcept;
+    float getYForDecibels(float decibels) const noexcept;
+    float getYForResponseDecibels(float decibels) const noexcept;
+
+    SimpleEQAudioProcessor& audioProcessor;
+    SpectrumAnalyzer& spectrumAnalyzer;
+
+    SpectrumAnalyzer::Spectrum spectrum;
+    juce::uint32 spectrumVersion = 0;
+
+    // The response curve version responsePath was built from
+    juce::uint32 responseVersion = 0;
+
+    juce::Path inputPath, outputPath, responsePath;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumDisplay)
+};
@@ -0,0 +1,178 @@
+/*
+  ==============================================================================
+
+    This file contains the stage elider. It works out which bands are
+    doing nothing audible so the filter engines can skip them, and
+    crossfades bands in and out so skipping never clicks.
+
+  ==============================================================================
+*/
+
+#include "StageElider.h"
+
+namespace
+{
+    // Half the peak gain parameter's step, so only 0 dB counts
+    constexpr float neutralPeakGain = 0.05f;
+
+    constexpr double fadeSeconds = 0.005;
+}
+
+bool StageElider::isNeutral(ChainStage stage, const SimpleEQSettings& settings) noexcept
+{
+    switch (stage)
+    {
+        case PeakStage:     return std::abs(settings.peakGain) < neutralPeakGain && ! settings.dynamic.enabled;
+        case LowCutStage:
+        case HighCutStage:
+        case NumChainStages: break;
+    }
+
+    return false;
+}
+
+int StageElider::getNumBiquads(ChainStage stage, const SimpleEQSettings& settings) noexcept
+{
+    switch (stage)
+    {
+        case LowCutStage:   return settings.lowCutSlope + 1;
+        case PeakStage:     return 1;
+        case HighCutStage:  return settings.highCutSlope + 1;
+        case NumChainStages: break;
+    }
+
+    return 0;
+}
+
+void StageElider::prepare(double sampleRate, int numChannels, int maximumBlockSize, bool useDoublePrecision)
+{
+    fadeLength = juce::jmax(1, juce::roundToInt(sampleRate * fadeSeconds));
+
+    // Only the precision in use gets a real buffer
+    auto bufferChannels = juce::jmax(1, numChannels);
+    auto bufferSamples = juce::jmax(1, maximumBlockSize);
+
+    dryBuffer.setSize(bufferChannels, useDoublePrecision ? 1 : bufferSamples);
+    doubleDryBuffer.setSize(bufferChannels, useDoublePrecision ? bufferSamples : 1);
+}
+
+void StageElider::reset(const SimpleEQSettings& settings) noexcept
+{
+    for (int i = 0; i < NumChainStages; ++i)
+    {
+        auto& stage = stages[(size_t) i];
+
+        stage.shouldRun = ! enabled || ! isNeutral(static_cast<ChainStage>(i), settings);
+        stage.isRunning = stage.shouldRun;
+        stage.fadePosition = stage.shouldRun ? fadeLength : 0;
+    }
+}
+
+int StageElider::update(const SimpleEQSettings& settings) noexcept
+{
+    int startedStages = 0;
+
+    for (int i = 0; i < NumChainStages; ++i)
+    {
+        auto& stage = stages[(size_t) i];
+        stage.shouldRun = ! enabled || ! isNeutral(static_cast<ChainStage>(i), settings);
+
+        // A band that's fading out can turn round part way; it's still
+        // running, so its state carries on from where it was
+        if (stage.shouldRun && ! stage.isRunning)
+        {
+            stage.isRunning = true;
+            stage.fadePosition = 0;
+            startedStages |= 1 << i;
+        }
+    }
+
+    return startedStages;
+}
+
+bool StageElider::isStageFading(ChainStage stage) const noexcept
+{
+    const auto& s = stages[(size_t) stage];
+    return s.isRunning && s.fadePosition != (s.shouldRun ? fadeLength : 0);
+}
+
+bool StageElider::isFading() const noexcept
+{
+    for (int i = 0; i < NumChainStages; ++i)
+        if (isStageFading(static_cast<ChainStage>(i)))
+            return true;
+
+    return false;
+}
+
+int StageElider::getNumElidedBiquads(const SimpleEQSettings& settings) const noexcept
+{
+    int numElided = 0;
+
+    for (int i = 0; i < NumChainStages; ++i)
+        if (! stages[(size_t) i].isRunning)
+            numElided += getNumBiquads(static_cast<ChainStage>(i), settings);
+
+    return numElided;
+}
+
+template <typename SampleType>
+juce::dsp::AudioBlock<SampleType> StageElider::keepDryInput(const juce::dsp::AudioBlock<SampleType>& block) noexcept
+{
+    auto& buffer = getDryBuffer(SampleType());
+
+    // The buffer is sized in prepare, so this only fails if the host sends
+    // a bigger block than it promised. The fade is skipped if it does.
+    if (block.getNumChannels() > (size_t) buffer.getNumChannels()
+         || block.getNumSamples() > (size_t) buffer.getNumSamples())
+    {
+        jassertfalse;
+        return {};
+    }
+
+    auto dry = juce::dsp::AudioBlock<SampleType>(buffer)
+                   .getSubsetChannelBlock(0, block.getNumChannels())
+                   .getSubBlock(0, block.getNumSamples());
+
+    dry.copyFrom(block);
+    return dry;
+}
+
+template <typename SampleType>
+void StageElider::crossfade(const juce::dsp::AudioBlock<SampleType>& block, const juce::dsp::AudioBlock<SampleType>& dry, ChainStage stage) noexcept
+{
+    auto& s = stages[(size_t) stage];
+    auto numSamples = (int) block.getNumSamples();
+    auto step = s.shouldRun ? 1 : -1;
+
+    if (dry.getNumSamples() == block.getNumSamples())
+    {
+        auto gainPerStep = SampleType(1) / (SampleType) fadeLength;
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        {
+            auto* wet = block.getChannelPointer(channel);
+            auto* input = dry.getChannelPointer(channel);
+            auto position = s.fadePosition;
+
+            // Once the fade has finished the position stops moving, so the
+            // rest of the block is all wet or all dry
+            for (int i = 0; i < numSamples; ++i)
+            {
+                position = juce::jlimit(0, fadeLength, position + step);
+                auto gain = (SampleType) position * gainPerStep;
+                wet[i] = input[i] + gain * (wet[i] - input[i]);
+            }
+        }
+    }
+
+    s.fadePosition = juce::jlimit(0, fadeLength, s.fadePosition + step * numSamples);
+
+    if (! s.shouldRun && s.fadePosition == 0)
+        s.isRunning = false;
+}
+
+template juce::dsp::AudioBlock<float> StageElider::keepDryInput(const juce::dsp::AudioBlock<float>&) noexcept;
+template juce::dsp::AudioBlock<double> StageElider::keepDryInput(const juce::dsp::AudioBlock<double>&) noexcept;
+template void StageElider::crossfade(const juce::dsp::AudioBlock<float>&, const juce::dsp::AudioBlock<float>&, ChainStage) noexcept;
+template void StageElider::crossfade(const juce::dsp::AudioBlock<double>&, const juce::dsp::AudioBlock<double>&, ChainStage) noexcept;
@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+    This file contains the stage elider. It works out which bands are
+    doing nothing audible so the filter engines can skip them, and
+    crossfades bands in and out so skipping never clicks.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SimpleEQSettings.h"
+
+//==============================================================================
+/**
+    A band is neutral when its design can't be heard, which means the peak
+    at 0 dB with its dynamics off. That's the peak's default, so a freshly
+    loaded instance doesn't run it.
+
+    The cuts are never neutral. Even parked at the ends of their ranges
+    they're 3 dB down at 20 Hz or 20 kHz, and more beyond, with a depth
+    that depends on the slope and sample rate, so skipping them would
+    change the sound.
+
+    A neutral band stops running. When it becomes active again its filter
+    state has to start from silence, which on its own would click, so the
+    band fades in from its dry input over a few milliseconds. Bands going
+    neutral fade out the same way before they stop. During a fade the
+    processor runs the bands one at a time so each band's input can be kept
+    for the crossfade; the rest of the time the engines run every running
+    band in one go as usual.
+
+    Everything here runs on the audio thread and nothing allocates after
+    prepare.
+*/
+class StageElider
+{
+public:
+    StageElider() = default;
+
+    static bool isNeutral(ChainStage stage, const SimpleEQSettings& settings) noexcept;
+
+    // Number of biquads the band uses with these settings
+    static int getNumBiquads(ChainStage stage, const SimpleEQSettings& settings) noexcept;
+
+    // Allocates the buffer that holds a band's input during a fade, in
+    // double if that's what the processor is running in. Call from
+    // prepareToPlay.
+    void prepare(double sampleRate, int numChannels, int maximumBlockSize, bool useDoublePrecision = false);
+
+    // With elision off every band always runs
+    void setEnabled(bool shouldBeEnabled) noexcept    { enabled = shouldBeEnabled; }
+    bool isEnabled() const noexcept                   { return enabled; }
+
+    // Jumps straight to the right set of running bands for these settings,
+    // with no fades
+    void reset(const SimpleEQSettings& settings) noexcept;
+
+    // Decides which bands should run with these settings and starts any fades
+    // that are needed. Returns a bit (1 << stage) for every band that has
+    // just started running; clear those bands' filter state before
+    // processing with them.
+    int update(const SimpleEQSettings& settings) noexcept;
+
+    bool isRunning(ChainStage stage) const noexcept   { return stages[(size_t) stage].isRunning; }
+    bool isFading() const noexcept;
+
+    // Biquads skipped out of those the settings call for
+    int getNumElidedBiquads(const SimpleEQSettings& settings) const noexcept;
+
+    // Runs the running bands over the block one at a time, crossfading the
+    // ones that are fading. processStage(block, stage) should filter the block
+    // in place with just that band.
+    template <typename SampleType, typename ProcessStage>
+    void processStages(const juce::dsp::AudioBlock<SampleType>& block, ProcessStage&& processStage) noexcept
+    {
+        for (int i = 0; i < NumChainStages; ++i)
+        {
+            auto stage = static_cast<ChainStage>(i);
+
+            if (! isRunning(stage))
+                continue;
+
+            if (! isStageFading(stage))
+            {
+                processStage(block, stage);
+                continue;
+            }
+
+            auto dry = keepDryInput(block);
+            processStage(block, stage);
+            crossfade(block, dry, stage);
+        }
+    }
+
+private:
+    struct Stage
+    {
+        bool isRunning = false;
+        bool shouldRun = false;
+
+        // How far through the fade the band is, from 0 (dry) to fadeLength
+        // (fully filtered)
+        int fadePosition = 0;
+    };
+
+    bool isStageFading(ChainStage stage) const noexcept;
+
+    template <typename SampleType>
+    juce::dsp::AudioBlock<SampleType> keepDryInput(const juce::dsp::AudioBlock<SampleType>& block) noexcept;
+
+    template <typename SampleType>
+    void crossfade(const juce::dsp::AudioBlock<SampleType>& block, const juce::dsp::AudioBlock<SampleType>& dry, ChainStage stage) noexcept;
+
+    juce::AudioBuffer<float>& getDryBuffer(float) noexcept      { return dryBuffer; }
+    juce::AudioBuffer<double>& getDryBuffer(double) noexcept    { return doubleDryBuffer; }
+
+    std::array<Stage, NumChainStages> stages;
+    bool enabled = true;
+
+    int fadeLength = 1;
+    juce::AudioBuffer<float> dryBuffer;
+    juce::AudioBuffer<double> doubleDryBuffer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StageElider)
+};